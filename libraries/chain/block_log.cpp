@@ -287,6 +287,71 @@ namespace steem { namespace chain {
       FC_LOG_AND_RETHROW()
    }
 
+   std::vector< char > block_log::read_block_data_by_num( uint32_t block_num )const
+   {
+      try
+      {
+         scoped_lock lock( my->mtx, defer_lock );
+
+         if( my->use_locking )
+         {
+            lock.lock();;
+         }
+
+         std::vector< char > data;
+         uint64_t pos = get_block_pos_helper( block_num );
+         if( pos == npos )
+            return data;
+
+         // Each block is followed by its 8 byte position, so the block ends where that trailer starts
+         uint64_t end_pos;
+         if( block_num < protocol::block_header::num_from_id( my->head_id ) )
+         {
+            end_pos = get_block_pos_helper( block_num + 1 ) - sizeof( uint64_t );
+            my->check_block_read();
+         }
+         else
+         {
+            my->check_block_read();
+            my->block_stream.seekg( -sizeof( uint64_t ), std::ios::end );
+            end_pos = my->block_stream.tellg();
+         }
+
+         FC_ASSERT( end_pos > pos, "Corrupt block log entry.", ("block_num", block_num)("pos", pos)("end_pos", end_pos) );
+         data.resize( end_pos - pos );
+         my->block_stream.seekg( pos );
+         my->block_stream.read( data.data(), data.size() );
+         return data;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   std::vector< char > block_log::read_block_data_slice( uint32_t block_num, uint64_t offset, uint64_t size )const
+   {
+      try
+      {
+         scoped_lock lock( my->mtx, defer_lock );
+
+         if( my->use_locking )
+         {
+            lock.lock();;
+         }
+
+         std::vector< char > data;
+         uint64_t pos = get_block_pos_helper( block_num );
+         if( pos != npos )
+         {
+            my->check_block_read();
+
+            data.resize( size );
+            my->block_stream.seekg( pos + offset );
+            my->block_stream.read( data.data(), size );
+         }
+         return data;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
    uint64_t block_log::get_block_pos( uint32_t block_num ) const
    {
       scoped_lock lock( my->mtx, defer_lock );
@@ -1,4 +1,5 @@
 #include <steem/protocol/steem_operations.hpp>
+#include <steem/protocol/transaction_util.hpp>
 
 #include <steem/chain/block_summary_object.hpp>
 #include <steem/chain/compound.hpp>
@@ -14,6 +15,7 @@
 #include <steem/chain/steem_evaluator.hpp>
 #include <steem/chain/steem_objects.hpp>
 #include <steem/chain/transaction_object.hpp>
+#include <steem/chain/transaction_prevalidator.hpp>
 #include <steem/chain/shared_db_merkle.hpp>
 #include <steem/chain/operation_notification.hpp>
 #include <steem/chain/witness_schedule.hpp>
@@ -109,6 +111,12 @@ void database::open( const open_args& args )
       initialize_indexes();
       initialize_evaluators();
 
+      with_write_lock( [&]()
+      {
+         for( chainbase::abstract_index* idx : get_abstract_index_cntr() )
+            idx->enable_digest( args.enable_state_digest );
+      });
+
       if( !find< dynamic_global_property_object >() )
          with_write_lock( [&]()
          {
@@ -117,6 +125,11 @@ void database::open( const open_args& args )
 
       _benchmark_dumper.set_enabled( args.benchmark_is_enabled );
 
+      if( args.parallel_validation_threads )
+         _transaction_prevalidator.reset( new transaction_prevalidator( args.parallel_validation_threads ) );
+      else
+         _transaction_prevalidator.reset();
+
       _block_log.open( args.data_dir / "block_log" );
 
       auto log_head = _block_log.head();
@@ -356,6 +369,41 @@ optional<signed_block> database::fetch_block_by_number( uint32_t block_num )cons
    return b;
 } FC_LOG_AND_RETHROW() }
 
+std::vector<char> database::fetch_block_data_by_number( uint32_t block_num )const
+{ try {
+   auto results = _fork_db.fetch_block_by_number( block_num );
+   if( results.size() == 1 )
+      return fc::raw::pack_to_vector( results[0]->data );
+
+   return _block_log.read_block_data_by_num( block_num );
+} FC_LOG_AND_RETHROW() }
+
+optional<signed_transaction> database::fetch_transaction_by_location( uint32_t block_num, uint32_t trx_in_block, uint32_t trx_offset, uint32_t trx_size )const
+{ try {
+   optional< signed_transaction > trx;
+
+   auto results = _fork_db.fetch_block_by_number( block_num );
+   if( results.size() == 1 )
+   {
+      if( results[0]->data.transactions.size() > trx_in_block )
+         trx = results[0]->data.transactions[ trx_in_block ];
+   }
+   else if( trx_size > 0 )
+   {
+      auto data = _block_log.read_block_data_slice( block_num, trx_offset, trx_size );
+      if( data.size() )
+         trx = fc::raw::unpack_from_vector< signed_transaction >( data );
+   }
+   else
+   {
+      auto b = _block_log.read_block_by_num( block_num );
+      if( b.valid() && b->transactions.size() > trx_in_block )
+         trx = b->transactions[ trx_in_block ];
+   }
+
+   return trx;
+} FC_LOG_AND_RETHROW() }
+
 const signed_transaction database::get_recent_transaction( const transaction_id_type& trx_id ) const
 { try {
    auto& index = get_index<transaction_index>().indices().get<by_trx_id>();
@@ -455,22 +503,22 @@ void database::foreach_operation(std::function<bool(const signed_block_header&,c
 
 const witness_object& database::get_witness( const account_name_type& name ) const
 { try {
-   return get< witness_object, by_name >( name );
+   return get< witness_object, by_name_lookup >( name );
 } FC_CAPTURE_AND_RETHROW( (name) ) }
 
 const witness_object* database::find_witness( const account_name_type& name ) const
 {
-   return find< witness_object, by_name >( name );
+   return find< witness_object, by_name_lookup >( name );
 }
 
 const account_object& database::get_account( const account_name_type& name )const
 { try {
-   return get< account_object, by_name >( name );
+   return get< account_object, by_name_lookup >( name );
 } FC_CAPTURE_AND_RETHROW( (name) ) }
 
 const account_object* database::find_account( const account_name_type& name )const
 {
-   return find< account_object, by_name >( name );
+   return find< account_object, by_name_lookup >( name );
 }
 
 const comment_object& database::get_comment( const account_name_type& author, const shared_string& permlink )const
@@ -639,6 +687,41 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
    return result;
 }
 
+bool database::push_blocks( const vector< const signed_block* >& blocks, vector< fc::optional< fc::exception > >& results, uint32_t skip )
+{
+   FC_ASSERT( results.size() == blocks.size() );
+
+   bool result = true;
+
+   for( size_t i = 0; i < blocks.size(); ++i )
+   {
+      // Blocks that failed before being pushed already carry their exception
+      if( results[i] )
+      {
+         result = false;
+         continue;
+      }
+
+      try
+      {
+         push_block( *blocks[i], skip );
+      }
+      catch( const fc::exception& e )
+      {
+         results[i] = e;
+         result = false;
+      }
+      catch( ... )
+      {
+         results[i] = fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unexpected exception while pushing block." ),
+                                               std::current_exception() );
+         result = false;
+      }
+   }
+
+   return result;
+}
+
 void database::_maybe_warn_multiple_production( uint32_t height )const
 {
    auto blocks = _fork_db.fetch_block_by_number( height );
@@ -753,17 +836,22 @@ bool database::_push_block(const signed_block& new_block)
  * queues.
  */
 void database::push_transaction( const signed_transaction& trx, uint32_t skip )
+{
+   push_transaction( pending_transaction( trx ), skip );
+}
+
+void database::push_transaction( const pending_transaction& ptrx, uint32_t skip )
 {
    try
    {
       try
       {
-         FC_ASSERT( fc::raw::pack_size(trx) <= (get_dynamic_global_properties().maximum_block_size - 256) );
+         FC_ASSERT( ptrx.packed_size <= (get_dynamic_global_properties().maximum_block_size - 256) );
          set_producing( true );
          detail::with_skip_flags( *this, skip,
             [&]()
             {
-               _push_transaction( trx );
+               _push_transaction( ptrx );
             });
          set_producing( false );
       }
@@ -773,10 +861,20 @@ void database::push_transaction( const signed_transaction& trx, uint32_t skip )
          throw;
       }
    }
-   FC_CAPTURE_AND_RETHROW( (trx) )
+   FC_CAPTURE_AND_RETHROW( (ptrx.trx) )
+}
+
+void database::precheck_transaction( const pending_transaction& ptrx )const
+{
+   try
+   {
+      FC_ASSERT( ptrx.packed_size <= (get_dynamic_global_properties().maximum_block_size - 256) );
+      validate_transaction_state( ptrx.trx, ptrx.id, get_node_properties().skip_flags );
+   }
+   FC_CAPTURE_AND_RETHROW( (ptrx.trx) )
 }
 
-void database::_push_transaction( const signed_transaction& trx )
+void database::_push_transaction( const pending_transaction& trx )
 {
    // If this is the first transaction pushed after applying a block, start a new undo session.
    // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
@@ -789,8 +887,10 @@ void database::_push_transaction( const signed_transaction& trx )
    // apply the changes.
 
    auto temp_session = start_undo_session();
-   _apply_transaction( trx );
+   _apply_transaction( trx.trx, &trx );
    _pending_tx.push_back( trx );
+   _pending_tx_size += trx.packed_size;
+   _pending_tx_skip |= get_node_properties().skip_flags;
 
    notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
@@ -867,59 +967,82 @@ signed_block database::_generate_block(
    size_t total_block_size = fc::raw::pack_size( pending_block ) + 4;
    auto maximum_block_size = get_dynamic_global_properties().maximum_block_size; //STEEM_MAX_BLOCK_SIZE;
 
-   //
-   // The following code throws away existing pending_tx_session and
-   // rebuilds it by re-applying pending transactions.
-   //
-   // This rebuild is necessary because pending transactions' validity
-   // and semantics may have changed since they were received, because
-   // time-based semantics are evaluated based on the current block
-   // time.  These changes can only be reflected in the database when
-   // the value of the "when" variable is known, which means we need to
-   // re-apply pending transactions in this method.
-   //
-   _pending_tx_session.reset();
-   _pending_tx_session = start_undo_session();
+   // Every pending transaction has already been applied, in order, to _pending_tx_session on top of
+   // the head block state. If none of them expires before this block and they all fit, replaying them
+   // would rebuild that same state, so the pending list is taken as the block's transactions as is.
+   // This only holds when they were checked at least as strictly as this slot checks them.
+   const auto& pending_by_exp = _pending_tx.get< by_expiration >();
+   bool pending_is_candidate = ( _pending_tx.empty() || _pending_tx_session.valid() )
+      && ( _pending_tx_skip & ~skip ) == 0
+      && ( pending_by_exp.empty() || pending_by_exp.begin()->expiration() >= when )
+      && total_block_size + _pending_tx_size < maximum_block_size;
 
-   uint64_t postponed_tx_count = 0;
-   // pop pending state (reset to head block state)
-   for( const signed_transaction& tx : _pending_tx )
+   if( pending_is_candidate )
    {
-      // Only include transactions that have not expired yet for currently generating block,
-      // this should clear problem transactions and allow block production to continue
+      pending_block.transactions.reserve( _pending_tx.size() );
+      for( const pending_transaction& ptx : _pending_tx )
+         pending_block.transactions.push_back( ptx.trx );
+   }
+   else
+   {
+      //
+      // The following code throws away existing pending_tx_session and
+      // rebuilds it by re-applying pending transactions.
+      //
+      // This rebuild is necessary because pending transactions' validity
+      // and semantics may have changed since they were received, because
+      // time-based semantics are evaluated based on the current block
+      // time.  These changes can only be reflected in the database when
+      // the value of the "when" variable is known, which means we need to
+      // re-apply pending transactions in this method.
+      //
+      _pending_tx_session.reset();
+      _pending_tx_session = start_undo_session();
 
-      if( tx.expiration < when )
-         continue;
+      uint64_t postponed_tx_count = 0;
+      // pop pending state (reset to head block state)
+      // Pending transactions carry their id, packed size and signature keys from when they were
+      // pushed, so the replay below only repeats the state dependent checks.
+      for( const pending_transaction& ptx : _pending_tx )
+      {
+         const signed_transaction& tx = ptx.trx;
 
-      uint64_t new_total_size = total_block_size + fc::raw::pack_size( tx );
+         // Only include transactions that have not expired yet for currently generating block,
+         // this should clear problem transactions and allow block production to continue
 
-      // postpone transaction if it would make block too big
-      if( new_total_size >= maximum_block_size )
-      {
-         postponed_tx_count++;
-         continue;
-      }
+         if( tx.expiration < when )
+            continue;
 
-      try
-      {
-         auto temp_session = start_undo_session();
-         _apply_transaction( tx );
-         temp_session.squash();
+         uint64_t new_total_size = total_block_size + ptx.packed_size;
+
+         // postpone transaction if it would make block too big
+         if( new_total_size >= maximum_block_size )
+         {
+            postponed_tx_count++;
+            continue;
+         }
+
+         try
+         {
+            auto temp_session = start_undo_session();
+            _apply_transaction( tx, &ptx );
+            temp_session.squash();
 
-         total_block_size += fc::raw::pack_size( tx );
-         pending_block.transactions.push_back( tx );
+            total_block_size = new_total_size;
+            pending_block.transactions.push_back( tx );
+         }
+         catch ( const fc::exception& e )
+         {
+            // Do nothing, transaction will not be re-applied
+            //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
+            //wlog( "The transaction was ${t}", ("t", tx) );
+         }
       }
-      catch ( const fc::exception& e )
+      if( postponed_tx_count > 0 )
       {
-         // Do nothing, transaction will not be re-applied
-         //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-         //wlog( "The transaction was ${t}", ("t", tx) );
+         wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
       }
    }
-   if( postponed_tx_count > 0 )
-   {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
-   }
 
    _pending_tx_session.reset();
 
@@ -965,6 +1088,9 @@ void database::pop_block()
 
       _popped_tx.insert( _popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end() );
 
+      block_notification note( *head_block );
+      notify_post_pop_block( note );
+
    }
    FC_CAPTURE_AND_RETHROW()
 }
@@ -975,6 +1101,8 @@ void database::clear_pending()
    {
       assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
       _pending_tx.clear();
+      _pending_tx_size = 0;
+      _pending_tx_skip = 0;
       _pending_tx_session.reset();
    }
    FC_CAPTURE_AND_RETHROW()
@@ -1029,6 +1157,11 @@ void database::notify_post_apply_block( const block_notification& note )
    STEEM_TRY_NOTIFY( _post_apply_block_signal, note )
 }
 
+void database::notify_post_pop_block( const block_notification& note )
+{
+   STEEM_TRY_NOTIFY( _post_pop_block_signal, note )
+}
+
 void database::notify_pre_apply_transaction( const transaction_notification& note )
 {
    STEEM_TRY_NOTIFY( _pre_apply_transaction_signal, note )
@@ -1473,12 +1606,12 @@ void database::update_owner_authority( const account_object& account, const auth
       create< owner_authority_history_object >( [&]( owner_authority_history_object& hist )
       {
          hist.account = account.name;
-         hist.previous_owner_authority = get< account_authority_object, by_account >( account.name ).owner;
+         hist.previous_owner_authority = get< account_authority_object, by_account_lookup >( account.name ).owner;
          hist.last_valid_time = head_block_time();
       });
    }
 
-   modify( get< account_authority_object, by_account >( account.name ), [&]( account_authority_object& auth )
+   modify( get< account_authority_object, by_account_lookup >( account.name ), [&]( account_authority_object& auth )
    {
       auth.owner = owner_authority;
       auth.last_owner_update = head_block_time();
@@ -1653,7 +1786,8 @@ share_type database::pay_curators( const comment_object& c, share_type& max_rewa
          const auto& cvidx = get_index<comment_vote_index>().indices().get<by_comment_voter>();
          auto itr = cvidx.lower_bound( c.id );
 
-         std::set< const comment_vote_object*, cmp > proxy_set;
+         std::set< const comment_vote_object*, cmp, util::arena_allocator< const comment_vote_object* > > proxy_set(
+            cmp{}, util::arena_allocator< const comment_vote_object* >( _block_arena ) );
          while( itr != cvidx.end() && itr->comment == c.id )
          {
             proxy_set.insert( &( *itr ) );
@@ -1835,8 +1969,7 @@ void database::process_comment_cashout()
    util::comment_reward_context ctx;
    ctx.current_steem_price = get_feed_history().current_median_history;
 
-   vector< reward_fund_context > funds;
-   vector< share_type > steem_awarded;
+   util::arena_vector< reward_fund_context > funds( _block_arena );
    const auto& reward_idx = get_index< reward_fund_index, by_id >();
 
    // Decay recent rshares of each fund
@@ -2508,6 +2641,48 @@ void database::initialize_indexes()
    _plugin_index_signal();
 }
 
+util::state_digest database::get_state_digest()const
+{
+   util::state_digest result;
+   result.head_block_num = head_block_num();
+   result.head_block_id = head_block_id();
+   result.valid = true;
+
+   // Order by type id so the combined digest does not depend on the order indices were added in
+   std::vector< const chainbase::abstract_index* > indices( get_abstract_index_cntr().begin(), get_abstract_index_cntr().end() );
+   std::sort( indices.begin(), indices.end(), []( const chainbase::abstract_index* a, const chainbase::abstract_index* b )
+   {
+      return a->type_id() < b->type_id();
+   });
+
+   fc::sha256::encoder enc;
+   for( const chainbase::abstract_index* idx : indices )
+   {
+      util::index_state_digest d;
+      chainbase::index_digest digest = idx->digest();
+      d.type_id = idx->type_id();
+      d.name = idx->get_statistics( true )._value_type_name;
+      d.objects = idx->size();
+      d.valid = idx->digest_valid();
+      d.digest = fc::uint128( digest.hi, digest.lo );
+
+      // The history indices are in space 0 but only the account history plugin fills them
+      if( ( d.type_id >> 8 ) == 0 && d.type_id != operation_object_type && d.type_id != account_history_object_type )
+      {
+         result.valid = result.valid && d.valid;
+         fc::raw::pack( enc, d.type_id );
+         fc::raw::pack( enc, d.objects );
+         fc::raw::pack( enc, digest.lo );
+         fc::raw::pack( enc, digest.hi );
+      }
+
+      result.indices.push_back( std::move( d ) );
+   }
+
+   result.digest = enc.result();
+   return result;
+}
+
 const std::string& database::get_json_schema()const
 {
    return _json_schema;
@@ -2849,6 +3024,7 @@ void database::_apply_block( const signed_block& next_block )
    BOOST_SCOPE_EXIT( this_ )
    {
       this_->_currently_processing_block_id.reset();
+      this_->_block_arena.reset();
    } BOOST_SCOPE_EXIT_END
    _currently_processing_block_id = note.block_id;
 
@@ -2948,7 +3124,14 @@ void database::_apply_block( const signed_block& next_block )
       );
    }
 
-   for( const auto& trx : next_block.transactions )
+   const bool check_operations = !( skip & skip_validate );
+   const bool check_signatures = !( skip & ( skip_transaction_signatures | skip_authority_check ) );
+   std::vector< prevalidated_transaction > prevalidated;
+
+   if( _transaction_prevalidator && next_block.transactions.size() > 1 && ( check_operations || check_signatures ) )
+      _transaction_prevalidator->prevalidate( next_block, get_chain_id(), check_operations, check_signatures, prevalidated );
+
+   for( size_t i = 0; i < next_block.transactions.size(); ++i )
    {
       /* We do not need to push the undo state for each transaction
        * because they either all apply and are valid or the
@@ -2956,7 +3139,13 @@ void database::_apply_block( const signed_block& next_block )
        * for transactions when validating broadcast transactions or
        * when building a block.
        */
-      apply_transaction( trx, skip );
+      const auto& trx = next_block.transactions[i];
+
+      if( prevalidated.size() && prevalidated[i].valid )
+         detail::with_skip_flags( *this, skip | skip_validate, [&]() { _apply_transaction( trx, prevalidated[i].pending.get() ); } );
+      else
+         apply_transaction( trx, skip );
+
       ++_current_trx_in_block;
    }
 
@@ -3064,7 +3253,7 @@ try {
 
    auto now = head_block_time();
    const witness_schedule_object& wso = get_witness_schedule_object();
-   vector<price> feeds; feeds.reserve( wso.num_scheduled_witnesses );
+   util::arena_vector< price > feeds( _block_arena ); feeds.reserve( wso.num_scheduled_witnesses );
    for( int i = 0; i < wso.num_scheduled_witnesses; i++ )
    {
       const auto& wit = get_witness( wso.current_shuffled_witnesses[i] );
@@ -3132,9 +3321,9 @@ void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
    detail::with_skip_flags( *this, skip, [&]() { _apply_transaction(trx); });
 }
 
-void database::_apply_transaction(const signed_transaction& trx)
+void database::_apply_transaction( const signed_transaction& trx, const pending_transaction* pending )
 { try {
-   transaction_notification note(trx);
+   transaction_notification note = pending ? transaction_notification( trx, pending->id ) : transaction_notification( trx );
    _current_trx_id = note.transaction_id;
    const transaction_id_type& trx_id = note.transaction_id;
    _current_virtual_op = 0;
@@ -3144,24 +3333,32 @@ void database::_apply_transaction(const signed_transaction& trx)
    if( !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
       trx.validate();
 
-   auto& trx_idx = get_index<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
-   // idump((trx_id)(skip&skip_transaction_dupe_check));
-   FC_ASSERT( (skip & skip_transaction_dupe_check) ||
-              trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
-              "Duplicate transaction check failed", ("trx_ix", trx_id) );
+
+   // The cheap checks against chain state come before the signature checks
+   validate_transaction_state( trx, trx_id, skip );
 
    if( !(skip & (skip_transaction_signatures | skip_authority_check) ) )
    {
-      auto get_active  = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).active ); };
-      auto get_owner   = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).owner );  };
-      auto get_posting = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).posting );  };
+      auto get_active  = [&]( const string& name ) { return authority( get< account_authority_object, by_account_lookup >( name ).active ); };
+      auto get_owner   = [&]( const string& name ) { return authority( get< account_authority_object, by_account_lookup >( name ).owner );  };
+      auto get_posting = [&]( const string& name ) { return authority( get< account_authority_object, by_account_lookup >( name ).posting );  };
 
       try
       {
-         trx.verify_authority( chain_id, get_active, get_owner, get_posting, STEEM_MAX_SIG_CHECK_DEPTH,
-            has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_AUTHORITY_MEMBERSHIP : 0,
-            has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_SIG_CHECK_ACCOUNTS : 0 );
+         if( pending != nullptr )
+         {
+            // Signature recovery does not depend on chain state, reuse the keys recovered when the transaction was first pushed
+            steem::protocol::verify_authority( trx.operations, pending->get_signature_keys( chain_id ), get_active, get_owner, get_posting, STEEM_MAX_SIG_CHECK_DEPTH,
+               has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_AUTHORITY_MEMBERSHIP : 0,
+               has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_SIG_CHECK_ACCOUNTS : 0 );
+         }
+         else
+         {
+            trx.verify_authority( chain_id, get_active, get_owner, get_posting, STEEM_MAX_SIG_CHECK_DEPTH,
+               has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_AUTHORITY_MEMBERSHIP : 0,
+               has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_SIG_CHECK_ACCOUNTS : 0 );
+         }
       }
       catch( protocol::tx_missing_active_auth& e )
       {
@@ -3170,28 +3367,6 @@ void database::_apply_transaction(const signed_transaction& trx)
       }
    }
 
-   //Skip all manner of expiration and TaPoS checking if we're on block 1; It's impossible that the transaction is
-   //expired, and TaPoS makes no sense as no blocks exist.
-   if( BOOST_LIKELY(head_block_num() > 0) )
-   {
-      if( !(skip & skip_tapos_check) )
-      {
-         const auto& tapos_block_summary = get< block_summary_object >( trx.ref_block_num );
-         //Verify TaPoS block summary has correct ID prefix, and that this block's time is not past the expiration
-         STEEM_ASSERT( trx.ref_block_prefix == tapos_block_summary.block_id._hash[1], transaction_tapos_exception,
-                    "", ("trx.ref_block_prefix", trx.ref_block_prefix)
-                    ("tapos_block_summary",tapos_block_summary.block_id._hash[1]));
-      }
-
-      fc::time_point_sec now = head_block_time();
-
-      STEEM_ASSERT( trx.expiration <= now + fc::seconds(STEEM_MAX_TIME_UNTIL_EXPIRATION), transaction_expiration_exception,
-                  "", ("trx.expiration",trx.expiration)("now",now)("max_til_exp",STEEM_MAX_TIME_UNTIL_EXPIRATION));
-      if( has_hardfork( STEEM_HARDFORK_0_9 ) ) // Simple solution to pending trx bug when now == trx.expiration
-         STEEM_ASSERT( now < trx.expiration, transaction_expiration_exception, "", ("now",now)("trx.exp",trx.expiration) );
-      STEEM_ASSERT( now <= trx.expiration, transaction_expiration_exception, "", ("now",now)("trx.exp",trx.expiration) );
-   }
-
    //Insert transaction into unique transactions database.
    if( !(skip & skip_transaction_dupe_check) )
    {
@@ -3218,6 +3393,36 @@ void database::_apply_transaction(const signed_transaction& trx)
 
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
 
+void database::validate_transaction_state( const signed_transaction& trx, const transaction_id_type& trx_id, uint32_t skip )const
+{
+   const auto& trx_idx = get_index<transaction_index>().indices().get<by_trx_id>();
+   // idump((trx_id)(skip&skip_transaction_dupe_check));
+   FC_ASSERT( (skip & skip_transaction_dupe_check) || trx_idx.find( trx_id ) == trx_idx.end(),
+              "Duplicate transaction check failed", ("trx_ix", trx_id) );
+
+   //Skip all manner of expiration and TaPoS checking if we're on block 1; It's impossible that the transaction is
+   //expired, and TaPoS makes no sense as no blocks exist.
+   if( BOOST_LIKELY(head_block_num() > 0) )
+   {
+      if( !(skip & skip_tapos_check) )
+      {
+         const auto& tapos_block_summary = get< block_summary_object >( trx.ref_block_num );
+         //Verify TaPoS block summary has correct ID prefix, and that this block's time is not past the expiration
+         STEEM_ASSERT( trx.ref_block_prefix == tapos_block_summary.block_id._hash[1], transaction_tapos_exception,
+                    "", ("trx.ref_block_prefix", trx.ref_block_prefix)
+                    ("tapos_block_summary",tapos_block_summary.block_id._hash[1]));
+      }
+
+      fc::time_point_sec now = head_block_time();
+
+      STEEM_ASSERT( trx.expiration <= now + fc::seconds(STEEM_MAX_TIME_UNTIL_EXPIRATION), transaction_expiration_exception,
+                  "", ("trx.expiration",trx.expiration)("now",now)("max_til_exp",STEEM_MAX_TIME_UNTIL_EXPIRATION));
+      if( has_hardfork( STEEM_HARDFORK_0_9 ) ) // Simple solution to pending trx bug when now == trx.expiration
+         STEEM_ASSERT( now < trx.expiration, transaction_expiration_exception, "", ("now",now)("trx.exp",trx.expiration) );
+      STEEM_ASSERT( now <= trx.expiration, transaction_expiration_exception, "", ("now",now)("trx.exp",trx.expiration) );
+   }
+}
+
 void database::apply_operation(const operation& op)
 {
    operation_notification note(op);
@@ -3350,6 +3555,12 @@ boost::signals2::connection database::add_post_apply_block_handler( const apply_
    return connect_impl(_post_apply_block_signal, func, plugin, group, "<-block");
 }
 
+boost::signals2::connection database::add_post_pop_block_handler( const apply_block_handler_t& func,
+   const abstract_plugin& plugin, int32_t group )
+{
+   return connect_impl(_post_pop_block_signal, func, plugin, group, "<-pop");
+}
+
 boost::signals2::connection database::add_irreversible_block_handler( const irreversible_block_handler_t& func,
    const abstract_plugin& plugin, int32_t group )
 {
@@ -3368,6 +3579,30 @@ boost::signals2::connection database::add_post_reindex_handler(const reindex_han
    return connect_impl(_post_reindex_signal, func, plugin, group, "<-reindex");
 }
 
+void database::precheck_block_signees( const vector< const signed_block* >& blocks )
+{
+   if( !_transaction_prevalidator || blocks.empty() )
+      return;
+
+   // The id and signee only depend on the header, a copy of it outlives the caller's blocks
+   for( const signed_block* b : blocks )
+   {
+      _transaction_prevalidator->post( [this, header = signed_block_header( *b )]()
+      {
+         // The block id covers the witness signature, so a key recovered for an id holds for any copy of the block
+         block_id_type id = header.id();
+         public_key_type signee = header.signee();
+
+         std::lock_guard< std::mutex > lock( _prechecked_block_signees_mutex );
+         _prechecked_block_signees[ id ] = signee;
+
+         // Ids start with the block number, drop the lowest blocks if the keys are never taken, e.g. after a fork
+         while( _prechecked_block_signees.size() > STEEM_MAX_PRECHECKED_BLOCK_SIGNEES )
+            _prechecked_block_signees.erase( _prechecked_block_signees.begin() );
+      });
+   }
+}
+
 const witness_object& database::validate_block_header( uint32_t skip, const signed_block& next_block )const
 { try {
    FC_ASSERT( head_block_id() == next_block.previous, "", ("head_block_id",head_block_id())("next.prev",next_block.previous) );
@@ -3375,7 +3610,24 @@ const witness_object& database::validate_block_header( uint32_t skip, const sign
    const witness_object& witness = get_witness( next_block.witness );
 
    if( !(skip&skip_witness_signature) )
-      FC_ASSERT( next_block.validate_signee( witness.signing_key ) );
+   {
+      optional< public_key_type > signee;
+      if( _transaction_prevalidator )
+      {
+         std::lock_guard< std::mutex > lock( _prechecked_block_signees_mutex );
+         auto itr = _prechecked_block_signees.find( next_block.id() );
+         if( itr != _prechecked_block_signees.end() )
+         {
+            signee = itr->second;
+            _prechecked_block_signees.erase( itr );
+         }
+      }
+
+      if( signee )
+         FC_ASSERT( *signee == witness.signing_key );
+      else
+         FC_ASSERT( next_block.validate_signee( witness.signing_key ) );
+   }
 
    if( !(skip&skip_witness_schedule_check) )
    {
@@ -3517,7 +3769,7 @@ void database::update_last_irreversible_block()
    {
       const witness_schedule_object& wso = get_witness_schedule_object();
 
-      vector< const witness_object* > wit_objs;
+      util::arena_vector< const witness_object* > wit_objs( _block_arena );
       wit_objs.reserve( wso.num_scheduled_witnesses );
       for( int i = 0; i < wso.num_scheduled_witnesses; i++ )
          wit_objs.push_back( &get_witness( wso.current_shuffled_witnesses[i] ) );
@@ -4456,7 +4708,7 @@ void database::apply_hardfork( uint32_t hardfork )
 
                update_owner_authority( *account, authority( 1, public_key_type( "STM7sw22HqsXbz7D2CmJfmMwt9rimtk518dRzsR1f8Cgw52dQR1pR" ), 1 ) );
 
-               modify( get< account_authority_object, by_account >( account->name ), [&]( account_authority_object& auth )
+               modify( get< account_authority_object, by_account_lookup >( account->name ), [&]( account_authority_object& auth )
                {
                   auth.active  = authority( 1, public_key_type( "STM7sw22HqsXbz7D2CmJfmMwt9rimtk518dRzsR1f8Cgw52dQR1pR" ), 1 );
                   auth.posting = authority( 1, public_key_type( "STM7sw22HqsXbz7D2CmJfmMwt9rimtk518dRzsR1f8Cgw52dQR1pR" ), 1 );
@@ -4499,19 +4751,19 @@ void database::apply_hardfork( uint32_t hardfork )
                }
             }
 
-            modify( get< account_authority_object, by_account >( STEEM_MINER_ACCOUNT ), [&]( account_authority_object& auth )
+            modify( get< account_authority_object, by_account_lookup >( STEEM_MINER_ACCOUNT ), [&]( account_authority_object& auth )
             {
                auth.posting = authority();
                auth.posting.weight_threshold = 1;
             });
 
-            modify( get< account_authority_object, by_account >( STEEM_NULL_ACCOUNT ), [&]( account_authority_object& auth )
+            modify( get< account_authority_object, by_account_lookup >( STEEM_NULL_ACCOUNT ), [&]( account_authority_object& auth )
             {
                auth.posting = authority();
                auth.posting.weight_threshold = 1;
             });
 
-            modify( get< account_authority_object, by_account >( STEEM_TEMP_ACCOUNT ), [&]( account_authority_object& auth )
+            modify( get< account_authority_object, by_account_lookup >( STEEM_TEMP_ACCOUNT ), [&]( account_authority_object& auth )
             {
                auth.posting = authority();
                auth.posting.weight_threshold = 1;
@@ -259,12 +259,29 @@ namespace steem { namespace chain {
                member< account_object, account_name_type, &account_object::name >
             > /// composite key by_next_vesting_withdrawal
          >
+#ifdef HASHED_NAME_INDEX
+         ,
+         hashed_unique< tag< by_name_hash >,
+            member< account_object, account_name_type, &account_object::name >,
+            chainbase::byte_hash< account_name_type > >
+#endif
       >,
       allocator< account_object >
    > account_index;
 
    struct by_account;
 
+   /**
+    * Index for equality lookups of account authorities by account. Building with HASHED_NAME_INDEX adds
+    * a hashed by_account_hash index, ordered traversal keeps using by_account.
+    */
+#ifdef HASHED_NAME_INDEX
+   struct by_account_hash;
+   typedef by_account_hash by_account_lookup;
+#else
+   typedef by_account by_account_lookup;
+#endif
+
    typedef multi_index_container <
       owner_authority_history_object,
       indexed_by <
@@ -303,6 +320,12 @@ namespace steem { namespace chain {
             >,
             composite_key_compare< std::greater< time_point_sec >, std::less< account_authority_id_type > >
          >
+#ifdef HASHED_NAME_INDEX
+         ,
+         hashed_unique< tag< by_account_hash >,
+            member< account_authority_object, account_name_type, &account_authority_object::account >,
+            chainbase::byte_hash< account_name_type > >
+#endif
       >,
       allocator< account_authority_object >
    > account_authority_index;
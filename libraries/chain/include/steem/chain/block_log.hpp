@@ -47,10 +47,22 @@ namespace steem { namespace chain {
          std::pair< signed_block, uint64_t > read_block( uint64_t file_pos )const;
          optional< signed_block > read_block_by_num( uint32_t block_num )const;
 
+         /**
+          * Return the packed bytes of a block as stored in the log, without deserializing it.
+          * Returns an empty vector if the block is not in the log.
+          */
+         std::vector< char > read_block_data_by_num( uint32_t block_num )const;
+
          /**
           * Return offset of block in file, or block_log::npos if it does not exist.
           */
          uint64_t get_block_pos( uint32_t block_num ) const;
+
+         /**
+          * Read size bytes starting offset bytes into the packed block without unpacking the block.
+          * Returns an empty vector if the block is not in the log.
+          */
+         std::vector< char > read_block_data_slice( uint32_t block_num, uint64_t offset, uint64_t size )const;
          signed_block read_head()const;
          const optional< signed_block >& head()const;
 
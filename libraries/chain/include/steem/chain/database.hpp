@@ -9,10 +9,13 @@
 #include <steem/chain/hardfork_property_object.hpp>
 #include <steem/chain/node_property_object.hpp>
 #include <steem/chain/operation_notification.hpp>
+#include <steem/chain/pending_transaction.hpp>
 #include <steem/chain/transaction_notification.hpp>
 
 #include <steem/chain/util/advanced_benchmark_dumper.hpp>
+#include <steem/chain/util/monotonic_arena.hpp>
 #include <steem/chain/util/signal.hpp>
+#include <steem/chain/util/state_digest.hpp>
 
 #include <steem/protocol/protocol.hpp>
 #include <steem/protocol/hardfork.hpp>
@@ -24,6 +27,7 @@
 #include <fc/log/logger.hpp>
 
 #include <map>
+#include <mutex>
 
 namespace steem { namespace chain {
 
@@ -37,6 +41,7 @@ namespace steem { namespace chain {
 
    class database_impl;
    class custom_operation_interpreter;
+   class transaction_prevalidator;
 
    namespace util {
       struct comment_reward_context;
@@ -66,6 +71,30 @@ namespace steem { namespace chain {
          void set_producing( bool p ) { _is_producing = p;  }
          bool is_processing_block()const { return _currently_processing_block_id.valid(); }
 
+         /**
+          * Scratch memory for objects that do not outlive the block being applied. Everything
+          * allocated from it is released after post_apply_block has been signaled.
+          */
+         util::monotonic_arena& get_block_arena() { return _block_arena; }
+
+         /// The worker pool enabled by open_args::parallel_validation_threads, or nullptr
+         const transaction_prevalidator* get_transaction_prevalidator()const { return _transaction_prevalidator.get(); }
+
+         /**
+          * Queues recovery of the witness signing keys of blocks that are about to be pushed on the parallel
+          * validation threads, so validating their headers only compares keys. Returns without waiting, a block
+          * pushed before its key is recovered recovers it itself. Meant for sync, where blocks arrive well ahead
+          * of being applied. Does nothing without parallel_validation_threads. May be called from any thread,
+          * it does not read chain state and the blocks need not outlive the call.
+          */
+         void precheck_block_signees( const vector< const signed_block* >& blocks );
+
+         /**
+          * Digests of the object indices, maintained incrementally when open_args::enable_state_digest is set.
+          * Two nodes at the same block with valid digests hold identical state when the digests match.
+          */
+         util::state_digest get_state_digest()const;
+
          bool _is_producing = false;
 
          bool _log_hardforks = true;
@@ -103,6 +132,10 @@ namespace steem { namespace chain {
             uint32_t chainbase_flags = 0;
             bool do_validate_invariants = false;
             bool benchmark_is_enabled = false;
+            /// Experimental, threads checking the transactions of a block before it is applied, 0 to disable
+            uint32_t parallel_validation_threads = 0;
+            /// Keep a digest of every object index current, see get_state_digest()
+            bool enable_state_digest = false;
 
             // The following fields are only used on reindexing
             uint32_t stop_replay_at = 0;
@@ -152,7 +185,15 @@ namespace steem { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /// Packed block bytes, irreversible blocks are returned straight from the block log without unpacking
+         std::vector<char>          fetch_block_data_by_number( uint32_t num )const;
          const signed_transaction   get_recent_transaction( const transaction_id_type& trx_id )const;
+
+         /**
+          *  Fetch a single transaction of a block. When trx_size is known and the block is irreversible
+          *  only the packed transaction is read from the block log, the rest of the block is not unpacked.
+          */
+         optional<signed_transaction> fetch_transaction_by_location( uint32_t block_num, uint32_t trx_in_block, uint32_t trx_offset = 0, uint32_t trx_size = 0 )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
          chain_id_type steem_chain_id;
@@ -219,10 +260,26 @@ namespace steem { namespace chain {
          bool                                   before_last_checkpoint()const;
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
+
+         /**
+          * Pushes a run of blocks in order. A block that fails does not stop the run, its exception is stored
+          * at its index in results and the blocks after it are still pushed. Entries of results that are already
+          * set are skipped. Returns false if any block failed.
+          */
+         bool push_blocks( const vector< const signed_block* >& blocks, vector< fc::optional< fc::exception > >& results, uint32_t skip = skip_nothing );
          void push_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
+         /// Pushes a transaction whose id, size and signature keys were already derived, see precheck_transaction
+         void push_transaction( const pending_transaction& trx, uint32_t skip = skip_nothing );
+
+         /**
+          * The checks of push_transaction that only read chain state: size, duplicate, expiration and TaPoS.
+          * Throws what push_transaction would throw. Lets the network layer turn away bad transactions
+          * before they wait for the write lock. Call with a read lock held.
+          */
+         void precheck_transaction( const pending_transaction& trx )const;
          void _maybe_warn_multiple_production( uint32_t height )const;
          bool _push_block( const signed_block& b );
-         void _push_transaction( const signed_transaction& trx );
+         void _push_transaction( const pending_transaction& trx );
 
          signed_block generate_block(
             const fc::time_point_sec when,
@@ -251,6 +308,7 @@ namespace steem { namespace chain {
          void notify_post_apply_operation( const operation_notification& note );
          void notify_pre_apply_block( const block_notification& note );
          void notify_post_apply_block( const block_notification& note );
+         void notify_post_pop_block( const block_notification& note );
          void notify_irreversible_block( uint32_t block_num );
          void notify_pre_apply_transaction( const transaction_notification& note );
          void notify_post_apply_transaction( const transaction_notification& note );
@@ -280,6 +338,7 @@ namespace steem { namespace chain {
          boost::signals2::connection add_post_apply_transaction_handler( const apply_transaction_handler_t&    func, const abstract_plugin& plugin, int32_t group = -1 );
          boost::signals2::connection add_pre_apply_block_handler       ( const apply_block_handler_t&          func, const abstract_plugin& plugin, int32_t group = -1 );
          boost::signals2::connection add_post_apply_block_handler      ( const apply_block_handler_t&          func, const abstract_plugin& plugin, int32_t group = -1 );
+         boost::signals2::connection add_post_pop_block_handler        ( const apply_block_handler_t&          func, const abstract_plugin& plugin, int32_t group = -1 );
          boost::signals2::connection add_irreversible_block_handler    ( const irreversible_block_handler_t&   func, const abstract_plugin& plugin, int32_t group = -1 );
          boost::signals2::connection add_pre_reindex_handler           ( const reindex_handler_t&              func, const abstract_plugin& plugin, int32_t group = -1 );
          boost::signals2::connection add_post_reindex_handler          ( const reindex_handler_t&              func, const abstract_plugin& plugin, int32_t group = -1 );
@@ -423,7 +482,12 @@ namespace steem { namespace chain {
          /** when popping a block, the transactions that were removed get cached here so they
           * can be reapplied at the proper time */
          std::deque< signed_transaction >       _popped_tx;
-         vector< signed_transaction >           _pending_tx;
+         pending_transaction_index              _pending_tx;
+
+         /** Sum of packed_size and union of the skip flags of everything applied to _pending_tx_session,
+          * used by _generate_block to decide whether the pending state can become the block as is */
+         uint64_t                               _pending_tx_size = 0;
+         uint32_t                               _pending_tx_skip = 0;
 
          bool apply_order( const limit_order_object& new_order_object );
          bool fill_order( const limit_order_object& order, const asset& pays, const asset& receives );
@@ -485,7 +549,9 @@ namespace steem { namespace chain {
          void apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
          void apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          void _apply_block( const signed_block& next_block );
-         void _apply_transaction( const signed_transaction& trx );
+         void _apply_transaction( const signed_transaction& trx, const pending_transaction* pending = nullptr );
+         /// The duplicate, TaPoS and expiration checks shared by _apply_transaction and precheck_transaction
+         void validate_transaction_state( const signed_transaction& trx, const transaction_id_type& trx_id, uint32_t skip )const;
          void apply_operation( const operation& op );
 
 
@@ -537,6 +603,13 @@ namespace steem { namespace chain {
          uint16_t                      _current_virtual_op   = 0;
 
          optional< block_id_type >     _currently_processing_block_id;
+         util::monotonic_arena         _block_arena;
+
+         /// Witness keys recovered by precheck_block_signees, taken by validate_block_header
+         mutable std::map< block_id_type, public_key_type > _prechecked_block_signees;
+         mutable std::mutex            _prechecked_block_signees_mutex;
+         /// After the signees it fills in, so its workers are stopped first
+         std::unique_ptr< transaction_prevalidator > _transaction_prevalidator;
 
          flat_map<uint32_t,block_id_type>  _checkpoints;
 
@@ -584,6 +657,13 @@ namespace steem { namespace chain {
           */
          fc::signal<void(const block_notification&)>           _post_apply_block_signal;
 
+         /**
+          *  This signal is emitted after a block has been popped and its changes undone,
+          *  either by pop_block() directly or while switching forks. The notification
+          *  carries the block that was removed. The write lock is held.
+          */
+         fc::signal<void(const block_notification&)>           _post_pop_block_signal;
+
          /**
           * This signal is emitted any time a new transaction is about to be applied
           * to the chain state.
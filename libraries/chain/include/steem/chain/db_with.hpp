@@ -45,7 +45,7 @@ struct skip_flags_restorer
  */
 struct pending_transactions_restorer
 {
-   pending_transactions_restorer( database& db, std::vector<signed_transaction>&& pending_transactions )
+   pending_transactions_restorer( database& db, pending_transaction_index&& pending_transactions )
       : _db(db), _pending_transactions( std::move(pending_transactions) )
    {
       _db.clear_pending();
@@ -56,23 +56,31 @@ struct pending_transactions_restorer
       for( const auto& tx : _db._popped_tx )
       {
          try {
-            if( !_db.is_known_transaction( tx.id() ) ) {
+            pending_transaction ptx( tx );
+            if( !_db.is_known_transaction( ptx.id ) ) {
                // since push_transaction() takes a signed_transaction,
                // the operation_results field will be ignored.
-               _db._push_transaction( tx );
+               _db._push_transaction( ptx );
             }
          } catch ( const fc::exception&  ) {
          }
       }
       _db._popped_tx.clear();
-      for( const signed_transaction& tx : _pending_transactions )
+
+      // Transactions that expired in the new head block can never apply again, drop them without
+      // opening an undo session for each one.
+      auto& by_exp = _pending_transactions.get< by_expiration >();
+      by_exp.erase( by_exp.begin(), by_exp.lower_bound( _db.head_block_time() ) );
+
+      for( const pending_transaction& ptx : _pending_transactions )
       {
          try
          {
-            if( !_db.is_known_transaction( tx.id() ) ) {
+            // The cached id and signature keys are reused, only state dependent checks run again.
+            if( !_db.is_known_transaction( ptx.id ) ) {
                // since push_transaction() takes a signed_transaction,
                // the operation_results field will be ignored.
-               _db._push_transaction( tx );
+               _db._push_transaction( ptx );
             }
          }
          catch( const transaction_exception& e )
@@ -80,7 +88,7 @@ struct pending_transactions_restorer
             dlog( "Pending transaction became invalid after switching to block ${b} ${n} ${t}",
                ("b", _db.head_block_id())("n", _db.head_block_num())("t", _db.head_block_time()) );
             dlog( "The invalid transaction caused exception ${e}", ("e", e.to_detail_string()) );
-            dlog( "${t}", ("t", tx) );
+            dlog( "${t}", ("t", ptx.trx) );
          }
          catch( const fc::exception& e )
          {
@@ -96,7 +104,7 @@ struct pending_transactions_restorer
    }
 
    database& _db;
-   std::vector< signed_transaction > _pending_transactions;
+   pending_transaction_index _pending_transactions;
 };
 
 /**
@@ -126,7 +134,7 @@ void with_skip_flags(
 template< typename Lambda >
 void without_pending_transactions(
    database& db,
-   std::vector<signed_transaction>&& pending_transactions,
+   pending_transaction_index&& pending_transactions,
    Lambda callback )
 {
     pending_transactions_restorer restorer( db, std::move(pending_transactions) );
@@ -35,6 +35,10 @@ namespace steem { namespace chain {
          time_point_sec       timestamp;
          buffer_type          serialized_op;
 
+         /// Location of the packed transaction inside its packed block, trx_size is 0 when unknown
+         uint32_t             trx_offset = 0;
+         uint32_t             trx_size = 0;
+
          uint64_t             get_virtual_op() const { return virtual_op; }
    };
 
@@ -58,20 +62,35 @@ namespace steem { namespace chain {
       allocator< operation_object >
    > operation_index;
 
+   /**
+    *  Each entry holds a copy of the packed operation so that reading an account's history
+    *  is a single scan over by_account without a lookup into the operation_index per entry.
+    */
    class account_history_object : public object< account_history_object_type, account_history_object >
    {
+      account_history_object() = delete;
+
       public:
          template< typename Constructor, typename Allocator >
          account_history_object( Constructor&& c, allocator< Allocator > a )
+            :serialized_op( a )
          {
             c( *this );
          }
 
-         id_type           id;
+         id_type              id;
+
+         account_name_type    account;
+         uint32_t             sequence = 0;
+         operation_id_type    op;
 
-         account_name_type account;
-         uint32_t          sequence = 0;
-         operation_id_type op;
+         transaction_id_type  trx_id;
+         uint32_t             block = 0;
+         uint32_t             trx_in_block = 0;
+         uint32_t             op_in_trx = 0;
+         uint32_t             virtual_op = 0;
+         time_point_sec       timestamp;
+         buffer_type          serialized_op;
    };
 
    struct by_account;
@@ -92,10 +111,10 @@ namespace steem { namespace chain {
    > account_history_index;
 } }
 
-FC_REFLECT( steem::chain::operation_object, (id)(trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(serialized_op) )
+FC_REFLECT( steem::chain::operation_object, (id)(trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(serialized_op)(trx_offset)(trx_size) )
 CHAINBASE_SET_INDEX_TYPE( steem::chain::operation_object, steem::chain::operation_index )
 
-FC_REFLECT( steem::chain::account_history_object, (id)(account)(sequence)(op) )
+FC_REFLECT( steem::chain::account_history_object, (id)(account)(sequence)(op)(trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(serialized_op) )
 
 CHAINBASE_SET_INDEX_TYPE( steem::chain::account_history_object, steem::chain::account_history_index )
 
@@ -136,9 +155,9 @@ namespace helpers
 
          if(onlyStaticInfo == false)
          {
-            //for(const auto& o : index)
-            //   info._item_additional_allocation += o.get_ops().capacity()*
-            //      sizeof(steem::chain::account_history_object::operation_container::value_type);
+            for(const auto& o : index)
+               info._item_additional_allocation +=
+                  o.serialized_op.capacity()*sizeof(steem::chain::buffer_type::value_type);
          }
 
          return info;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <steem/chain/database.hpp>
+#include <steem/chain/util/state_digest.hpp>
 
 namespace steem { namespace chain {
 
@@ -8,6 +9,7 @@ template< typename MultiIndexType >
 void _add_index_impl( database& db )
 {
    db.add_index< MultiIndexType >();
+   chainbase::generic_index< MultiIndexType >::set_object_hasher( &util::hash_object< typename MultiIndexType::value_type > );
 }
 
 template< typename MultiIndexType >
@@ -0,0 +1,75 @@
+#pragma once
+#include <steem/protocol/transaction.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/mem_fun.hpp>
+
+namespace steem { namespace chain {
+   using boost::multi_index_container;
+   using namespace boost::multi_index;
+
+   using steem::protocol::signed_transaction;
+   using steem::protocol::transaction_id_type;
+   using steem::protocol::chain_id_type;
+   using steem::protocol::public_key_type;
+
+   /**
+    *  A transaction held in the pending state together with the values that are
+    *  expensive to derive from it. None of them depend on chain state, so they
+    *  stay valid while the transaction is re-applied on top of new blocks and only
+    *  the state dependent checks (authorities, TaPoS, expiration, evaluators) run
+    *  again.
+    */
+   struct pending_transaction
+   {
+      pending_transaction( const signed_transaction& t )
+      :trx( t ),id( t.id() ),packed_size( fc::raw::pack_size( t ) ){}
+
+      fc::time_point_sec expiration()const { return trx.expiration; }
+
+      /**
+       *  Recovers the signing keys on first use and returns the cached set afterwards.
+       *  The keys only depend on the chain id, the transaction digest and the signatures.
+       */
+      const flat_set< public_key_type >& get_signature_keys( const chain_id_type& chain_id )const
+      {
+         if( !signature_keys.valid() || signature_chain_id != chain_id )
+         {
+            signature_keys = trx.get_signature_keys( chain_id );
+            signature_chain_id = chain_id;
+         }
+
+         return *signature_keys;
+      }
+
+      signed_transaction                                 trx;
+      transaction_id_type                                id;             // initialized in ctor
+      uint32_t                                           packed_size;    // initialized in ctor
+
+      private:
+         mutable optional< flat_set< public_key_type > > signature_keys;
+         mutable chain_id_type                           signature_chain_id;
+   };
+
+   struct by_trx_id;
+   struct by_expiration;
+
+   /**
+    *  Pending transactions in the order they were accepted, which is the order
+    *  they are applied in when rebuilding the pending state or producing a block.
+    */
+   typedef multi_index_container<
+      pending_transaction,
+      indexed_by<
+         sequenced<>,
+         ordered_non_unique< tag< by_trx_id >, member< pending_transaction, transaction_id_type, &pending_transaction::id > >,
+         ordered_non_unique< tag< by_expiration >, const_mem_fun< pending_transaction, fc::time_point_sec, &pending_transaction::expiration > >
+      >
+   > pending_transaction_index;
+
+} } // steem::chain
@@ -5,6 +5,7 @@
 #include <boost/multi_index/mem_fun.hpp>
 
 #include <chainbase/chainbase.hpp>
+#include <chainbase/util/byte_hash.hpp>
 
 #include <steem/protocol/types.hpp>
 #include <steem/protocol/authority.hpp>
@@ -35,6 +36,17 @@ inline void from_string( shared_string& out, const string& in ){ out.assign( in.
 struct by_id;
 struct by_name;
 
+/**
+ * Index for equality lookups by name. Building with HASHED_NAME_INDEX adds a hashed by_name_hash
+ * index to accounts and witnesses, ordered traversal keeps using by_name.
+ */
+#ifdef HASHED_NAME_INDEX
+struct by_name_hash;
+typedef by_name_hash by_name_lookup;
+#else
+typedef by_name by_name_lookup;
+#endif
+
 enum object_type
 {
    dynamic_global_property_object_type,
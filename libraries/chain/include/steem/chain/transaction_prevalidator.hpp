@@ -0,0 +1,106 @@
+#pragma once
+#include <steem/chain/pending_transaction.hpp>
+
+#include <steem/protocol/block.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace steem { namespace chain {
+
+   using steem::protocol::signed_block;
+   using steem::protocol::account_name_type;
+
+   /**
+    *  A transaction of an incoming block after the checks that do not depend on chain state
+    *  ran on a worker thread.
+    */
+   struct prevalidated_transaction
+   {
+      /// Cached id, size and signature keys, reused by _apply_transaction
+      std::unique_ptr< pending_transaction >    pending;
+      /// Set when validate() and signature recovery (where requested) succeeded
+      bool                                      valid = false;
+      /// Accounts impacted by the operations, the write set used to find independent transactions
+      flat_set< account_name_type >             accounts;
+   };
+
+   /**
+    *  Experimental. Runs operation validation, signature recovery and write set discovery for
+    *  all transactions of a block on a pool of worker threads before the block is applied.
+    *
+    *  Transactions are still applied one after another in block order. chainbase indices and
+    *  the undo state only support a single writer, so transactions with disjoint write sets are
+    *  counted (see stats) but not applied concurrently. A transaction whose checks failed is not
+    *  marked valid and goes through the serial checks, which raise the same exception at the
+    *  same position in the block.
+    */
+   class transaction_prevalidator
+   {
+      public:
+         struct stats
+         {
+            uint64_t blocks = 0;
+            uint64_t transactions = 0;
+            /// Transactions left to the serial checks
+            uint64_t failed = 0;
+            /// Sets of transactions sharing no impacted account, summed over all blocks
+            uint64_t independent_groups = 0;
+            uint64_t largest_group = 0;
+         };
+
+         explicit transaction_prevalidator( uint32_t threads );
+         ~transaction_prevalidator();
+
+         /**
+          *  Fills result with one entry per transaction of b. The calling thread takes part in
+          *  the work and the call returns once every transaction has been processed.
+          */
+         void prevalidate( const signed_block& b, const chain_id_type& chain_id, bool validate, bool recover_signatures,
+            std::vector< prevalidated_transaction >& result );
+
+         /**
+          *  Calls job( i ) for every i below count, spread over the worker threads and the calling
+          *  thread. Calls from different threads take turns, the pool runs one job at a time.
+          */
+         void run( size_t count, const std::function< void( size_t ) >& job );
+
+         /**
+          *  Queues task for a worker thread and returns at once. Workers take posted tasks only
+          *  while no job from run() is waiting for them. Tasks still queued when the pool is
+          *  destroyed are dropped.
+          */
+         void post( std::function< void() > task );
+         /// True while posted tasks are queued or running
+         bool has_posted_tasks()const;
+
+         uint32_t     get_thread_count()const { return _threads.size(); }
+         const stats& get_stats()const { return _stats; }
+
+      private:
+         void run_worker();
+         void run_job();
+
+         std::vector< std::thread >       _threads;
+         std::mutex                       _run_mutex;
+         mutable std::mutex               _mutex;
+         std::condition_variable          _work_cv;
+         std::condition_variable          _done_cv;
+         std::function< void( size_t ) >  _job;
+         size_t                           _job_size = 0;
+         std::atomic< size_t >            _next_index;
+         uint64_t                         _generation = 0;
+         size_t                           _finished_workers = 0;
+         std::deque< std::function< void() > > _tasks;
+         size_t                           _running_tasks = 0;
+         bool                             _stop = false;
+         stats                            _stats;
+   };
+
+} } // steem::chain
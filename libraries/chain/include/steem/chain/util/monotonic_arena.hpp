@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace steem { namespace chain { namespace util {
+
+/**
+ * Bump allocator for short lived objects. Deallocation is a no-op, all memory is released at
+ * once by reset(), which keeps the largest block so steady state use does not touch the heap.
+ *
+ * The database owns one arena that is reset after every applied block, see
+ * database::get_block_arena(). It is not thread safe.
+ */
+class monotonic_arena
+{
+   public:
+      explicit monotonic_arena( size_t initial_block_size = 64 * 1024 );
+
+      monotonic_arena( const monotonic_arena& ) = delete;
+      monotonic_arena& operator=( const monotonic_arena& ) = delete;
+
+      void* allocate( size_t size, size_t alignment = alignof( std::max_align_t ) )
+      {
+         uintptr_t p = ( uintptr_t( _pos ) + alignment - 1 ) & ~uintptr_t( alignment - 1 );
+         if( p + size > uintptr_t( _end ) || _pos == nullptr )
+            return allocate_slow( size, alignment );
+
+         _pos = reinterpret_cast< char* >( p + size );
+         _allocated += size;
+         ++_allocations;
+         return reinterpret_cast< void* >( p );
+      }
+
+      void deallocate( void*, size_t ) {}
+
+      /// Releases everything allocated since the last reset
+      void reset();
+
+      /// Bytes handed out since the last reset
+      size_t allocated_bytes()const { return _allocated; }
+      /// Allocations served since the last reset
+      size_t allocations()const { return _allocations; }
+      /// Heap blocks currently owned by the arena
+      size_t heap_blocks()const { return _blocks.size(); }
+
+   private:
+      void* allocate_slow( size_t size, size_t alignment );
+
+      struct block
+      {
+         std::unique_ptr< char[] > data;
+         size_t                    size;
+      };
+
+      std::vector< block > _blocks;
+      size_t               _next_block_size;
+      char*                _pos = nullptr;
+      char*                _end = nullptr;
+      size_t               _allocated = 0;
+      size_t               _allocations = 0;
+};
+
+/**
+ * std compatible allocator drawing from a monotonic_arena, for block scoped containers:
+ *
+ *    std::vector< price, arena_allocator< price > > feeds( arena_allocator< price >( get_block_arena() ) );
+ */
+template< typename T >
+class arena_allocator
+{
+   public:
+      typedef T value_type;
+
+      arena_allocator( monotonic_arena& a ) : _arena( &a ) {}
+
+      template< typename U >
+      arena_allocator( const arena_allocator< U >& other ) : _arena( other.arena() ) {}
+
+      T* allocate( size_t n ) { return static_cast< T* >( _arena->allocate( n * sizeof( T ), alignof( T ) ) ); }
+      void deallocate( T* p, size_t n ) { _arena->deallocate( p, n * sizeof( T ) ); }
+
+      monotonic_arena* arena()const { return _arena; }
+
+      template< typename U >
+      bool operator==( const arena_allocator< U >& other )const { return _arena == other.arena(); }
+      template< typename U >
+      bool operator!=( const arena_allocator< U >& other )const { return _arena != other.arena(); }
+
+   private:
+      monotonic_arena* _arena;
+};
+
+template< typename T >
+using arena_vector = std::vector< T, arena_allocator< T > >;
+
+} } } // steem::chain::util
@@ -39,6 +39,9 @@ inline uint128_t get_content_constant_s()
    return STEEM_CONTENT_CONSTANT_HF0; // looking good for posters
 }
 
+/// Integer approximation of sqrt(x), exact at powers of two and linear in between
+uint64_t approx_sqrt( const uint128_t& x );
+
 uint128_t evaluate_reward_curve( const uint128_t& rshares, const protocol::curve_id& curve = protocol::quadratic, const uint128_t& content_constant = STEEM_CONTENT_CONSTANT_HF0 );
 
 inline bool is_comment_payout_dust( const price& p, uint64_t steem_payout )
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <steem/protocol/types.hpp>
+
+#include <chainbase/chainbase.hpp>
+
+#include <fc/crypto/city.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/uint128.hpp>
+
+#include <boost/container/deque.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+#include <boost/container/string.hpp>
+#include <boost/container/vector.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace steem { namespace chain { namespace util {
+
+/**
+ * Collects the serialized bytes of one object and hashes them into an index digest term.
+ */
+class digest_stream
+{
+   public:
+      void write( const char* d, size_t s ) { _buffer.insert( _buffer.end(), d, d + s ); }
+      void put( char c ) { _buffer.push_back( c ); }
+      size_t tellp()const { return _buffer.size(); }
+
+      chainbase::index_digest result()const
+      {
+         fc::uint128 h = fc::city_hash128( _buffer.data(), _buffer.size() );
+         chainbase::index_digest d;
+         d.lo = h.lo;
+         d.hi = h.hi;
+         return d;
+      }
+
+   private:
+      std::vector< char > _buffer;
+};
+
+/**
+ * Serializes chain objects for the state digest. The byte format follows fc::raw, but the interprocess
+ * strings and containers objects are built from are handled here since fc::raw cannot find overloads
+ * for them from inside its own templates. Reflected types are walked member by member, anything else
+ * is handed to fc::raw::pack.
+ */
+template< typename T >
+void digest_pack( digest_stream& s, const T& v );
+
+template< typename... A >
+void digest_pack( digest_stream& s, const boost::container::basic_string< char, A... >& v );
+
+template< typename T, typename... A >
+void digest_pack( digest_stream& s, const boost::container::vector< T, A... >& v );
+
+template< typename T, typename... A >
+void digest_pack( digest_stream& s, const boost::container::deque< T, A... >& v );
+
+template< typename K, typename V, typename... A >
+void digest_pack( digest_stream& s, const boost::container::flat_map< K, V, A... >& v );
+
+template< typename K, typename... A >
+void digest_pack( digest_stream& s, const boost::container::flat_set< K, A... >& v );
+
+template< typename A, typename B >
+void digest_pack( digest_stream& s, const std::pair< A, B >& v );
+
+namespace detail {
+
+   template< typename Class >
+   struct digest_member_visitor
+   {
+      digest_member_visitor( digest_stream& s, const Class& o ) : stream( s ), obj( o ) {}
+
+      template< typename Member, class C, Member (C::*member) >
+      void operator()( const char* )const
+      {
+         digest_pack( stream, obj.*member );
+      }
+
+      digest_stream& stream;
+      const Class&   obj;
+   };
+
+   template< typename T >
+   void digest_pack_object( digest_stream& s, const T& v, std::true_type )
+   {
+      fc::reflector< T >::visit( digest_member_visitor< T >( s, v ) );
+   }
+
+   template< typename T >
+   void digest_pack_object( digest_stream& s, const T& v, std::false_type )
+   {
+      fc::raw::pack( s, v );
+   }
+
+   template< typename Container >
+   void digest_pack_range( digest_stream& s, const Container& c )
+   {
+      fc::raw::pack( s, fc::unsigned_int( (uint32_t)c.size() ) );
+      for( const auto& e : c )
+         digest_pack( s, e );
+   }
+
+} // detail
+
+template< typename T >
+void digest_pack( digest_stream& s, const T& v )
+{
+   detail::digest_pack_object( s, v, std::integral_constant< bool,
+      fc::reflector< T >::is_defined::value && !fc::reflector< T >::is_enum::value >() );
+}
+
+template< typename... A >
+void digest_pack( digest_stream& s, const boost::container::basic_string< char, A... >& v )
+{
+   fc::raw::pack( s, fc::unsigned_int( (uint32_t)v.size() ) );
+   if( v.size() )
+      s.write( v.data(), v.size() );
+}
+
+template< typename T, typename... A >
+void digest_pack( digest_stream& s, const boost::container::vector< T, A... >& v )
+{
+   detail::digest_pack_range( s, v );
+}
+
+template< typename T, typename... A >
+void digest_pack( digest_stream& s, const boost::container::deque< T, A... >& v )
+{
+   detail::digest_pack_range( s, v );
+}
+
+template< typename K, typename V, typename... A >
+void digest_pack( digest_stream& s, const boost::container::flat_map< K, V, A... >& v )
+{
+   detail::digest_pack_range( s, v );
+}
+
+template< typename K, typename... A >
+void digest_pack( digest_stream& s, const boost::container::flat_set< K, A... >& v )
+{
+   detail::digest_pack_range( s, v );
+}
+
+template< typename A, typename B >
+void digest_pack( digest_stream& s, const std::pair< A, B >& v )
+{
+   digest_pack( s, v.first );
+   digest_pack( s, v.second );
+}
+
+/// The object hasher registered with every chainbase index when state digests are enabled
+template< typename ObjectType >
+chainbase::index_digest hash_object( const ObjectType& o )
+{
+   digest_stream s;
+   digest_pack( s, o );
+   return s.result();
+}
+
+struct index_state_digest
+{
+   uint16_t       type_id = 0;
+   std::string    name;
+   uint64_t       objects = 0;
+   /// False once the index changed while its digest was not tracked, the digest is then meaningless
+   bool           valid = false;
+   fc::uint128    digest;
+};
+
+/**
+ * The digests of all object indices at a block. The combined digest covers only the consensus indices
+ * (object space 0, less the operation and account history indices the account history plugin fills) so it
+ * can be compared between nodes running different plugins.
+ */
+struct state_digest
+{
+   uint32_t                            head_block_num = 0;
+   protocol::block_id_type             head_block_id;
+   bool                                valid = false;
+   fc::sha256                          digest;
+   std::vector< index_state_digest >   indices;
+};
+
+} } } // steem::chain::util
+
+FC_REFLECT( steem::chain::util::index_state_digest, (type_id)(name)(objects)(valid)(digest) )
+FC_REFLECT( steem::chain::util::state_digest, (head_block_num)(head_block_id)(valid)(digest)(indices) )
@@ -219,6 +219,12 @@ namespace steem { namespace chain {
                member< witness_object, witness_id_type, &witness_object::id >
             >
          >
+#ifdef HASHED_NAME_INDEX
+         ,
+         hashed_unique< tag< by_name_hash >,
+            member< witness_object, account_name_type, &witness_object::owner >,
+            chainbase::byte_hash< account_name_type > >
+#endif
       >,
       allocator< witness_object >
    > witness_index;
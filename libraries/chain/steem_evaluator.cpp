@@ -437,7 +437,7 @@ void account_update_evaluator::do_apply( const account_update_operation& o )
       o.posting->validate();
 
    const auto& account = _db.get_account( o.account );
-   const auto& account_auth = _db.get< account_authority_object, by_account >( o.account );
+   const auto& account_auth = _db.get< account_authority_object, by_account_lookup >( o.account );
 
    if( _db.is_producing() || _db.has_hardfork( STEEM_HARDFORK_0_20 ) )
    {
@@ -1785,7 +1785,7 @@ void pow_apply( database& db, Operation o )
    }
 
    const auto& worker_account = db.get_account( o.get_worker_account() ); // verify it exists
-   const auto& worker_auth = db.get< account_authority_object, by_account >( o.get_worker_account() );
+   const auto& worker_auth = db.get< account_authority_object, by_account_lookup >( o.get_worker_account() );
    FC_ASSERT( worker_auth.active.num_auths() == 1, "Miners can only have one key authority. ${a}", ("a",worker_auth.active) );
    FC_ASSERT( worker_auth.active.key_auths.size() == 1, "Miners may only have one key authority." );
    FC_ASSERT( worker_auth.active.key_auths.begin()->first == o.work.worker, "Work must be performed by key that signed the work." );
@@ -0,0 +1,194 @@
+#include <steem/chain/transaction_prevalidator.hpp>
+
+#include <steem/chain/util/impacted.hpp>
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace steem { namespace chain {
+
+transaction_prevalidator::transaction_prevalidator( uint32_t threads )
+   : _next_index( 0 )
+{
+   FC_ASSERT( threads > 0 );
+
+   for( uint32_t i = 0; i < threads; ++i )
+      _threads.emplace_back( [this]() { run_worker(); } );
+}
+
+transaction_prevalidator::~transaction_prevalidator()
+{
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      _stop = true;
+   }
+   _work_cv.notify_all();
+
+   for( auto& t : _threads )
+      t.join();
+}
+
+void transaction_prevalidator::run_worker()
+{
+   uint64_t seen_generation = 0;
+
+   while( true )
+   {
+      std::function< void() > task;
+      {
+         std::unique_lock< std::mutex > lock( _mutex );
+         _work_cv.wait( lock, [&]() { return _stop || _generation != seen_generation || !_tasks.empty(); } );
+         if( _stop )
+            return;
+
+         // A job from run() has a caller waiting on it, it goes before any posted task
+         if( _generation == seen_generation )
+         {
+            task = std::move( _tasks.front() );
+            _tasks.pop_front();
+            ++_running_tasks;
+         }
+         else
+            seen_generation = _generation;
+      }
+
+      if( task )
+      {
+         try
+         {
+            task();
+         }
+         catch( ... ) {}
+
+         std::lock_guard< std::mutex > lock( _mutex );
+         --_running_tasks;
+         continue;
+      }
+
+      run_job();
+
+      {
+         std::lock_guard< std::mutex > lock( _mutex );
+         if( ++_finished_workers == _threads.size() )
+            _done_cv.notify_one();
+      }
+   }
+}
+
+void transaction_prevalidator::run_job()
+{
+   for( size_t i = _next_index.fetch_add( 1 ); i < _job_size; i = _next_index.fetch_add( 1 ) )
+      _job( i );
+}
+
+void transaction_prevalidator::run( size_t count, const std::function< void( size_t ) >& job )
+{
+   if( count == 0 )
+      return;
+
+   std::lock_guard< std::mutex > run_lock( _run_mutex );
+
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      _job = job;
+      _job_size = count;
+      _next_index = 0;
+      _finished_workers = 0;
+      ++_generation;
+   }
+   _work_cv.notify_all();
+
+   run_job();
+
+   {
+      std::unique_lock< std::mutex > lock( _mutex );
+      _done_cv.wait( lock, [&]() { return _finished_workers == _threads.size(); } );
+      _job = nullptr;
+   }
+}
+
+void transaction_prevalidator::post( std::function< void() > task )
+{
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      _tasks.push_back( std::move( task ) );
+   }
+   _work_cv.notify_one();
+}
+
+bool transaction_prevalidator::has_posted_tasks()const
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   return !_tasks.empty() || _running_tasks > 0;
+}
+
+void transaction_prevalidator::prevalidate( const signed_block& b, const chain_id_type& chain_id, bool validate,
+   bool recover_signatures, std::vector< prevalidated_transaction >& result )
+{
+   result.clear();
+   result.resize( b.transactions.size() );
+   if( result.empty() )
+      return;
+
+   run( result.size(), [&]( size_t i )
+   {
+      auto& r = result[i];
+      try
+      {
+         const auto& trx = b.transactions[i];
+         r.pending.reset( new pending_transaction( trx ) );
+
+         for( const auto& op : trx.operations )
+            steem::app::operation_get_impacted_accounts( op, r.accounts );
+
+         if( validate )
+            trx.validate();
+         if( recover_signatures )
+            r.pending->get_signature_keys( chain_id );
+
+         r.valid = true;
+      }
+      catch( ... )
+      {
+         r.valid = false;
+      }
+   });
+
+   // Group transactions that share an impacted account, each group could be applied independently
+   std::vector< size_t > parent( result.size() );
+   std::iota( parent.begin(), parent.end(), 0 );
+   auto find_root = [&]( size_t i )
+   {
+      while( parent[i] != i )
+         i = parent[i] = parent[ parent[i] ];
+      return i;
+   };
+
+   std::map< account_name_type, size_t > first_writer;
+   for( size_t i = 0; i < result.size(); ++i )
+   {
+      for( const auto& a : result[i].accounts )
+      {
+         auto itr = first_writer.find( a );
+         if( itr == first_writer.end() )
+            first_writer.emplace( a, i );
+         else
+            parent[ find_root( i ) ] = find_root( itr->second );
+      }
+   }
+
+   std::vector< size_t > group_size( result.size(), 0 );
+   for( size_t i = 0; i < result.size(); ++i )
+   {
+      ++group_size[ find_root( i ) ];
+      _stats.failed += result[i].valid ? 0 : 1;
+   }
+
+   ++_stats.blocks;
+   _stats.transactions += result.size();
+   _stats.independent_groups += std::count_if( group_size.begin(), group_size.end(), []( size_t s ) { return s > 0; } );
+   _stats.largest_group = std::max< uint64_t >( _stats.largest_group, *std::max_element( group_size.begin(), group_size.end() ) );
+}
+
+} } // steem::chain
@@ -0,0 +1,44 @@
+#include <steem/chain/util/monotonic_arena.hpp>
+
+#include <algorithm>
+
+namespace steem { namespace chain { namespace util {
+
+monotonic_arena::monotonic_arena( size_t initial_block_size )
+   : _next_block_size( std::max( initial_block_size, size_t( 1024 ) ) ) {}
+
+void* monotonic_arena::allocate_slow( size_t size, size_t alignment )
+{
+   size_t block_size = std::max( _next_block_size, size + alignment );
+   _blocks.push_back( block{ std::unique_ptr< char[] >( new char[ block_size ] ), block_size } );
+   _next_block_size = block_size * 2;
+
+   _pos = _blocks.back().data.get();
+   _end = _pos + block_size;
+   return allocate( size, alignment );
+}
+
+void monotonic_arena::reset()
+{
+   if( _blocks.size() > 1 )
+   {
+      // Keep the largest block, a block that needed more will fit in it next time
+      auto largest = std::max_element( _blocks.begin(), _blocks.end(),
+         []( const block& a, const block& b ){ return a.size < b.size; } );
+      block keep = std::move( *largest );
+      _blocks.clear();
+      _blocks.push_back( std::move( keep ) );
+      _next_block_size = _blocks.back().size * 2;
+   }
+
+   if( _blocks.size() )
+   {
+      _pos = _blocks.back().data.get();
+      _end = _pos + _blocks.back().size;
+   }
+
+   _allocated = 0;
+   _allocations = 0;
+}
+
+} } } // steem::chain::util
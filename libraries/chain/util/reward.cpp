@@ -4,35 +4,102 @@
 
 namespace steem { namespace chain { namespace util {
 
-uint8_t find_msb( const uint128_t& u )
+namespace detail {
+
+typedef unsigned __int128 native_uint128_t;
+
+inline native_uint128_t to_native( const uint128_t& u )
 {
-   uint64_t x;
-   uint8_t places;
-   x      = (u.lo ? u.lo : 1);
-   places = (u.hi ?   64 : 0);
-   x      = (u.hi ? u.hi : x);
-   return uint8_t( boost::multiprecision::detail::find_msb(x) + places );
+   return ( native_uint128_t( u.hi ) << 64 ) | u.lo;
 }
 
-uint64_t approx_sqrt( const uint128_t& x )
+inline uint128_t from_native( native_uint128_t u )
 {
-   if( (x.lo == 0) && (x.hi == 0) )
+   return uint128_t( uint64_t( u >> 64 ), uint64_t( u ) );
+}
+
+inline uint8_t find_msb( native_uint128_t u )
+{
+   uint64_t hi = uint64_t( u >> 64 );
+   uint64_t lo = uint64_t( u );
+   return hi ? uint8_t( 127 - __builtin_clzll( hi ) ) : uint8_t( 63 - __builtin_clzll( lo | 1 ) );
+}
+
+inline uint64_t approx_sqrt( native_uint128_t x )
+{
+   if( x == 0 )
       return 0;
 
-   uint8_t msb_x = find_msb(x);
+   uint8_t msb_x = find_msb( x );
    uint8_t msb_z = msb_x >> 1;
 
-   uint128_t msb_x_bit = uint128_t(1) << msb_x;
-   uint64_t  msb_z_bit = uint64_t (1) << msb_z;
+   native_uint128_t mantissa_x = x & ( ( native_uint128_t( 1 ) << msb_x ) - 1 );
+   uint64_t msb_z_bit = uint64_t( 1 ) << msb_z;
+   uint64_t mantissa_z_hi = msb_z_bit & -uint64_t( msb_x & 1 );
+   uint64_t mantissa_z_lo = uint64_t( mantissa_x >> ( msb_x - msb_z ) );
+   uint64_t mantissa_z = ( mantissa_z_hi | mantissa_z_lo ) >> 1;
+
+   return msb_z_bit | mantissa_z;
+}
+
+/**
+ * Curve evaluators specialized per curve so each call site compiles to straight line native
+ * 128 bit arithmetic. All arithmetic wraps modulo 2^128, exactly like fc::uint128.
+ */
+template< protocol::curve_id Curve >
+struct reward_curve;
+
+template<>
+struct reward_curve< protocol::quadratic >
+{
+   static native_uint128_t evaluate( native_uint128_t rshares, native_uint128_t s )
+   {
+      native_uint128_t rshares_plus_s = rshares + s;
+      return rshares_plus_s * rshares_plus_s - s * s;
+   }
+};
+
+template<>
+struct reward_curve< protocol::quadratic_curation >
+{
+   static native_uint128_t evaluate( native_uint128_t rshares, native_uint128_t s )
+   {
+      native_uint128_t divisor = s * 2 + rshares;
+      if( divisor == 0 )
+         BOOST_THROW_EXCEPTION( std::overflow_error( "Division by zero." ) );
+
+      return ( rshares << 64 ) / divisor;
+   }
+};
+
+template<>
+struct reward_curve< protocol::linear >
+{
+   static native_uint128_t evaluate( native_uint128_t rshares, native_uint128_t )
+   {
+      return rshares;
+   }
+};
 
-   uint128_t mantissa_mask = msb_x_bit - 1;
-   uint128_t mantissa_x = x & mantissa_mask;
-   uint64_t mantissa_z_hi = (msb_x & 1) ? msb_z_bit : 0;
-   uint64_t mantissa_z_lo = (mantissa_x >> (msb_x - msb_z)).lo;
-   uint64_t mantissa_z = (mantissa_z_hi | mantissa_z_lo) >> 1;
-   uint64_t result = msb_z_bit | mantissa_z;
+template<>
+struct reward_curve< protocol::square_root >
+{
+   static native_uint128_t evaluate( native_uint128_t rshares, native_uint128_t )
+   {
+      return approx_sqrt( rshares );
+   }
+};
+
+} // detail
+
+uint8_t find_msb( const uint128_t& u )
+{
+   return detail::find_msb( detail::to_native( u ) );
+}
 
-   return result;
+uint64_t approx_sqrt( const uint128_t& x )
+{
+   return detail::approx_sqrt( detail::to_native( x ) );
 }
 
 uint64_t get_rshare_reward( const comment_reward_context& ctx )
@@ -42,17 +109,42 @@ uint64_t get_rshare_reward( const comment_reward_context& ctx )
    FC_ASSERT( ctx.rshares > 0 );
    FC_ASSERT( ctx.total_reward_shares2 > 0 );
 
-   u256 rf(ctx.total_reward_fund_steem.amount.value);
-   u256 total_claims = to256( ctx.total_reward_shares2 );
-
    //idump( (ctx) );
 
-   u256 claim = to256( evaluate_reward_curve( ctx.rshares.value, ctx.reward_curve, ctx.content_constant ) );
-   claim = ( claim * ctx.reward_weight ) / STEEM_100_PERCENT;
+   uint128_t curve_claim = evaluate_reward_curve( ctx.rshares.value, ctx.reward_curve, ctx.content_constant );
+   int64_t   fund = ctx.total_reward_fund_steem.amount.value;
+   uint64_t  payout = 0;
+   bool      native_payout = false;
 
-   u256 payout_u256 = ( rf * claim ) / total_claims;
-   FC_ASSERT( payout_u256 <= u256( uint64_t( std::numeric_limits<int64_t>::max() ) ) );
-   uint64_t payout = static_cast< uint64_t >( payout_u256 );
+   // Real world claims are far below 2^112, so claim * reward_weight and usually rf * claim
+   // fit in 128 bits and the native path gives the same result as the 256 bit one.
+   detail::native_uint128_t claim = detail::to_native( curve_claim );
+   if( fund >= 0 && ( claim >> 112 ) == 0 )
+   {
+      detail::native_uint128_t rf = uint64_t( fund );
+      claim = ( claim * ctx.reward_weight ) / STEEM_100_PERCENT;
+
+      if( rf == 0 || claim <= ~detail::native_uint128_t( 0 ) / rf )
+      {
+         detail::native_uint128_t payout_native = ( rf * claim ) / detail::to_native( ctx.total_reward_shares2 );
+         FC_ASSERT( payout_native <= detail::native_uint128_t( std::numeric_limits<int64_t>::max() ) );
+         payout = uint64_t( payout_native );
+         native_payout = true;
+      }
+   }
+
+   if( !native_payout )
+   {
+      u256 rf( fund );
+      u256 total_claims = to256( ctx.total_reward_shares2 );
+
+      u256 claim = to256( curve_claim );
+      claim = ( claim * ctx.reward_weight ) / STEEM_100_PERCENT;
+
+      u256 payout_u256 = ( rf * claim ) / total_claims;
+      FC_ASSERT( payout_u256 <= u256( uint64_t( std::numeric_limits<int64_t>::max() ) ) );
+      payout = static_cast< uint64_t >( payout_u256 );
+   }
 
    if( is_comment_payout_dust( ctx.current_steem_price, payout ) )
       payout = 0;
@@ -67,31 +159,27 @@ uint64_t get_rshare_reward( const comment_reward_context& ctx )
 
 uint128_t evaluate_reward_curve( const uint128_t& rshares, const protocol::curve_id& curve, const uint128_t& content_constant )
 {
-   uint128_t result = 0;
+   detail::native_uint128_t r = detail::to_native( rshares );
+   detail::native_uint128_t s = detail::to_native( content_constant );
+   detail::native_uint128_t result = 0;
 
    switch( curve )
    {
       case protocol::quadratic:
-         {
-            uint128_t rshares_plus_s = rshares + content_constant;
-            result = rshares_plus_s * rshares_plus_s - content_constant * content_constant;
-         }
+         result = detail::reward_curve< protocol::quadratic >::evaluate( r, s );
          break;
       case protocol::quadratic_curation:
-         {
-            uint128_t two_alpha = content_constant * 2;
-            result = uint128_t( rshares.lo, 0 ) / ( two_alpha + rshares );
-         }
+         result = detail::reward_curve< protocol::quadratic_curation >::evaluate( r, s );
          break;
       case protocol::linear:
-         result = rshares;
+         result = detail::reward_curve< protocol::linear >::evaluate( r, s );
          break;
       case protocol::square_root:
-         result = approx_sqrt( rshares );
+         result = detail::reward_curve< protocol::square_root >::evaluate( r, s );
          break;
    }
 
-   return result;
+   return detail::from_native( result );
 }
 
 } } } // steem::chain::util
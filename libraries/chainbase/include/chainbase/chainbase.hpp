@@ -161,6 +161,23 @@ namespace chainbase {
          int64_t                      revision = 0;
    };
 
+   /**
+    *  Order independent digest of the objects in an index, the sum of a 128 bit hash of every object.
+    *  Adding and subtracting object hashes as objects are created, modified and removed keeps it
+    *  current without ever walking the index.
+    */
+   struct index_digest
+   {
+      uint64_t lo = 0;
+      uint64_t hi = 0;
+
+      index_digest& operator += ( const index_digest& d ) { lo += d.lo; hi += d.hi; return *this; }
+      index_digest& operator -= ( const index_digest& d ) { lo -= d.lo; hi -= d.hi; return *this; }
+
+      friend bool operator == ( const index_digest& a, const index_digest& b ) { return a.lo == b.lo && a.hi == b.hi; }
+      friend bool operator != ( const index_digest& a, const index_digest& b ) { return !( a == b ); }
+   };
+
    /**
     * The code we want to implement is this:
     *
@@ -202,6 +219,7 @@ namespace chainbase {
          typedef typename index_type::value_type                       value_type;
          typedef allocator< generic_index >                            allocator_type;
          typedef undo_state< value_type >                              undo_state_type;
+         typedef index_digest (*object_hasher)( const value_type& );
 
          generic_index( allocator<value_type> a )
          :_stack(a),_indices( a ),_size_of_value_type( sizeof(typename MultiIndexType::node_type) ),_size_of_this(sizeof(*this)){}
@@ -232,18 +250,22 @@ namespace chainbase {
 
             ++_next_id;
             on_create( *insert_result.first );
+            digest_add( *insert_result.first );
             return *insert_result.first;
          }
 
          template<typename Modifier>
          void modify( const value_type& obj, Modifier&& m ) {
             on_modify( obj );
+            digest_subtract( obj );
             auto ok = _indices.modify( _indices.iterator_to( obj ), m );
             if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not modify object, most likely a uniqueness constraint was violated" ) );
+            digest_add( obj );
          }
 
          void remove( const value_type& obj ) {
             on_remove( obj );
+            digest_subtract( obj );
             _indices.erase( _indices.iterator_to( obj ) );
          }
 
@@ -327,20 +349,25 @@ namespace chainbase {
 
             for( auto& item : head.old_values ) {
                auto ok = _indices.modify( _indices.find( item.second.id ), [&]( value_type& v ) {
+                  digest_subtract( v );
                   v = std::move( item.second );
+                  digest_add( v );
                });
                if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not modify object, most likely a uniqueness constraint was violated" ) );
             }
 
             for( const auto& id : head.new_ids )
             {
-               _indices.erase( _indices.find( id ) );
+               auto itr = _indices.find( id );
+               digest_subtract( *itr );
+               _indices.erase( itr );
             }
             _next_id = head.old_next_id;
 
             for( auto& item : head.removed_values ) {
-               bool ok = _indices.emplace( std::move( item.second ) ).second;
-               if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not restore object, most likely a uniqueness constraint was violated" ) );
+               auto insert_result = _indices.emplace( std::move( item.second ) );
+               if( !insert_result.second ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not restore object, most likely a uniqueness constraint was violated" ) );
+               digest_add( *insert_result.first );
             }
 
             _stack.pop_back();
@@ -481,9 +508,50 @@ namespace chainbase {
             _revision = revision;
          }
 
+         /**
+          *  Sets the function used to hash objects of this type. It is shared by every index of the type
+          *  in the process and must not change once digests are being tracked.
+          */
+         static void set_object_hasher( object_hasher h ) { _hasher = h; }
+         static object_hasher get_object_hasher() { return _hasher; }
+
+         /**
+          *  Starts or stops keeping the digest current. Enabling rebuilds the digest from the objects
+          *  unless it is still valid from a previous run, disabling marks it invalid on the next change.
+          */
+         void enable_digest( bool enable )
+         {
+            _digest_enabled = enable && _hasher != nullptr;
+            if( _digest_enabled && !_digest_valid )
+               rebuild_digest();
+         }
+
+         void rebuild_digest()
+         {
+            if( _hasher == nullptr ) BOOST_THROW_EXCEPTION( std::logic_error( "no object hasher set for index" ) );
+            _digest = index_digest();
+            for( const auto& v : _indices )
+               _digest += _hasher( v );
+            _digest_valid = true;
+         }
+
+         bool                digest_enabled()const { return _digest_enabled && _hasher != nullptr; }
+         bool                digest_valid()const { return _digest_valid; }
+         const index_digest& digest()const { return _digest; }
+
       private:
          bool enabled()const { return _stack.size(); }
 
+         void digest_add( const value_type& v ) {
+            if( digest_enabled() ) _digest += _hasher( v );
+            else _digest_valid = false;
+         }
+
+         void digest_subtract( const value_type& v ) {
+            if( digest_enabled() ) _digest -= _hasher( v );
+            else _digest_valid = false;
+         }
+
          void on_modify( const value_type& v ) {
             if( !enabled() ) return;
 
@@ -541,8 +609,21 @@ namespace chainbase {
          index_type                      _indices;
          uint32_t                        _size_of_value_type = 0;
          uint32_t                        _size_of_this = 0;
+
+         /**
+          *  The digest lives in shared memory with the objects it covers so it survives restarts. It is
+          *  only trusted while _digest_valid, i.e. while every change since the last rebuild was hashed.
+          */
+         index_digest                    _digest;
+         bool                            _digest_valid = true;
+         bool                            _digest_enabled = false;
+
+         static object_hasher            _hasher;
    };
 
+   template<typename MultiIndexType>
+   typename generic_index<MultiIndexType>::object_hasher generic_index<MultiIndexType>::_hasher = nullptr;
+
    class abstract_session {
       public:
          virtual ~abstract_session(){};
@@ -595,6 +676,12 @@ namespace chainbase {
          virtual statistic_info get_statistics(bool onlyStaticInfo) const = 0;
          virtual size_t size() const = 0;
 
+         virtual void         enable_digest( bool enable ) = 0;
+         virtual bool         digest_enabled()const = 0;
+         virtual bool         digest_valid()const = 0;
+         virtual index_digest digest()const = 0;
+         virtual void         rebuild_digest() = 0;
+
          void add_index_extension( std::shared_ptr< index_extension > ext )  { _extensions.push_back( ext ); }
          const index_extensions& get_index_extensions()const  { return _extensions; }
          void* get()const { return _idx_ptr; }
@@ -631,6 +718,12 @@ namespace chainbase {
          virtual size_t size() const override final
             { return _base.indicies().size(); }
 
+         virtual void         enable_digest( bool enable ) override { _base.enable_digest( enable ); }
+         virtual bool         digest_enabled()const override { return _base.digest_enabled(); }
+         virtual bool         digest_valid()const override { return _base.digest_valid(); }
+         virtual index_digest digest()const override { return _base.digest(); }
+         virtual void         rebuild_digest() override { _base.rebuild_digest(); }
+
       private:
          BaseIndex& _base;
    };
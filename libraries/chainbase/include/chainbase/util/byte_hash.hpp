@@ -0,0 +1,57 @@
+#pragma once
+
+#include <boost/multi_index/hashed_index.hpp>
+
+#include <cstring>
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace chainbase
+{
+
+/**
+*  Hash of the object representation of a key, for hashed_unique indices over small fixed size
+*  keys such as account names. Equality lookups on a hashed index touch one bucket instead of
+*  walking log(n) tree nodes.
+*
+*  Only use this for keys without padding whose equal values have equal bytes.
+*/
+template< typename T >
+struct byte_hash
+{
+   size_t operator()( const T& key )const
+   {
+      const char* data = reinterpret_cast< const char* >( &key );
+      uint64_t h = 0x9e3779b97f4a7c15ull ^ sizeof( T );
+
+      size_t i = 0;
+      for( ; i + 8 <= sizeof( T ); i += 8 )
+      {
+         uint64_t word;
+         memcpy( &word, data + i, 8 );
+         h = mix( h ^ word );
+      }
+
+      if( i < sizeof( T ) )
+      {
+         uint64_t word = 0;
+         memcpy( &word, data + i, sizeof( T ) - i );
+         h = mix( h ^ word );
+      }
+
+      return size_t( h );
+   }
+
+   private:
+      static uint64_t mix( uint64_t x )
+      {
+         x ^= x >> 33;
+         x *= 0xff51afd7ed558ccdull;
+         x ^= x >> 33;
+         x *= 0xc4ceb9fe1a85ec53ull;
+         x ^= x >> 33;
+         return x;
+      }
+};
+
+} // namespace chainbase
@@ -2,6 +2,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include <chainbase/chainbase.hpp>
+#include <chainbase/util/byte_hash.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -136,4 +137,132 @@ BOOST_AUTO_TEST_CASE( open_and_create ) {
    }
 }
 
+struct by_title;
+
+struct titled_book : public chainbase::object<1, titled_book> {
+
+   template<typename Constructor, typename Allocator>
+    titled_book(  Constructor&& c, Allocator&& a ) {
+       c(*this);
+    }
+
+    id_type  id;
+    uint64_t title = 0;
+};
+
+typedef multi_index_container<
+  titled_book,
+  indexed_by<
+     ordered_unique< member<titled_book,titled_book::id_type,&titled_book::id> >,
+     hashed_unique< tag<by_title>, member<titled_book,uint64_t,&titled_book::title>, chainbase::byte_hash<uint64_t> >
+  >,
+  chainbase::allocator<titled_book>
+> titled_book_index;
+
+CHAINBASE_SET_INDEX_TYPE( titled_book, titled_book_index )
+
+BOOST_AUTO_TEST_CASE( hashed_index ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db;
+      db.open( temp, 0, 1024*1024*8 );
+      db.add_index< titled_book_index >();
+
+      for( uint64_t i = 0; i < 1000; ++i )
+         db.create< titled_book >( [&]( titled_book& b ) { b.title = i * 7919; } );
+
+      auto has_title = [&]( uint64_t t ) { return db.find< titled_book, by_title >( t ) != nullptr; };
+      auto id_of = [&]( uint64_t t ) { return db.get< titled_book, by_title >( t ).id._id; };
+
+      BOOST_REQUIRE_EQUAL( id_of( 7919 * 5 ), 5 );
+      BOOST_REQUIRE( !has_title( 3 ) );
+
+      {
+         auto session = db.start_undo_session();
+         db.modify( db.get< titled_book, by_title >( 0 ), [&]( titled_book& b ) { b.title = 3; } );
+         db.remove( db.get< titled_book, by_title >( 7919 ) );
+         db.create< titled_book >( [&]( titled_book& b ) { b.title = 4; } );
+
+         BOOST_REQUIRE( !has_title( 0 ) );
+         BOOST_REQUIRE( has_title( 3 ) );
+         BOOST_REQUIRE( !has_title( 7919 ) );
+         BOOST_REQUIRE( has_title( 4 ) );
+      }
+
+      BOOST_REQUIRE_EQUAL( id_of( 0 ), 0 );
+      BOOST_REQUIRE_EQUAL( id_of( 7919 ), 1 );
+      BOOST_REQUIRE( !has_title( 3 ) );
+      BOOST_REQUIRE( !has_title( 4 ) );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
+index_digest hash_titled_book( const titled_book& b )
+{
+   index_digest d;
+   d.lo = byte_hash< uint64_t >()( b.title ) ^ uint64_t( b.id._id );
+   d.hi = byte_hash< uint64_t >()( d.lo );
+   return d;
+}
+
+BOOST_AUTO_TEST_CASE( incremental_digest ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db;
+      db.open( temp, 0, 1024*1024*8 );
+      db.add_index< titled_book_index >();
+      auto& idx = db.get_mutable_index< titled_book_index >();
+
+      // Without a hasher changes invalidate the digest
+      db.create< titled_book >( [&]( titled_book& b ) { b.title = 1; } );
+      BOOST_REQUIRE( !idx.digest_valid() );
+
+      generic_index< titled_book_index >::set_object_hasher( &hash_titled_book );
+      idx.enable_digest( true );
+      BOOST_REQUIRE( idx.digest_valid() );
+
+      for( uint64_t i = 2; i < 100; ++i )
+         db.create< titled_book >( [&]( titled_book& b ) { b.title = i * 7919; } );
+
+      const index_digest base = idx.digest();
+      BOOST_REQUIRE( base != index_digest() );
+
+      {
+         auto session = db.start_undo_session();
+         db.modify( db.get< titled_book, by_title >( 1 ), [&]( titled_book& b ) { b.title = 3; } );
+         db.remove( db.get< titled_book, by_title >( 7919 * 2 ) );
+         db.create< titled_book >( [&]( titled_book& b ) { b.title = 4; } );
+
+         BOOST_REQUIRE( idx.digest() != base );
+         index_digest current = idx.digest();
+         idx.rebuild_digest();
+         BOOST_REQUIRE( idx.digest() == current );
+      }
+
+      BOOST_REQUIRE( idx.digest() == base );
+
+      // Modifying an object back to its original value restores the digest
+      db.modify( db.get< titled_book, by_title >( 1 ), [&]( titled_book& b ) { b.title = 5; } );
+      BOOST_REQUIRE( idx.digest() != base );
+      db.modify( db.get< titled_book, by_title >( 5 ), [&]( titled_book& b ) { b.title = 1; } );
+      BOOST_REQUIRE( idx.digest() == base );
+
+      idx.enable_digest( false );
+      db.create< titled_book >( [&]( titled_book& b ) { b.title = 6; } );
+      BOOST_REQUIRE( !idx.digest_valid() );
+
+      abstract_index* abstract = db.get_abstract_index_cntr()[0];
+      abstract->enable_digest( true );
+      BOOST_REQUIRE( abstract->digest_valid() );
+      BOOST_REQUIRE( abstract->digest() != base );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
 // BOOST_AUTO_TEST_SUITE_END()
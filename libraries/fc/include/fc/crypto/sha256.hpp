@@ -24,6 +24,21 @@ class sha256
     static sha256 hash( const string& );
     static sha256 hash( const sha256& );
 
+    /**
+     * Hash count independent buffers, results[i] = hash( data[i], sizes[i] ).
+     * Uses the x86 SHA extensions when the CPU has them, results are identical either way.
+     */
+    static void hash_many( const char* const* data, const uint32_t* sizes, sha256* results, size_t count );
+
+    /**
+     * Hash count pairs of digests, results[i] = hash( in[2i] || in[2i+1] ), i.e. one level
+     * of a merkle tree. results may alias in.
+     */
+    static void hash_pairs( const sha256* in, sha256* results, size_t count );
+
+    /// True when hash_many() and hash_pairs() run on the SHA extensions
+    static bool has_hardware_acceleration();
+
     template<typename T>
     static sha256 hash( const T& t )
     {
@@ -15,6 +15,7 @@
 #include <fc/io/raw_fwd.hpp>
 #include <map>
 #include <deque>
+#include <algorithm>
 
 namespace fc {
     namespace raw {
@@ -157,45 +158,63 @@ namespace fc {
       fc::raw::unpack( s, *v );
     } FC_RETHROW_EXCEPTIONS( warn, "std::shared_ptr<T>", ("type",fc::get_typename<T>::name()) ) }
 
+    namespace detail {
+      // Encodes into a local buffer so the stream sees a single write
+      template<typename Stream> inline void pack_varint( Stream& s, uint64_t val ) {
+        char buf[10];
+        size_t n = 0;
+        do {
+          uint8_t b = uint8_t(val) & 0x7f;
+          val >>= 7;
+          b |= ((val > 0) << 7);
+          buf[n++] = char(b);
+        } while( val );
+        s.write( buf, n );
+      }
+
+      template<typename Stream> inline uint32_t unpack_varint32( Stream& s ) {
+        uint32_t v = 0; char b = 0; int by = 0;
+        do {
+          s.get(b);
+          v |= uint32_t(uint8_t(b) & 0x7f) << by;
+          by += 7;
+        } while( uint8_t(b) & 0x80 );
+        return v;
+      }
+
+      // Decodes straight from the buffer, encodings longer than 5 bytes take the generic path
+      inline uint32_t unpack_varint32( datastream<const char*>& s ) {
+        const uint8_t* p = (const uint8_t*)s.pos();
+        size_t n = std::min( s.remaining(), size_t(5) );
+        uint32_t v = 0;
+        for( size_t i = 0; i < n; ++i ) {
+          v |= uint32_t(p[i] & 0x7f) << (7*i);
+          if( !(p[i] & 0x80) ) {
+            s.skip( i + 1 );
+            return v;
+          }
+        }
+        return unpack_varint32< datastream<const char*> >( s );
+      }
+    }
+
     template<typename Stream> inline void pack( Stream& s, const signed_int& v ) {
       uint32_t val = (v.value<<1) ^ (v.value>>31);
-      do {
-        uint8_t b = uint8_t(val) & 0x7f;
-        val >>= 7;
-        b |= ((val > 0) << 7);
-        s.write((char*)&b,1);//.put(b);
-      } while( val );
+      detail::pack_varint( s, val );
     }
 
     template<typename Stream> inline void pack( Stream& s, const unsigned_int& v ) {
-      uint64_t val = v.value;
-      do {
-        uint8_t b = uint8_t(val) & 0x7f;
-        val >>= 7;
-        b |= ((val > 0) << 7);
-        s.write((char*)&b,1);//.put(b);
-      }while( val );
+      detail::pack_varint( s, v.value );
     }
 
     template<typename Stream> inline void unpack( Stream& s, signed_int& vi ) {
-      uint32_t v = 0; char b = 0; int by = 0;
-      do {
-        s.get(b);
-        v |= uint32_t(uint8_t(b) & 0x7f) << by;
-        by += 7;
-      } while( uint8_t(b) & 0x80 );
+      uint32_t v = detail::unpack_varint32( s );
       vi.value = ((v>>1) ^ (v>>31)) + (v&0x01);
       vi.value = v&0x01 ? vi.value : -vi.value;
       vi.value = -vi.value;
     }
     template<typename Stream> inline void unpack( Stream& s, unsigned_int& vi ) {
-      uint64_t v = 0; char b = 0; uint8_t by = 0;
-      do {
-          s.get(b);
-          v |= uint32_t(uint8_t(b) & 0x7f) << by;
-          by += 7;
-      } while( uint8_t(b) & 0x80 );
-      vi.value = static_cast<uint32_t>(v);
+      vi.value = detail::unpack_varint32( s );
     }
 
     template<typename Stream, typename T> inline void unpack( Stream& s, const T& vi )
@@ -263,11 +282,11 @@ namespace fc {
     }
 
     template<typename Stream> inline void unpack( Stream& s, fc::string& v )  {
-      std::vector<char> tmp;
-      fc::raw::unpack(s,tmp);
-      if( tmp.size() )
-         v = fc::string(tmp.data(),tmp.data()+tmp.size());
-      else v = fc::string();
+      unsigned_int size; fc::raw::unpack( s, size );
+      FC_ASSERT( size.value < MAX_ARRAY_ALLOC_SIZE );
+      v.resize( size.value );
+      if( v.size() )
+        s.read( &v[0], v.size() );
     }
 
     // bool
@@ -490,15 +509,48 @@ namespace fc {
       }
     }
 
+    namespace detail {
+      template<typename IsTriviallyPackable=std::false_type>
+      struct vector_packer {
+        template<typename Stream, typename T>
+        static inline void pack( Stream& s, const std::vector<T>& value ) {
+          auto itr = value.begin();
+          auto end = value.end();
+          while( itr != end ) {
+            fc::raw::pack( s, *itr );
+            ++itr;
+          }
+        }
+        template<typename Stream, typename T>
+        static inline void unpack( Stream& s, std::vector<T>& value ) {
+          auto itr = value.begin();
+          auto end = value.end();
+          while( itr != end ) {
+            fc::raw::unpack( s, *itr );
+            ++itr;
+          }
+        }
+      };
+
+      template<>
+      struct vector_packer<std::true_type> {
+        template<typename Stream, typename T>
+        static inline void pack( Stream& s, const std::vector<T>& value ) {
+          if( value.size() )
+            s.write( (const char*)value.data(), value.size() * sizeof(T) );
+        }
+        template<typename Stream, typename T>
+        static inline void unpack( Stream& s, std::vector<T>& value ) {
+          if( value.size() )
+            s.read( (char*)value.data(), value.size() * sizeof(T) );
+        }
+      };
+    }
+
     template<typename Stream, typename T>
     inline void pack( Stream& s, const std::vector<T>& value ) {
       fc::raw::pack( s, unsigned_int((uint32_t)value.size()) );
-      auto itr = value.begin();
-      auto end = value.end();
-      while( itr != end ) {
-        fc::raw::pack( s, *itr );
-        ++itr;
-      }
+      detail::vector_packer< typename is_trivially_packable<T>::type >::pack( s, value );
     }
 
     template<typename Stream, typename T>
@@ -506,12 +558,7 @@ namespace fc {
       unsigned_int size; fc::raw::unpack( s, size );
       FC_ASSERT( size.value*sizeof(T) < MAX_ARRAY_ALLOC_SIZE );
       value.resize(size.value);
-      auto itr = value.begin();
-      auto end = value.end();
-      while( itr != end ) {
-        fc::raw::unpack( s, *itr );
-        ++itr;
-      }
+      detail::vector_packer< typename is_trivially_packable<T>::type >::unpack( s, value );
     }
 
     template<typename Stream, typename... T>
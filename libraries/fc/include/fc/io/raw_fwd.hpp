@@ -10,6 +10,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <set>
+#include <type_traits>
 
 #define MAX_ARRAY_ALLOC_SIZE (1024*1024*10) 
 
@@ -27,8 +28,28 @@ namespace fc {
 
    namespace ecc { class public_key; class private_key; }
    template<typename Storage> class fixed_string;
+   class sha1;
+   class sha224;
+   class sha256;
+   class sha512;
+   class ripemd160;
 
    namespace raw {
+    /**
+     *  True for types whose packed form is exactly their bytes in memory, so containers of them are
+     *  packed and unpacked with a single write or read. Only opt in types that pack with one
+     *  s.write( &v, sizeof(v) ) and have no padding.
+     */
+    template<typename T> struct is_trivially_packable
+       : std::integral_constant< bool, std::is_arithmetic<T>::value && !std::is_same<T,bool>::value > {};
+
+    template<typename T, size_t N> struct is_trivially_packable< fc::array<T,N> > : is_trivially_packable<T> {};
+    template<> struct is_trivially_packable< fc::sha1 >      : std::true_type {};
+    template<> struct is_trivially_packable< fc::sha224 >    : std::true_type {};
+    template<> struct is_trivially_packable< fc::sha256 >    : std::true_type {};
+    template<> struct is_trivially_packable< fc::sha512 >    : std::true_type {};
+    template<> struct is_trivially_packable< fc::ripemd160 > : std::true_type {};
+
     template<typename T>
     inline size_t pack_size(  const T& v );
 
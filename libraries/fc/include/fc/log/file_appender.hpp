@@ -18,11 +18,22 @@ class file_appender : public appender {
             bool                               rotate = false;
             microseconds                       rotation_interval;
             microseconds                       rotation_limit;
+
+            /**
+             * Hand messages to a background writer instead of formatting and writing them on the
+             * logging thread. They go through one bounded lock-free queue of async_queue_size
+             * messages owned by the appender, messages that do not fit are dropped and counted.
+             */
+            bool                               async = false;
+            uint32_t                           async_queue_size = 4096;
          };
          file_appender( const variant& args );
          ~file_appender();
          virtual void log( const log_message& m )override;
 
+         /// Messages dropped because the async queue was full
+         uint64_t get_dropped_messages()const;
+
       private:
          class impl;
          fc::shared_ptr<impl> my;
@@ -31,4 +42,4 @@ class file_appender : public appender {
 
 #include <fc/reflect/reflect.hpp>
 FC_REFLECT( fc::file_appender::config,
-            (format)(filename)(flush)(rotate)(rotation_interval)(rotation_limit) )
+            (format)(filename)(flush)(rotate)(rotation_interval)(rotation_limit)(async)(async_queue_size) )
@@ -41,7 +41,9 @@ aes_encoder::~aes_encoder()
 
 void aes_encoder::init( const fc::sha256& key, const fc::uint128& init_value )
 {
-    my->ctx.obj = EVP_CIPHER_CTX_new();
+    // init may be called again to restart the stream with a new key or iv, reuse the context then
+    if(!my->ctx)
+        my->ctx.obj = EVP_CIPHER_CTX_new();
     /* Create and initialise the context */
     if(!my->ctx)
     {
@@ -107,7 +109,9 @@ aes_decoder::aes_decoder()
 
 void aes_decoder::init( const fc::sha256& key, const fc::uint128& init_value )
 {
-    my->ctx.obj = EVP_CIPHER_CTX_new();
+    // init may be called again to restart the stream with a new key or iv, reuse the context then
+    if(!my->ctx)
+        my->ctx.obj = EVP_CIPHER_CTX_new();
     /* Create and initialise the context */
     if(!my->ctx)
     {
@@ -0,0 +1,301 @@
+#include <fc/crypto/sha256.hpp>
+
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FC_SHA256_HAVE_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace fc {
+
+namespace detail {
+
+#ifdef FC_SHA256_HAVE_SHANI
+
+   static const uint32_t sha256_k[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+   };
+
+   static const uint32_t sha256_iv[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+   };
+
+   static bool detect_sha_extensions()
+   {
+      unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+      if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+         return false;
+      if( !( ecx & bit_SSSE3 ) || !( ecx & bit_SSE4_1 ) )
+         return false;
+      if( __get_cpuid_max( 0, nullptr ) < 7 )
+         return false;
+
+      __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+      return ebx & ( 1u << 29 );
+   }
+
+   /**
+    * Message schedule plus round constants of the padding block that follows a 64 byte message.
+    * Merkle tree nodes always hash exactly 64 bytes, so this block never needs expanding at run time.
+    */
+   struct sha256_pad64_schedule
+   {
+      sha256_pad64_schedule()
+      {
+         uint32_t w[64] = { 0x80000000 };
+         w[15] = 512;
+         for( int i = 16; i < 64; ++i )
+         {
+            uint32_t s0 = rotr( w[i-15], 7 ) ^ rotr( w[i-15], 18 ) ^ ( w[i-15] >> 3 );
+            uint32_t s1 = rotr( w[i-2], 17 ) ^ rotr( w[i-2], 19 ) ^ ( w[i-2] >> 10 );
+            w[i] = w[i-16] + s0 + w[i-7] + s1;
+         }
+         for( int i = 0; i < 64; ++i )
+            wk[i] = w[i] + sha256_k[i];
+      }
+
+      static uint32_t rotr( uint32_t x, int n ) { return ( x >> n ) | ( x << ( 32 - n ) ); }
+
+      uint32_t wk[64];
+   };
+
+   static const sha256_pad64_schedule sha256_pad64;
+
+   /**
+    * Runs the compression function over one 64 byte block for each of N independent lanes using
+    * the SHA extensions. Interleaving the lanes hides the latency of the round instructions. The
+    * state is kept in the ABEF/CDGH layout the instructions expect.
+    */
+   template< int N >
+   __attribute__((target("sha,sse4.1,ssse3")))
+   static inline void sha256_compress_shani( __m128i* state0, __m128i* state1, const uint8_t* const* data )
+   {
+      const __m128i byte_swap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+      __m128i abef_save[N];
+      __m128i cdgh_save[N];
+      __m128i w[N][4];
+
+      for( int l = 0; l < N; ++l )
+      {
+         abef_save[l] = state0[l];
+         cdgh_save[l] = state1[l];
+      }
+
+#pragma GCC unroll 16
+      for( int i = 0; i < 16; ++i )
+      {
+         __m128i k = _mm_loadu_si128( (const __m128i*)( sha256_k + 4 * i ) );
+
+         for( int l = 0; l < N; ++l )
+         {
+            __m128i& cur = w[l][ i & 3 ];
+
+            if( i < 4 )
+            {
+               cur = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)( data[l] + 16 * i ) ), byte_swap );
+            }
+            else
+            {
+               const __m128i& w1 = w[l][ ( i + 1 ) & 3 ];
+               const __m128i& w2 = w[l][ ( i + 2 ) & 3 ];
+               const __m128i& w3 = w[l][ ( i + 3 ) & 3 ];
+               cur = _mm_sha256msg2_epu32(
+                  _mm_add_epi32( _mm_sha256msg1_epu32( cur, w1 ), _mm_alignr_epi8( w3, w2, 4 ) ), w3 );
+            }
+
+            __m128i msg = _mm_add_epi32( cur, k );
+            state1[l] = _mm_sha256rnds2_epu32( state1[l], state0[l], msg );
+            msg = _mm_shuffle_epi32( msg, 0x0E );
+            state0[l] = _mm_sha256rnds2_epu32( state0[l], state1[l], msg );
+         }
+      }
+
+      for( int l = 0; l < N; ++l )
+      {
+         state0[l] = _mm_add_epi32( state0[l], abef_save[l] );
+         state1[l] = _mm_add_epi32( state1[l], cdgh_save[l] );
+      }
+   }
+
+   /// Compresses the padding block of a 64 byte message, its schedule is precomputed
+   template< int N >
+   __attribute__((target("sha,sse4.1,ssse3")))
+   static inline void sha256_compress_pad64_shani( __m128i* state0, __m128i* state1 )
+   {
+      __m128i abef_save[N];
+      __m128i cdgh_save[N];
+
+      for( int l = 0; l < N; ++l )
+      {
+         abef_save[l] = state0[l];
+         cdgh_save[l] = state1[l];
+      }
+
+#pragma GCC unroll 16
+      for( int i = 0; i < 16; ++i )
+      {
+         __m128i msg = _mm_loadu_si128( (const __m128i*)( sha256_pad64.wk + 4 * i ) );
+         __m128i msg_hi = _mm_shuffle_epi32( msg, 0x0E );
+
+         for( int l = 0; l < N; ++l )
+         {
+            state1[l] = _mm_sha256rnds2_epu32( state1[l], state0[l], msg );
+            state0[l] = _mm_sha256rnds2_epu32( state0[l], state1[l], msg_hi );
+         }
+      }
+
+      for( int l = 0; l < N; ++l )
+      {
+         state0[l] = _mm_add_epi32( state0[l], abef_save[l] );
+         state1[l] = _mm_add_epi32( state1[l], cdgh_save[l] );
+      }
+   }
+
+   __attribute__((target("sha,sse4.1,ssse3")))
+   static inline void sha256_init_shani( __m128i& state0, __m128i& state1 )
+   {
+      __m128i tmp = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*)&sha256_iv[0] ), 0xB1 );  // CDAB
+      state1 = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*)&sha256_iv[4] ), 0x1B );       // EFGH
+      state0 = _mm_alignr_epi8( tmp, state1, 8 );                                                // ABEF
+      state1 = _mm_blend_epi16( state1, tmp, 0xF0 );                                             // CDGH
+   }
+
+   __attribute__((target("sha,sse4.1,ssse3")))
+   static inline void sha256_final_shani( __m128i state0, __m128i state1, sha256& result )
+   {
+      __m128i tmp = _mm_shuffle_epi32( state0, 0x1B );  // FEBA
+      state1 = _mm_shuffle_epi32( state1, 0xB1 );       // DCHG
+      state0 = _mm_blend_epi16( tmp, state1, 0xF0 );    // DCBA
+      state1 = _mm_alignr_epi8( state1, tmp, 8 );       // HGFE
+
+      // The digest is the state words in big endian order
+      const __m128i byte_swap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+      _mm_storeu_si128( (__m128i*)( result.data() ),      _mm_shuffle_epi8( state0, byte_swap ) );
+      _mm_storeu_si128( (__m128i*)( result.data() + 16 ), _mm_shuffle_epi8( state1, byte_swap ) );
+   }
+
+   __attribute__((target("sha,sse4.1,ssse3")))
+   static void sha256_shani( const char* d, size_t dlen, sha256& result )
+   {
+      __m128i state0, state1;
+      sha256_init_shani( state0, state1 );
+
+      const uint8_t* data = (const uint8_t*)d;
+      size_t full_blocks = dlen / 64;
+      for( size_t i = 0; i < full_blocks; ++i, data += 64 )
+         sha256_compress_shani< 1 >( &state0, &state1, &data );
+
+      // Final one or two blocks: the remaining bytes, 0x80, zero padding and the big endian bit length
+      uint8_t tail[128];
+      size_t rem = dlen - full_blocks * 64;
+      size_t tail_len = rem < 56 ? 64 : 128;
+      memset( tail, 0, tail_len );
+      memcpy( tail, data, rem );
+      tail[ rem ] = 0x80;
+      uint64_t bits = uint64_t( dlen ) * 8;
+      for( int i = 0; i < 8; ++i )
+         tail[ tail_len - 1 - i ] = uint8_t( bits >> ( 8 * i ) );
+
+      for( size_t off = 0; off < tail_len; off += 64 )
+      {
+         const uint8_t* block = tail + off;
+         sha256_compress_shani< 1 >( &state0, &state1, &block );
+      }
+
+      sha256_final_shani( state0, state1, result );
+   }
+
+   /// Hashes two independent 64 byte messages, results may alias the inputs
+   __attribute__((target("sha,sse4.1,ssse3")))
+   static void sha256_pair_x2_shani( const uint8_t* a, const uint8_t* b, sha256& result_a, sha256& result_b )
+   {
+      __m128i state0[2], state1[2];
+      sha256_init_shani( state0[0], state1[0] );
+      state0[1] = state0[0];
+      state1[1] = state1[0];
+
+      const uint8_t* data[2] = { a, b };
+      sha256_compress_shani< 2 >( state0, state1, data );
+      sha256_compress_pad64_shani< 2 >( state0, state1 );
+
+      sha256_final_shani( state0[0], state1[0], result_a );
+      sha256_final_shani( state0[1], state1[1], result_b );
+   }
+
+   __attribute__((target("sha,sse4.1,ssse3")))
+   static void sha256_pair_shani( const uint8_t* a, sha256& result )
+   {
+      __m128i state0, state1;
+      sha256_init_shani( state0, state1 );
+      sha256_compress_shani< 1 >( &state0, &state1, &a );
+      sha256_compress_pad64_shani< 1 >( &state0, &state1 );
+      sha256_final_shani( state0, state1, result );
+   }
+
+   static const bool sha256_use_shani = detect_sha_extensions();
+
+#endif
+
+} // detail
+
+bool sha256::has_hardware_acceleration()
+{
+#ifdef FC_SHA256_HAVE_SHANI
+   return detail::sha256_use_shani;
+#else
+   return false;
+#endif
+}
+
+void sha256::hash_many( const char* const* data, const uint32_t* sizes, sha256* results, size_t count )
+{
+#ifdef FC_SHA256_HAVE_SHANI
+   if( detail::sha256_use_shani )
+   {
+      for( size_t i = 0; i < count; ++i )
+         detail::sha256_shani( data[i], sizes[i], results[i] );
+      return;
+   }
+#endif
+
+   for( size_t i = 0; i < count; ++i )
+      results[i] = hash( data[i], sizes[i] );
+}
+
+void sha256::hash_pairs( const sha256* in, sha256* results, size_t count )
+{
+   static_assert( sizeof( sha256 ) == 32, "digest pairs must be contiguous 64 byte blocks" );
+
+#ifdef FC_SHA256_HAVE_SHANI
+   if( detail::sha256_use_shani )
+   {
+      // Both lanes are compressed before either result is stored, so results may alias in
+      size_t i = 0;
+      for( ; i + 1 < count; i += 2 )
+         detail::sha256_pair_x2_shani( (const uint8_t*)in[ 2 * i ].data(), (const uint8_t*)in[ 2 * i + 2 ].data(), results[i], results[i + 1] );
+      if( i < count )
+         detail::sha256_pair_shani( (const uint8_t*)in[ 2 * i ].data(), results[i] );
+      return;
+   }
+#endif
+
+   for( size_t i = 0; i < count; ++i )
+   {
+      encoder e;
+      e.write( in[ 2 * i ].data(), 32 );
+      e.write( in[ 2 * i + 1 ].data(), 32 );
+      results[i] = e.result();
+   }
+}
+
+} // fc
@@ -5,25 +5,144 @@
 #include <fc/thread/scoped_lock.hpp>
 #include <fc/thread/thread.hpp>
 #include <fc/variant.hpp>
+#include <boost/lockfree/queue.hpp>
 #include <boost/thread/mutex.hpp>
-#include <iomanip>
-#include <queue>
-#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace fc {
 
+   namespace detail
+   {
+      static void append_padded( std::string& out, const char* s, size_t width )
+      {
+         size_t len = strlen( s );
+         if( len < width )
+            out.append( width - len, ' ' );
+         out.append( s, len );
+      }
+
+      // MS THREAD METHOD  MESSAGE \t\t\t File:Line
+      static void format_log_line( const log_message& m, std::string& line )
+      {
+         log_context context = m.get_context();
+
+         line += string( context.get_timestamp() );
+         line += ' ';
+         append_padded( line, context.get_task_name().c_str(), 21 );
+         line += ' ';
+
+         string method_name = context.get_method();
+         // strip all leading scopes...
+         if( method_name.size() )
+         {
+            uint32_t p = 0;
+            for( uint32_t i = 0;i < method_name.size(); ++i )
+            {
+                if( method_name[i] == ':' ) p = i;
+            }
+
+            if( method_name[p] == ':' )
+              ++p;
+            append_padded( line, method_name.substr( p, 20 ).c_str(), 20 );
+            line += ' ';
+         }
+
+         line += "] ";
+         line += fc::format_string( m.get_format(), m.get_data() ).c_str();
+         line += "\t\t\t";
+         line += context.get_file();
+         line += ':';
+         line += std::to_string( context.get_line_number() );
+         line += '\n';
+      }
+   }
+
    class file_appender::impl : public fc::retainable
    {
       public:
          config                     cfg;
          ofstream                   out;
          boost::mutex               slock;
+         std::atomic< uint64_t >    dropped_messages;
 
       private:
          future<void>               _rotation_task;
          time_point_sec             _current_file_start_time;
 
+         /// Owned by the appender, any thread pushes and only the writer pops
+         typedef boost::lockfree::queue< log_message* > async_queue;
+
+         std::unique_ptr< async_queue >   _queue;
+         std::mutex                       _writer_mutex;
+         std::condition_variable          _writer_wakeup;
+         std::atomic< bool >              _writer_stopping;
+         std::thread                      _writer;
+         uint64_t                         _reported_dropped_messages = 0;
+         std::string                      _write_buffer;
+
+         /// Formats what is queued, at most one queue's worth, and writes it with a single locked write
+         bool write_queued()
+         {
+            _write_buffer.clear();
+
+            log_message* m = nullptr;
+            for( uint32_t i = 0; i < cfg.async_queue_size && _queue->pop( m ); ++i )
+            {
+               std::unique_ptr< log_message > owned( m );
+               detail::format_log_line( *owned, _write_buffer );
+            }
+
+            uint64_t dropped = dropped_messages.load( std::memory_order_relaxed );
+            if( dropped != _reported_dropped_messages )
+            {
+               _write_buffer += string( time_point::now() ) + " dropped " + std::to_string( dropped - _reported_dropped_messages )
+                  + " log messages, async queue full\n";
+               _reported_dropped_messages = dropped;
+            }
+
+            if( _write_buffer.empty() )
+               return false;
+
+            fc::scoped_lock<boost::mutex> lock( slock );
+            out.write( _write_buffer.data(), _write_buffer.size() );
+            if( cfg.flush )
+               out.flush();
+            return true;
+         }
+
+         void run_writer()
+         {
+            while( !_writer_stopping.load() )
+            {
+               try
+               {
+                  if( write_queued() )
+                     continue;
+               }
+               catch( ... )
+               {
+               }
+
+               std::unique_lock< std::mutex > lock( _writer_mutex );
+               _writer_wakeup.wait_for( lock, std::chrono::milliseconds( 10 ) );
+            }
+
+            try
+            {
+               while( write_queued() );
+            }
+            catch( ... )
+            {
+            }
+         }
+
          time_point_sec get_file_start_time( const time_point_sec& timestamp, const microseconds& interval )
          {
              int64_t interval_seconds = interval.to_seconds();
@@ -32,8 +151,15 @@ namespace fc {
          }
 
       public:
-         impl( const config& c) : cfg( c )
+         impl( const config& c) : cfg( c ), dropped_messages( 0 ), _writer_stopping( false )
          {
+             if( cfg.async )
+             {
+                 FC_ASSERT( cfg.async_queue_size > 0 );
+                 _queue.reset( new async_queue( cfg.async_queue_size ) );
+                 _writer = std::thread( [this]() { run_writer(); } );
+             }
+
              if( cfg.rotate )
              {
                  FC_ASSERT( cfg.rotation_interval >= seconds( 1 ) );
@@ -48,6 +174,18 @@ namespace fc {
 
          ~impl()
          {
+            if( _writer.joinable() )
+            {
+               _writer_stopping.store( true );
+               _writer_wakeup.notify_one();
+               _writer.join();
+            }
+
+            // Only left over if the writer failed, nothing can push once the appender is destroyed
+            log_message* m = nullptr;
+            while( _queue && _queue->pop( m ) )
+               delete m;
+
             try
             {
               _rotation_task.cancel_and_wait("file_appender is destructing");
@@ -57,6 +195,28 @@ namespace fc {
             }
          }
 
+         void log( const log_message& m )
+         {
+            if( cfg.async )
+            {
+               std::unique_ptr< log_message > queued( new log_message( m ) );
+               if( _queue->bounded_push( queued.get() ) )
+                  queued.release();
+               else
+                  dropped_messages.fetch_add( 1, std::memory_order_relaxed );
+               return;
+            }
+
+            std::string line;
+            line.reserve( 256 );
+            detail::format_log_line( m, line );
+
+            fc::scoped_lock<boost::mutex> lock( slock );
+            out.write( line.data(), line.size() );
+            if( cfg.flush )
+              out.flush();
+         }
+
          void rotate_files( bool initializing = false )
          {
              FC_ASSERT( cfg.rotate );
@@ -157,43 +317,14 @@ namespace fc {
 
    file_appender::~file_appender(){}
 
-   // MS THREAD METHOD  MESSAGE \t\t\t File:Line
    void file_appender::log( const log_message& m )
    {
-      std::stringstream line;
-      //line << (m.get_context().get_timestamp().time_since_epoch().count() % (1000ll*1000ll*60ll*60))/1000 <<"ms ";
-      line << string(m.get_context().get_timestamp()) << " ";
-      line << std::setw( 21 ) << (m.get_context().get_task_name()).c_str() << " ";
-
-      string method_name = m.get_context().get_method();
-      // strip all leading scopes...
-      if( method_name.size() )
-      {
-         uint32_t p = 0;
-         for( uint32_t i = 0;i < method_name.size(); ++i )
-         {
-             if( method_name[i] == ':' ) p = i;
-         }
-
-         if( method_name[p] == ':' )
-           ++p;
-         line << std::setw( 20 ) << m.get_context().get_method().substr(p,20).c_str() <<" ";
-      }
-
-      line << "] ";
-      fc::string message = fc::format_string( m.get_format(), m.get_data() );
-      line << message.c_str();
-
-      //fc::variant lmsg(m);
-
-      // fc::string fmt_str = fc::format_string( my->cfg.format, mutable_variant_object(m.get_context())( "message", message)  );
+      my->log( m );
+   }
 
-      {
-        fc::scoped_lock<boost::mutex> lock( my->slock );
-        my->out << line.str() << "\t\t\t" << m.get_context().get_file() << ":" << m.get_context().get_line_number() << "\n";
-        if( my->cfg.flush )
-          my->out.flush();
-      }
+   uint64_t file_appender::get_dropped_messages()const
+   {
+      return my->dropped_messages.load( std::memory_order_relaxed );
    }
 
 } // fc
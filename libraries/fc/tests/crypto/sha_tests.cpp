@@ -9,6 +9,7 @@
 #include <fc/exception/exception.hpp>
 
 #include <iostream>
+#include <vector>
 
 // SHA test vectors taken from http://www.di-mgt.com.au/sha_testvectors.html
 static const std::string TEST1("abc");
@@ -157,6 +158,55 @@ BOOST_AUTO_TEST_CASE(sha256_test)
     BOOST_CHECK_EQUAL( "d61967f63c7dd183914a4ae452c9f6ad5d462ce3d277798075b107615c1a8a30", (std::string) fc::sha256::hash(fourth) );
 }
 
+BOOST_AUTO_TEST_CASE(sha256_batch_test)
+{
+    BOOST_TEST_MESSAGE( "sha256 hardware acceleration: " << fc::sha256::has_hardware_acceleration() );
+
+    // Every length up to five blocks, so each padding case is covered
+    std::vector< std::string > inputs;
+    for( uint32_t len = 0; len <= 320; len++ )
+    {
+        std::string s( len, 0 );
+        for( uint32_t i = 0; i < len; i++ )
+            s[i] = char( ( i * 131 + len * 7 ) & 0xff );
+        inputs.push_back( s );
+    }
+    inputs.push_back( TEST3 );
+    inputs.push_back( TEST4 );
+
+    std::vector< const char* > data;
+    std::vector< uint32_t > sizes;
+    for( const auto& s : inputs )
+    {
+        data.push_back( s.data() );
+        sizes.push_back( s.size() );
+    }
+
+    std::vector< fc::sha256 > results( inputs.size() );
+    fc::sha256::hash_many( data.data(), sizes.data(), results.data(), results.size() );
+    for( size_t i = 0; i < inputs.size(); i++ )
+        BOOST_CHECK( results[i] == fc::sha256::hash( inputs[i] ) );
+    BOOST_CHECK_EQUAL( "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", (std::string) results[ inputs.size() - 2 ] );
+
+    // Odd and even pair counts, both into a separate buffer and in place
+    for( size_t count : { size_t(1), size_t(2), size_t(3), size_t(7), size_t(64) } )
+    {
+        std::vector< fc::sha256 > leaves( results.begin(), results.begin() + 2 * count );
+        std::vector< fc::sha256 > expected( count );
+        for( size_t i = 0; i < count; i++ )
+            expected[i] = fc::sha256::hash( std::make_pair( leaves[ 2 * i ], leaves[ 2 * i + 1 ] ) );
+
+        std::vector< fc::sha256 > out( count );
+        fc::sha256::hash_pairs( leaves.data(), out.data(), count );
+        fc::sha256::hash_pairs( leaves.data(), leaves.data(), count );
+        for( size_t i = 0; i < count; i++ )
+        {
+            BOOST_CHECK( out[i] == expected[i] );
+            BOOST_CHECK( leaves[i] == expected[i] );
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(sha512_test)
 {
     init_5();
@@ -0,0 +1,205 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/log/file_appender.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/variant.hpp>
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fc;
+
+static std::vector< std::string > read_lines( const fc::path& p )
+{
+   std::vector< std::string > lines;
+   std::ifstream in( p.string() );
+   std::string line;
+   while( std::getline( in, line ) )
+      lines.push_back( line );
+   return lines;
+}
+
+static log_message make_message( uint32_t thread, uint32_t i )
+{
+   return log_message( FC_LOG_CONTEXT( info ), "thread ${t} message ${i}", mutable_variant_object()( "t", thread )( "i", i ) );
+}
+
+BOOST_AUTO_TEST_SUITE(fc_log)
+
+BOOST_AUTO_TEST_CASE(file_appender_sync_format)
+{
+   temp_directory dir;
+   file_appender::config cfg( dir.path() / "sync.log" );
+
+   {
+      fc::shared_ptr< file_appender > appender( new file_appender( variant( cfg ) ) );
+      appender->log( make_message( 0, 7 ) );
+   }
+
+   auto lines = read_lines( cfg.filename );
+   BOOST_REQUIRE_EQUAL( lines.size(), 1u );
+   BOOST_CHECK( lines[0].find( "] thread 0 message 7\t\t\t" ) != std::string::npos );
+   BOOST_CHECK( lines[0].find( "file_appender_test.cpp:" ) != std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE(file_appender_async)
+{
+   temp_directory dir;
+   file_appender::config cfg( dir.path() / "async.log" );
+   cfg.async = true;
+   cfg.async_queue_size = 1 << 16;
+
+   const uint32_t threads = 4;
+   const uint32_t messages = 10000;
+   uint64_t dropped = 0;
+
+   {
+      fc::shared_ptr< file_appender > appender( new file_appender( variant( cfg ) ) );
+
+      std::vector< std::thread > loggers;
+      for( uint32_t t = 0; t < threads; ++t )
+         loggers.emplace_back( [&appender, t, messages]()
+         {
+            for( uint32_t i = 0; i < messages; ++i )
+               appender->log( make_message( t, i ) );
+         });
+
+      for( auto& l : loggers )
+         l.join();
+
+      dropped = appender->get_dropped_messages();
+   }
+
+   BOOST_CHECK_EQUAL( dropped, 0u );
+
+   // Every message is written once and each thread's messages keep their order
+   auto lines = read_lines( cfg.filename );
+   BOOST_REQUIRE_EQUAL( lines.size(), threads * messages );
+
+   std::vector< uint32_t > next( threads, 0 );
+   for( const auto& line : lines )
+   {
+      auto pos = line.find( "] thread " );
+      BOOST_REQUIRE( pos != std::string::npos );
+      uint32_t t = 0, i = 0;
+      BOOST_REQUIRE_EQUAL( sscanf( line.c_str() + pos, "] thread %u message %u", &t, &i ), 2 );
+      BOOST_REQUIRE( t < threads );
+      BOOST_CHECK_EQUAL( i, next[t] );
+      next[t] = i + 1;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(file_appender_async_drop)
+{
+   temp_directory dir;
+   file_appender::config cfg( dir.path() / "drop.log" );
+   cfg.async = true;
+   cfg.async_queue_size = 1;
+
+   uint64_t dropped = 0;
+   const uint32_t messages = 100000;
+
+   {
+      fc::shared_ptr< file_appender > appender( new file_appender( variant( cfg ) ) );
+      for( uint32_t i = 0; i < messages; ++i )
+         appender->log( make_message( 0, i ) );
+      dropped = appender->get_dropped_messages();
+   }
+
+   // The writer cannot keep up with a one message queue, what does not fit is counted and reported
+   BOOST_CHECK( dropped > 0 );
+
+   uint64_t written = 0, reported = 0;
+   for( const auto& line : read_lines( cfg.filename ) )
+   {
+      unsigned long long n = 0;
+      auto pos = line.find( " dropped " );
+      if( pos != std::string::npos && sscanf( line.c_str() + pos, " dropped %llu log messages", &n ) == 1 )
+         reported += n;
+      else
+         ++written;
+   }
+
+   BOOST_CHECK_EQUAL( reported, dropped );
+   BOOST_CHECK_EQUAL( written + dropped, messages );
+}
+
+BOOST_AUTO_TEST_CASE(file_appender_async_outlived_by_threads)
+{
+   temp_directory dir;
+   const uint32_t messages = 1000;
+
+   // The same threads log into one appender after another, nothing of a destroyed appender stays behind
+   std::mutex mtx;
+   std::condition_variable cv;
+   fc::shared_ptr< file_appender > appender;
+   uint32_t round = 0, done = 0;
+   bool stop = false;
+
+   std::vector< std::thread > loggers;
+   for( uint32_t t = 0; t < 2; ++t )
+      loggers.emplace_back( [&, t]()
+      {
+         for( uint32_t seen = 0; ; )
+         {
+            fc::shared_ptr< file_appender > a;
+            {
+               std::unique_lock< std::mutex > lock( mtx );
+               cv.wait( lock, [&]{ return stop || round != seen; } );
+               if( stop )
+                  return;
+               seen = round;
+               a = appender;
+            }
+
+            for( uint32_t i = 0; i < messages; ++i )
+               a->log( make_message( t, i ) );
+            a.reset();
+
+            std::lock_guard< std::mutex > lock( mtx );
+            ++done;
+            cv.notify_all();
+         }
+      });
+
+   for( uint32_t r = 0; r < 3; ++r )
+   {
+      file_appender::config cfg( dir.path() / ( "round" + std::to_string( r ) + ".log" ) );
+      cfg.async = true;
+      cfg.async_queue_size = 1 << 12;
+
+      {
+         std::unique_lock< std::mutex > lock( mtx );
+         appender.reset( new file_appender( variant( cfg ) ) );
+         done = 0;
+         ++round;
+         cv.notify_all();
+         cv.wait( lock, [&]{ return done == loggers.size(); } );
+      }
+
+      uint64_t dropped = appender->get_dropped_messages();
+      appender.reset();
+
+      uint64_t written = 0;
+      for( const auto& line : read_lines( cfg.filename ) )
+         if( line.find( "] thread " ) != std::string::npos )
+            ++written;
+      BOOST_CHECK_EQUAL( written + dropped, loggers.size() * messages );
+   }
+
+   {
+      std::lock_guard< std::mutex > lock( mtx );
+      stop = true;
+      cv.notify_all();
+   }
+   for( auto& l : loggers )
+      l.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
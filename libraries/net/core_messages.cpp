@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #include <graphene/net/core_messages.hpp>
+#include <graphene/net/message.hpp>
 
 
 namespace graphene { namespace net {
@@ -45,6 +46,45 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum get_block_transactions_message::type          = core_message_type_enum::get_block_transactions_message_type;
+  const core_message_type_enum block_transactions_message::type              = core_message_type_enum::block_transactions_message_type;
+
+  short_transaction_id_type get_short_transaction_id( const transaction_id_type& transaction_id )
+  {
+    short_transaction_id_type short_id;
+    memcpy( (char*)&short_id, transaction_id.data(), sizeof(short_id) );
+    return short_id;
+  }
+
+  compact_block_message::compact_block_message(const signed_block& block, const block_id_type& block_id) :
+    header(block),
+    block_id(block_id)
+  {
+    short_transaction_ids.reserve( block.transactions.size() );
+    for( const signed_transaction& trx : block.transactions )
+      short_transaction_ids.push_back( get_short_transaction_id( trx.id() ) );
+  }
+
+  void received_message::decode()
+  {
+    hash = id();
+    block.reset();
+    trx.reset();
+
+    // a message that fails to unpack is left for the node, which rejects it the same way it
+    // would have without the decode step
+    try
+    {
+      if( msg_type == block_message_type )
+        block = std::make_shared<const block_message>( as<block_message>() );
+      else if( msg_type == trx_message_type )
+        trx = std::make_shared<const trx_message>( as<trx_message>() );
+    }
+    catch( const fc::exception& )
+    {
+    }
+  }
 
 } } // graphene::net
 
@@ -39,6 +39,19 @@
 #define MAX_MESSAGE_SIZE                                     1024*1024*2
 #define GRAPHENE_NET_DEFAULT_PEER_CONNECTION_RETRY_TIME      30 // seconds
 
+/**
+ * bytes read from or written to a peer's socket, and encrypted or decrypted, per call.
+ * Nodes that relay large blocks can raise this through the p2p parameters.
+ */
+#define GRAPHENE_NET_DEFAULT_SOCKET_BUFFER_SIZE              4096
+#define GRAPHENE_NET_MAX_SOCKET_BUFFER_SIZE                  (MAX_MESSAGE_SIZE + 16)
+
+/**
+ * when the node has decode threads, incoming messages with at least this many body bytes are
+ * decrypted and unpacked on them.  Handing off smaller ones costs more than it saves.
+ */
+#define GRAPHENE_NET_MIN_DECODE_THREAD_MESSAGE_SIZE          256
+
 /**
  * AFter trying all peers, how long to wait before we check to
  * see if there are peers we can try again.
@@ -79,6 +92,17 @@
 
 #define GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES           2
 
+/**
+ * The transactions we advertised to each peer are remembered in a pair of
+ * rolling bloom filters instead of an exact set.  Each filter holds this many
+ * items (or GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES worth) before the older
+ * one is dropped.  A false positive means we skip advertising a transaction to
+ * a peer, which will still hear about it from its other peers.  Blocks are
+ * few and must never be skipped, so they stay in an exact set.
+ */
+#define GRAPHENE_NET_INVENTORY_FILTER_ITEMS_PER_GENERATION   20000
+#define GRAPHENE_NET_INVENTORY_FILTER_FALSE_POSITIVE_RATE    0.00001
+
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
 /**
@@ -104,9 +128,26 @@
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
 
+/**
+ * Each peer may hand us this many transactions per second, in bursts of up
+ * to GRAPHENE_NET_TRX_BURST_SECONDS worth, before we drop its transactions
+ * unprocessed.  Transactions the client rejects are counted against a much
+ * smaller budget, and a peer that exhausts it is disconnected.
+ */
+#define GRAPHENE_NET_MAX_TRX_PER_SECOND_PER_PEER             200
+#define GRAPHENE_NET_TRX_BURST_SECONDS                       5
+#define GRAPHENE_NET_MAX_REJECTED_TRX_PER_SECOND_PER_PEER    2
+#define GRAPHENE_NET_REJECTED_TRX_BURST_SECONDS              60
+
 #define GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME 200
 #define GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_PREFETCH           (10 * GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME)
 
+/**
+ * The most consecutive sync blocks handed to the client in one call, it applies each run under one
+ * hold of its write lock.  Keep it at or below GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME.
+ */
+#define GRAPHENE_NET_MAX_SYNC_BLOCKS_PER_RUN                    50
+
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
 
 /**
@@ -137,3 +178,21 @@
 #define GRAPHENE_NET_PORT_WAIT_DELAY_SECONDS                   5
 
 #define GRAPHENE_NET_MAX_PEERDB_SIZE                           1000
+
+/**
+ * The peer database file starts with this magic number and version, followed
+ * by a journal of raw-packed record updates and erases.  The journal is
+ * rewritten once it holds this many times as many entries as the database
+ * has peers (or GRAPHENE_NET_MAX_PEERDB_SIZE, whichever is more).
+ */
+#define GRAPHENE_NET_PEERDB_MAGIC                              0x42445047 // "GPDB"
+#define GRAPHENE_NET_PEERDB_VERSION                            1
+#define GRAPHENE_NET_PEERDB_JOURNAL_COMPACTION_FACTOR          4
+/** how often the node writes peer database changes to the journal */
+#define GRAPHENE_NET_PEERDB_FLUSH_INTERVAL_SECONDS             30
+
+/**
+ * A peer's sync throughput is only recorded in the peer database once it has
+ * sent us at least this many bytes of sync blocks during a connection.
+ */
+#define GRAPHENE_NET_MIN_SYNC_BYTES_FOR_THROUGHPUT             (1024 * 1024)
@@ -44,6 +44,7 @@ namespace graphene { namespace net {
   using steem::protocol::block_id_type;
   using steem::protocol::transaction_id_type;
   using steem::protocol::signed_block;
+  using steem::protocol::signed_block_header;
 
   typedef fc::ecc::public_key_data node_id_t;
   typedef fc::ripemd160 item_hash_t;
@@ -86,6 +87,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    get_block_transactions_message_type          = 5019,
+    block_transactions_message_type              = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -397,6 +401,48 @@ namespace graphene { namespace net {
     std::vector<current_connection_data> current_connections;
   };
 
+  /**
+   * The first 8 bytes of a transaction id.  Compact blocks list their transactions by short id,
+   * which the receiver looks up among the transactions it already has.
+   */
+  typedef uint64_t short_transaction_id_type;
+
+  short_transaction_id_type get_short_transaction_id( const transaction_id_type& transaction_id );
+
+  /**
+   * Sent in place of a block_message to peers that announced "compact_blocks" in their hello.
+   * It carries the signed header and the short ids of the block's transactions, in block order.
+   */
+  struct compact_block_message
+  {
+    static const core_message_type_enum type;
+
+    signed_block_header                      header;
+    block_id_type                            block_id;
+    std::vector<short_transaction_id_type>   short_transaction_ids;
+
+    compact_block_message() {}
+    compact_block_message(const signed_block& block, const block_id_type& block_id);
+  };
+
+  /** Asks for the transactions of a compact block the requester could not find, by index in the block */
+  struct get_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type           block_id;
+    std::vector<uint32_t>   transaction_indexes;
+  };
+
+  /** The reply to get_block_transactions_message, the transactions in the order they were asked for */
+  struct block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type                     block_id;
+    std::vector<signed_transaction>   transactions;
+  };
+
 
 } } // graphene::net
 
@@ -421,6 +467,9 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (get_block_transactions_message_type)
+                 (block_transactions_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
@@ -504,6 +553,9 @@ FC_REFLECT(graphene::net::get_current_connections_reply_message, (upload_rate_on
                                                             (upload_rate_one_hour)
                                                             (download_rate_one_hour)
                                                             (current_connections))
+FC_REFLECT(graphene::net::compact_block_message, (header)(block_id)(short_transaction_ids))
+FC_REFLECT(graphene::net::get_block_transactions_message, (block_id)(transaction_indexes))
+FC_REFLECT(graphene::net::block_transactions_message, (block_id)(transactions))
 
 #include <unordered_map>
 #include <fc/crypto/city.hpp>
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/net/core_messages.hpp>
+
+#include <fc/bloom_filter.hpp>
+#include <fc/time.hpp>
+
+namespace graphene { namespace net {
+
+  /**
+   *  Remembers recently seen inventory approximately, in memory that does not grow with the
+   *  transaction rate.  Items go into the current of two bloom filters.  Once it holds
+   *  items_per_generation items or is older than generation_duration, the older filter is
+   *  dropped and the current one takes its place, so every item is remembered for at least
+   *  one full generation.  contains() never misses a remembered item but answers true for an
+   *  unseen one at about false_positive_rate.
+   */
+  class rolling_inventory_filter
+  {
+  public:
+    rolling_inventory_filter(uint32_t items_per_generation, double false_positive_rate,
+                             const fc::microseconds& generation_duration);
+
+    void insert(const item_id& item);
+    bool contains(const item_id& item) const;
+
+    /** Starts a new generation if the current one has been filling for longer than generation_duration */
+    void expire_old_generation();
+
+    /** Number of items inserted in the two live generations */
+    size_t size() const;
+
+  private:
+    void rotate();
+
+    fc::bloom_filter _current;
+    fc::bloom_filter _previous;
+    uint32_t         _items_per_generation;
+    fc::microseconds _generation_duration;
+    fc::time_point   _current_generation_start;
+  };
+
+} } // graphene::net
@@ -29,6 +29,8 @@
 #include <fc/crypto/ripemd160.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <memory>
+
 namespace graphene { namespace net {
 
   /**
@@ -108,8 +110,29 @@ namespace graphene { namespace net {
      }
   };
 
+  /**
+   *  A message that is never modified once built, so one copy can sit in the send queues of
+   *  every peer it is going to.
+   */
+  typedef std::shared_ptr<const message> message_ptr;
+
+  struct block_message;
+  struct trx_message;
 
+  /**
+   *  A message as it arrives from a peer, along with the work on it that does not depend on
+   *  the node's state.  The connection's read loop fills it in, on a decode thread if it has one.
+   */
+  struct received_message : public message
+  {
+     message_hash_type                      hash;
+     /// the unpacked contents of a block or transaction message, null for other types or if unpacking failed
+     std::shared_ptr<const block_message>   block;
+     std::shared_ptr<const trx_message>     trx;
 
+     /** Hashes the message and unpacks it if it carries a block or a transaction */
+     void decode();
+  };
 
 } } // graphene::net
 
@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
 #include <graphene/net/message.hpp>
 
 namespace graphene { namespace net {
@@ -35,7 +36,7 @@ namespace graphene { namespace net {
   class message_oriented_connection_delegate 
   {
   public:
-    virtual void on_message(message_oriented_connection* originating_connection, const message& received_message) = 0;
+    virtual void on_message(message_oriented_connection* originating_connection, const received_message& received_message) = 0;
     virtual void on_connection_closed(message_oriented_connection* originating_connection) = 0;
   };
 
@@ -50,6 +51,9 @@ namespace graphene { namespace net {
        void accept();
        void bind(const fc::ip::endpoint& local_endpoint);
        void connect_to(const fc::ip::endpoint& remote_endpoint);
+       void set_socket_buffer_size(size_t buffer_size);
+       /** Has large incoming messages decrypted, hashed and unpacked on decode_thread instead of the connection's thread */
+       void set_decode_thread(fc::thread* decode_thread);
 
        void send_message(const message& message_to_send);
        void close_connection();
@@ -84,6 +84,22 @@ namespace graphene { namespace net {
          virtual bool handle_block( const graphene::net::block_message& blk_msg, bool sync_mode,
                                     std::vector<fc::uint160_t>& contained_transaction_message_ids ) = 0;
 
+         /**
+          *  @brief Called with sync blocks as they arrive, before they are passed to handle_block in
+          *         chain order.  Lets the client start on the checks that don't depend on chain state.
+          *         The blocks are not validated yet, nothing may be assumed about them.
+          */
+         virtual void precheck_sync_blocks( const std::vector<const graphene::net::block_message*>& blocks ) = 0;
+
+         /**
+          *  @brief Called during sync with a run of consecutive blocks in chain order, in place of calling
+          *         handle_block for each of them, so the client can apply the run in one go.
+          *
+          *  @returns one entry per block, empty if the block was accepted, otherwise the exception
+          *           handle_block would have thrown for it
+          */
+         virtual std::vector<fc::oexception> handle_sync_blocks( const std::vector<const graphene::net::block_message*>& blocks ) = 0;
+
          /**
           *  @brief Called when a new transaction comes in from the network
           *
@@ -38,6 +38,10 @@ struct node_configuration
    uint32_t maximum_number_of_sync_blocks_to_prefetch = GRAPHENE_NET_MAX_NUMBER_OF_BLOCKS_TO_PREFETCH;
    uint32_t maximum_blocks_per_peer_during_syncing = GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING;
    int64_t active_ignored_request_timeout_microseconds = 6000000;
+   /** size of the buffer each peer socket is read into and encrypted from, in bytes */
+   uint32_t socket_buffer_size = GRAPHENE_NET_DEFAULT_SOCKET_BUFFER_SIZE;
+   /** threads that decrypt, hash and unpack large incoming messages, 0 does it all on the p2p thread */
+   uint32_t message_decode_threads = 0;
 };
 
 } }
@@ -56,4 +60,6 @@ FC_REFLECT(graphene::net::node_configuration,
    (maximum_number_of_sync_blocks_to_prefetch)
    (maximum_blocks_per_peer_during_syncing)
    (active_ignored_request_timeout_microseconds)
+   (socket_buffer_size)
+   (message_decode_threads)
 )
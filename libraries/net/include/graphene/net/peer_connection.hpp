@@ -27,6 +27,8 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/inventory_filter.hpp>
+#include <graphene/net/token_bucket.hpp>
 #include <graphene/net/config.hpp>
 
 #include <boost/tuple/tuple.hpp>
@@ -40,6 +42,7 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <functional>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -66,9 +69,9 @@ namespace graphene { namespace net
     {
     public:
       virtual void on_message(peer_connection* originating_peer,
-                              const message& received_message) = 0;
+                              const received_message& received_message) = 0;
       virtual void on_connection_closed(peer_connection* originating_peer) = 0;
-      virtual message get_message_for_item(const item_id& item) = 0;
+      virtual message_ptr get_message_for_item(const item_id& item) = 0;
     };
 
     class peer_connection;
@@ -123,7 +126,7 @@ namespace graphene { namespace net
           enqueue_time(enqueue_time)
         {}
 
-        virtual message get_message(peer_connection_delegate* node) = 0;
+        virtual message_ptr get_message(peer_connection_delegate* node) = 0;
         /** returns roughly the number of bytes of memory the message is consuming while
          * it is sitting on the queue
          */
@@ -132,20 +135,36 @@ namespace graphene { namespace net
       };
 
       /* when you queue up a 'real_queued_message', a full copy of the message is
-       * stored on the heap until it is sent
+       * stored on the heap until it is sent.  Only messages that get patched right
+       * before sending need their own copy.
        */
       struct real_queued_message : queued_message
       {
-        message        message_to_send;
+        std::shared_ptr<message> message_to_send;
         size_t         message_send_time_field_offset;
 
         real_queued_message(message message_to_send,
                             size_t message_send_time_field_offset = (size_t)-1) :
-          message_to_send(std::move(message_to_send)),
+          message_to_send(std::make_shared<message>(std::move(message_to_send))),
           message_send_time_field_offset(message_send_time_field_offset)
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        message_ptr get_message(peer_connection_delegate* node) override;
+        size_t get_size_in_queue() override;
+      };
+
+      /* when you queue up a 'shared_queued_message', the queue holds a reference to
+       * a message that may be queued for other peers too
+       */
+      struct shared_queued_message : queued_message
+      {
+        message_ptr message_to_send;
+
+        shared_queued_message(message_ptr message_to_send) :
+          message_to_send(std::move(message_to_send))
+        {}
+
+        message_ptr get_message(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
@@ -161,7 +180,7 @@ namespace graphene { namespace net
           item_to_send(std::move(item_to_send))
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        message_ptr get_message(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
@@ -208,6 +227,8 @@ namespace graphene { namespace net
       fc::optional<std::string> platform;
       fc::optional<uint32_t> bitness;
       fc::optional<steem::protocol::chain_id_type> chain_id;
+      /** true if the peer announced in its hello that it understands compact_block_message */
+      bool supports_compact_blocks = false;
 
       // for inbound connections, these fields record what the peer sent us in
       // its hello message.  For outbound, they record what we sent the peer
@@ -229,6 +250,8 @@ namespace graphene { namespace net
       fc::optional<boost::tuple<std::vector<item_hash_t>, fc::time_point> > item_ids_requested_from_peer; /// we check this to detect a timed-out request and in busy()
       fc::time_point last_sync_item_received_time; /// the time we received the last sync item or the time we sent the last batch of sync item requests to this peer
       std::set<item_hash_t> sync_items_requested_from_peer; /// ids of blocks we've requested from this peer during sync.  fetch from another peer if this peer disconnects
+      uint64_t sync_bytes_received = 0; /// size of the sync blocks this peer has sent us, for its sync throughput in the peer database
+      fc::microseconds sync_receive_time; /// time spent waiting on those sync blocks
       item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
       fc::time_point_sec last_block_time_delegate_has_seen;
       bool inhibit_fetching_sync_blocks = false;
@@ -256,9 +279,40 @@ namespace graphene { namespace net
                                                                           boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
                                                                                                                  boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp> > > > timestamped_items_set_type;
       timestamped_items_set_type inventory_peer_advertised_to_us;
-      timestamped_items_set_type inventory_advertised_to_peer;
+      timestamped_items_set_type inventory_advertised_to_peer; /// every item but transactions, exact so no block advertisement is ever skipped
+      rolling_inventory_filter transactions_advertised_to_peer; /// approximate, may answer true for a transaction we never advertised
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      /// transactions from this peer we pass on to the client, the rest are dropped
+      token_bucket transaction_tokens{GRAPHENE_NET_MAX_TRX_PER_SECOND_PER_PEER, GRAPHENE_NET_TRX_BURST_SECONDS};
+      /// invalid transactions from this peer the client may reject before we disconnect it
+      token_bucket rejected_transaction_tokens{GRAPHENE_NET_MAX_REJECTED_TRX_PER_SECOND_PER_PEER, GRAPHENE_NET_REJECTED_TRX_BURST_SECONDS};
+      uint32_t number_of_transactions_dropped = 0;
+      uint32_t number_of_transactions_rejected = 0;
+
+      /** a block rebuilt from a compact_block_message, and the transactions it still lacks */
+      struct partially_received_block
+      {
+        typedef std::function<fc::optional<signed_transaction>(short_transaction_id_type)> transaction_lookup_type;
+
+        /** fills in every transaction find_transaction knows by its short id, the rest are left missing */
+        partially_received_block(const compact_block_message& compact_block, const transaction_lookup_type& find_transaction);
+
+        /** puts the transactions of a block_transactions_message in place, false if they are not as many as were missing */
+        bool add_missing_transactions(const std::vector<signed_transaction>& transactions);
+        /** true once complete if a short id matched a transaction other than the one in the block */
+        bool has_short_id_collision() const;
+        /** drops the transactions found by short id, so all of them get asked for */
+        void mark_all_transactions_missing();
+
+        signed_block            block;
+        block_id_type           block_id;
+        std::vector<uint32_t>   missing_transaction_indexes;
+        bool                    has_transactions_found_by_short_id = false;
+      };
+      /// compact blocks from this peer waiting for the transactions we had to ask it for, at most one per block we requested
+      std::map<block_id_type, partially_received_block> partial_blocks_from_peer;
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -284,14 +338,17 @@ namespace graphene { namespace net
       virtual ~peer_connection();
 
       fc::tcp_socket& get_socket();
+      void set_socket_buffer_size(size_t buffer_size);
+      void set_decode_thread(fc::thread* decode_thread);
       void accept_connection();
       void connect_to(const fc::ip::endpoint& remote_endpoint, fc::optional<fc::ip::endpoint> local_endpoint = fc::optional<fc::ip::endpoint>());
 
-      void on_message(message_oriented_connection* originating_connection, const message& received_message) override;
+      void on_message(message_oriented_connection* originating_connection, const received_message& received_message) override;
       void on_connection_closed(message_oriented_connection* originating_connection) override;
 
       void send_queueable_message(std::unique_ptr<queued_message>&& message_to_send);
       void send_message(const message& message_to_send, size_t message_send_time_field_offset = (size_t)-1);
+      void send_message(const message_ptr& message_to_send);
       void send_item(const item_id& item_to_send);
       void close_connection();
       void destroy_connection(const char* caller);
@@ -313,6 +370,8 @@ namespace graphene { namespace net
       bool is_transaction_fetching_inhibited() const;
       fc::sha512 get_shared_secret() const;
       void clear_old_inventory();
+      bool was_item_advertised_to_peer(const item_id& item) const;
+      void item_advertised_to_peer(const item_id& item);
       bool is_inventory_advertised_to_us_list_full_for_transactions() const;
       bool is_inventory_advertised_to_us_list_full() const;
       bool performing_firewall_check() const;
@@ -52,10 +52,13 @@ namespace graphene { namespace net {
     uint32_t                          number_of_successful_connection_attempts;
     uint32_t                          number_of_failed_connection_attempts;
     fc::optional<fc::exception>       last_error;
+    fc::microseconds                  average_round_trip_delay; /// zero until we have measured it
+    uint32_t                          sync_bytes_per_second;    /// rate the peer delivered sync blocks at, zero until measured
 
     potential_peer_record() :
       number_of_successful_connection_attempts(0),
-    number_of_failed_connection_attempts(0){}
+    number_of_failed_connection_attempts(0),
+    sync_bytes_per_second(0){}
 
     potential_peer_record(fc::ip::endpoint endpoint,
                           fc::time_point_sec last_seen_time = fc::time_point_sec(),
@@ -64,8 +67,13 @@ namespace graphene { namespace net {
       last_seen_time(last_seen_time),
       last_connection_disposition(last_connection_disposition),
       number_of_successful_connection_attempts(0),
-      number_of_failed_connection_attempts(0)
+      number_of_failed_connection_attempts(0),
+      sync_bytes_per_second(0)
     {}  
+
+    /** how much we prefer connecting to this peer, higher is better.  Combines the history of connection
+     *  attempts, the measured round trip delay and the sync throughput the peer delivered */
+    int64_t connection_score() const;
   };
 
   namespace detail
@@ -92,6 +100,15 @@ namespace graphene { namespace net {
   }
 
 
+  /**
+   *  The peers we know about, iterated best connection_score() first.
+   *
+   *  The database is kept in a binary journal.  Updates and erases only mark their endpoint, flush()
+   *  appends the current state of every marked endpoint to the file, and close() rewrites it.  The node
+   *  flushes every GRAPHENE_NET_PEERDB_FLUSH_INTERVAL_SECONDS, so an unclean shutdown loses at most
+   *  that much.  The file is rewritten with only the live records when the journal grows to several
+   *  times the size of the database.
+   */
   class peer_database
   {
   public:
@@ -101,6 +118,11 @@ namespace graphene { namespace net {
     void open(const fc::path& databaseFilename);
     void close();
     void clear();
+    /** writes the updates and erases made since the last flush to the journal */
+    void flush();
+
+    /** adds the records of a peer database saved in the older json format */
+    void import_json(const fc::path& json_filename);
 
     void erase(const fc::ip::endpoint& endpointToErase);
 
@@ -119,4 +141,4 @@ namespace graphene { namespace net {
 } } // end namespace graphene::net
 
 FC_REFLECT_ENUM(graphene::net::potential_peer_last_connection_disposition, (never_attempted_to_connect)(last_connection_failed)(last_connection_rejected)(last_connection_handshaking_failed)(last_connection_succeeded))
-FC_REFLECT(graphene::net::potential_peer_record, (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error) )
+FC_REFLECT(graphene::net::potential_peer_record, (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error)(average_round_trip_delay)(sync_bytes_per_second) )
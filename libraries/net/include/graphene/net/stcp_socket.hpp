@@ -25,6 +25,7 @@
 #include <fc/network/tcp_socket.hpp>
 #include <fc/crypto/aes.hpp>
 #include <fc/crypto/elliptic.hpp>
+#include <fc/uint128.hpp>
 
 namespace graphene { namespace net {
 
@@ -43,6 +44,14 @@ class stcp_socket : public virtual fc::iostream
     void             connect_to( const fc::ip::endpoint& remote_endpoint );
     void             bind( const fc::ip::endpoint& local_endpoint );
 
+    /**
+     *  Sets how many bytes are read from or written to the TCP socket and run through AES at a
+     *  time.  Larger buffers mean fewer socket calls and longer spans per cipher call.  The size
+     *  is rounded down to a multiple of 16.
+     */
+    void             set_buffer_size( size_t buffer_size );
+    size_t           get_buffer_size()const { return _buffer_size; }
+
     virtual size_t   readsome( char* buffer, size_t max );
     virtual size_t   readsome( const std::shared_ptr<char>& buf, size_t len, size_t offset );
     virtual bool     eof()const;
@@ -50,6 +59,37 @@ class stcp_socket : public virtual fc::iostream
     virtual size_t   writesome( const char* buffer, size_t len );
     virtual size_t   writesome( const std::shared_ptr<const char>& buf, size_t len, size_t offset );
 
+    /** One piece of the data passed to write_gather() */
+    struct write_segment
+    {
+      const char* data;
+      size_t      size;
+    };
+
+    /**
+     *  Encrypts and writes the concatenation of the segments, whose total size must be a
+     *  multiple of 16, without first copying them into one contiguous buffer.
+     */
+    void             write_gather( const write_segment* segments, size_t count );
+
+    /** Ciphertext read from the socket along with what is needed to decrypt it elsewhere */
+    struct encrypted_data
+    {
+      std::shared_ptr<char> data;
+      size_t                size = 0;
+      fc::sha256            key;
+      fc::uint128           iv;
+
+      /** Decrypts into plaintext, which must have room for size bytes.  Safe to call from any thread. */
+      void decrypt( char* plaintext )const;
+    };
+
+    /**
+     *  Reads the next len bytes, a multiple of 16, without decrypting them.  Reads and
+     *  readsome() calls after this one continue the stream as if the data had been decrypted.
+     */
+    encrypted_data   read_encrypted( size_t len );
+
     virtual void     flush();
     virtual void     close();
 
@@ -66,8 +106,12 @@ class stcp_socket : public virtual fc::iostream
     fc::tcp_socket       _sock;
     fc::aes_encoder      _send_aes;
     fc::aes_decoder      _recv_aes;
+    fc::sha256           _recv_key;
+    /** the last ciphertext block received, the cipher block chaining state of the receive stream */
+    fc::uint128          _recv_iv;
     std::shared_ptr<char> _read_buffer;
     std::shared_ptr<char> _write_buffer;
+    size_t               _buffer_size;
 #ifndef NDEBUG
     bool _read_buffer_in_use;
     bool _write_buffer_in_use;
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/time.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace net {
+
+  /**
+   *  Counts events against a rate.  The bucket holds up to tokens_per_second * burst_seconds tokens and
+   *  refills continuously at tokens_per_second; every event takes one.  Unlike fc::rate_limiting_group,
+   *  which delays socket reads and writes to limit bytes, this only answers whether an event is within
+   *  the rate, so the caller decides what to do with the ones that aren't.
+   */
+  class token_bucket
+  {
+  public:
+    /** starts full, the times passed to the other calls are measured from now */
+    token_bucket(uint32_t tokens_per_second, uint32_t burst_seconds, fc::time_point now = fc::time_point::now()) :
+      _tokens_per_second(tokens_per_second),
+      _capacity(uint64_t(tokens_per_second) * burst_seconds * 1000000),
+      _microtokens(_capacity),
+      _last_refill_time(now)
+    {}
+
+    /** takes a token if one is available, returns false if the rate has been exceeded */
+    bool try_consume(fc::time_point now = fc::time_point::now())
+    {
+      refill(now);
+      if (_microtokens < 1000000)
+        return false;
+      _microtokens -= 1000000;
+      return true;
+    }
+
+    uint32_t available_tokens(fc::time_point now = fc::time_point::now())
+    {
+      refill(now);
+      return uint32_t(_microtokens / 1000000);
+    }
+
+  private:
+    void refill(fc::time_point now)
+    {
+      // a clock that steps back must not be credited again when it catches up
+      if (now <= _last_refill_time)
+        return;
+      uint64_t elapsed_microseconds = (now - _last_refill_time).count();
+      _last_refill_time = now;
+      // cap the elapsed time first so the product can't overflow after a long idle period
+      elapsed_microseconds = std::min<uint64_t>(elapsed_microseconds, _capacity);
+      _microtokens = std::min(_capacity, _microtokens + elapsed_microseconds * _tokens_per_second);
+    }
+
+    uint32_t       _tokens_per_second;
+    uint64_t       _capacity;
+    uint64_t       _microtokens;
+    fc::time_point _last_refill_time;
+  };
+
+} } // graphene::net
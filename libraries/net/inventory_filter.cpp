@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/inventory_filter.hpp>
+
+#include <cstring>
+
+namespace graphene { namespace net {
+
+  namespace
+  {
+    // item_id is not a POD, so the type and hash are laid out in a key of their own
+    struct inventory_filter_key
+    {
+      inventory_filter_key(const item_id& item)
+      {
+        memcpy(bytes, &item.item_type, sizeof(item.item_type));
+        memcpy(bytes + sizeof(item.item_type), item.item_hash.data(), item.item_hash.data_size());
+      }
+      unsigned char bytes[sizeof(uint32_t) + sizeof(item_hash_t)];
+    };
+
+    fc::bloom_filter make_generation_filter(uint32_t items_per_generation, double false_positive_rate)
+    {
+      fc::bloom_parameters parameters;
+      parameters.projected_element_count = items_per_generation;
+      parameters.false_positive_probability = false_positive_rate;
+      parameters.compute_optimal_parameters();
+      return fc::bloom_filter(parameters);
+    }
+  }
+
+  rolling_inventory_filter::rolling_inventory_filter(uint32_t items_per_generation, double false_positive_rate,
+                                                     const fc::microseconds& generation_duration) :
+    _current(make_generation_filter(items_per_generation, false_positive_rate)),
+    _previous(_current),
+    _items_per_generation(items_per_generation),
+    _generation_duration(generation_duration),
+    _current_generation_start(fc::time_point::now())
+  {
+  }
+
+  void rolling_inventory_filter::insert(const item_id& item)
+  {
+    if (_current.element_count() >= _items_per_generation)
+      rotate();
+    inventory_filter_key key(item);
+    _current.insert(key.bytes, sizeof(key.bytes));
+  }
+
+  bool rolling_inventory_filter::contains(const item_id& item) const
+  {
+    inventory_filter_key key(item);
+    return _current.contains(key.bytes, sizeof(key.bytes)) || _previous.contains(key.bytes, sizeof(key.bytes));
+  }
+
+  void rolling_inventory_filter::expire_old_generation()
+  {
+    if (fc::time_point::now() - _current_generation_start >= _generation_duration)
+      rotate();
+  }
+
+  size_t rolling_inventory_filter::size() const
+  {
+    return _current.element_count() + _previous.element_count();
+  }
+
+  void rolling_inventory_filter::rotate()
+  {
+    // both filters share their parameters, so the older table is cleared and reused
+    _previous = _current;
+    _current.clear();
+    _current_generation_start = fc::time_point::now();
+  }
+
+} } // graphene::net
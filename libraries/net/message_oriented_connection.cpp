@@ -55,6 +55,8 @@ namespace graphene { namespace net {
       message_oriented_connection_delegate *_delegate;
       stcp_socket _sock;
       fc::future<void> _read_loop_done;
+      /// when set, large incoming messages are decrypted, hashed and unpacked on this thread
+      fc::thread* _decode_thread;
       uint64_t _bytes_received;
       uint64_t _bytes_sent;
 
@@ -74,6 +76,8 @@ namespace graphene { namespace net {
       void accept();
       void connect_to(const fc::ip::endpoint& remote_endpoint);
       void bind(const fc::ip::endpoint& local_endpoint);
+      void set_socket_buffer_size(size_t buffer_size);
+      void set_decode_thread(fc::thread* decode_thread);
 
       message_oriented_connection_impl(message_oriented_connection* self,
                                        message_oriented_connection_delegate* delegate = nullptr);
@@ -96,6 +100,7 @@ namespace graphene { namespace net {
                                                                        message_oriented_connection_delegate* delegate)
     : _self(self),
       _delegate(delegate),
+      _decode_thread(nullptr),
       _bytes_received(0),
       _bytes_sent(0),
       _send_message_in_progress(false)
@@ -138,6 +143,21 @@ namespace graphene { namespace net {
       _sock.bind(local_endpoint);
     }
 
+    void message_oriented_connection_impl::set_socket_buffer_size(size_t buffer_size)
+    {
+      VERIFY_CORRECT_THREAD();
+      // the socket's buffers are reallocated, so this is only allowed before the read loop starts
+      FC_ASSERT(!_read_loop_done.valid(), "socket buffer size must be set before connecting");
+      _sock.set_buffer_size(buffer_size);
+    }
+
+    void message_oriented_connection_impl::set_decode_thread(fc::thread* decode_thread)
+    {
+      VERIFY_CORRECT_THREAD();
+      FC_ASSERT(!_read_loop_done.valid(), "decode thread must be set before connecting");
+      _decode_thread = decode_thread;
+    }
+
     void message_oriented_connection_impl::read_loop()
     {
       VERIFY_CORRECT_THREAD();
@@ -152,25 +172,53 @@ namespace graphene { namespace net {
 
       try
       {
-        message m;
+        received_message local_message;
         while( true )
         {
           char buffer[BUFFER_SIZE];
           _sock.read(buffer, BUFFER_SIZE);
           _bytes_received += BUFFER_SIZE;
-          memcpy((char*)&m, buffer, sizeof(message_header));
+          message_header header;
+          memcpy((char*)&header, buffer, sizeof(message_header));
 
-          FC_ASSERT( m.size <= MAX_MESSAGE_SIZE, "", ("m.size",m.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
+          FC_ASSERT( header.size <= MAX_MESSAGE_SIZE, "", ("m.size",header.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
 
-          size_t remaining_bytes_with_padding = 16 * ((m.size - LEFTOVER + 15) / 16);
-          m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
-          std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
-          if (remaining_bytes_with_padding)
+          size_t remaining_bytes_with_padding = 16 * ((header.size - LEFTOVER + 15) / 16);
+          std::shared_ptr<received_message> decoded_message;
+          if (_decode_thread && remaining_bytes_with_padding >= GRAPHENE_NET_MIN_DECODE_THREAD_MESSAGE_SIZE)
           {
-            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+            // Only the socket read happens here.  Decrypting, hashing and unpacking the body run on
+            // the decode thread while this thread serves other connections.  We wait for the result
+            // before reading on, so this connection's messages are still delivered in order.  The
+            // task owns everything it touches in case this loop is canceled while it runs.
+            stcp_socket::encrypted_data body = _sock.read_encrypted(remaining_bytes_with_padding);
             _bytes_received += remaining_bytes_with_padding;
+
+            decoded_message = std::make_shared<received_message>();
+            static_cast<message_header&>(*decoded_message) = header;
+            decoded_message->data.resize(LEFTOVER + remaining_bytes_with_padding);
+            std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), decoded_message->data.begin());
+            _decode_thread->async([decoded_message, body]() {
+              body.decrypt(&decoded_message->data[LEFTOVER]);
+              decoded_message->data.resize(decoded_message->size); // truncate off the padding bytes
+              decoded_message->decode();
+            }, "decode message").wait();
           }
-          m.data.resize(m.size); // truncate off the padding bytes
+          else
+          {
+            received_message& m = local_message;
+            static_cast<message_header&>(m) = header;
+            m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
+            std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
+            if (remaining_bytes_with_padding)
+            {
+              _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+              _bytes_received += remaining_bytes_with_padding;
+            }
+            m.data.resize(m.size); // truncate off the padding bytes
+            m.decode();
+          }
+          const received_message& m = decoded_message ? *decoded_message : local_message;
 
           _last_message_received_time = fc::time_point::now();
 
@@ -260,15 +308,15 @@ namespace graphene { namespace net {
            elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
         //pad the message we send to a multiple of 16 bytes
         size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
-
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
-        size_t toClean = size_with_padding - size_of_message_and_header;
-        memset(paddingSpace, 0, toClean);
-
-        _sock.write(padded_message.get(), size_with_padding);
+        static const char padding[16] = {};
+
+        // header, body and padding are encrypted from where they are, the body is not copied
+        const stcp_socket::write_segment segments[] = {
+          { (const char*)&message_to_send, sizeof(message_header) },
+          { message_to_send.data.data(), message_to_send.size },
+          { padding, size_with_padding - size_of_message_and_header }
+        };
+        _sock.write_gather(segments, sizeof(segments) / sizeof(segments[0]));
         _sock.flush();
         _bytes_sent += size_with_padding;
         _last_message_sent_time = fc::time_point::now();
@@ -371,6 +419,16 @@ namespace graphene { namespace net {
     my->bind(local_endpoint);
   }
 
+  void message_oriented_connection::set_socket_buffer_size(size_t buffer_size)
+  {
+    my->set_socket_buffer_size(buffer_size);
+  }
+
+  void message_oriented_connection::set_decode_thread(fc::thread* decode_thread)
+  {
+    my->set_decode_thread(decode_thread);
+  }
+
   void message_oriented_connection::send_message(const message& message_to_send)
   {
     my->send_message(message_to_send);
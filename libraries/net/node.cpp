@@ -46,6 +46,7 @@
 #include <boost/range/algorithm_ext/push_back.hpp>
 #include <boost/range/algorithm/find.hpp>
 #include <boost/range/numeric.hpp>
+#include <boost/scope_exit.hpp>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
@@ -137,7 +138,7 @@ namespace graphene { namespace net {
       struct message_info
       {
         message_hash_type message_hash;
-        message           message_body;
+        message_ptr       message_body;
         uint32_t          block_clock_when_received;
 
         // for network performance stats
@@ -145,12 +146,12 @@ namespace graphene { namespace net {
         fc::uint160_t     message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
 
         message_info( const message_hash_type& message_hash,
-                      const message&           message_body,
+                      message_ptr              message_body,
                       uint32_t                 block_clock_when_received,
                       const message_propagation_data& propagation_data,
                       fc::uint160_t            message_contents_hash ) :
           message_hash( message_hash ),
-          message_body( message_body ),
+          message_body( std::move( message_body ) ),
           block_clock_when_received( block_clock_when_received ),
           propagation_data( propagation_data ),
           message_contents_hash( message_contents_hash )
@@ -177,7 +178,14 @@ namespace graphene { namespace net {
       void block_accepted();
       void cache_message( const message& message_to_cache, const message_hash_type& hash_of_message_to_cache,
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
-      message get_message( const message_hash_type& hash_of_message_to_lookup );
+      message_ptr get_message( const message_hash_type& hash_of_message_to_lookup );
+      bool has_message( const message_hash_type& hash_of_message_to_lookup ) const
+      {
+        return _message_cache.find( hash_of_message_to_lookup ) != _message_cache.end();
+      }
+      message_ptr get_message_by_contents_hash( uint32_t msg_type, const fc::uint160_t& hash_of_message_contents_to_lookup );
+      fc::uint160_t get_message_contents_hash( const message_hash_type& hash_of_message_to_lookup ) const;
+      message_ptr find_transaction_by_short_id( short_transaction_id_type short_id ) const;
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
       size_t size() const { return _message_cache.size(); }
     };
@@ -195,14 +203,15 @@ namespace graphene { namespace net {
                                                      const message_propagation_data& propagation_data,
                                                      const fc::uint160_t& message_content_hash )
     {
+      // the cached copy is the one handed to every peer that requests the item
       _message_cache.insert( message_info(hash_of_message_to_cache,
-                                         message_to_cache,
+                                         std::make_shared<message>( message_to_cache ),
                                          block_clock,
                                          propagation_data,
                                          message_content_hash ) );
     }
 
-    message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
+    message_ptr blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
     {
       message_cache_container::index<message_hash_index>::type::const_iterator iter =
          _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
@@ -211,6 +220,42 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    message_ptr blockchain_tied_message_cache::get_message_by_contents_hash( uint32_t msg_type, const fc::uint160_t& hash_of_message_contents_to_lookup )
+    {
+      if( hash_of_message_contents_to_lookup != fc::uint160_t() )
+      {
+        const auto& idx = _message_cache.get<message_contents_hash_index>();
+        for( auto iter = idx.find( hash_of_message_contents_to_lookup );
+             iter != idx.end() && iter->message_contents_hash == hash_of_message_contents_to_lookup; ++iter )
+          if( iter->message_body->msg_type == msg_type )
+            return iter->message_body;
+      }
+      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
+    }
+
+    fc::uint160_t blockchain_tied_message_cache::get_message_contents_hash( const message_hash_type& hash_of_message_to_lookup ) const
+    {
+      auto iter = _message_cache.get<message_hash_index>().find( hash_of_message_to_lookup );
+      if( iter != _message_cache.get<message_hash_index>().end() )
+        return iter->message_contents_hash;
+      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
+    }
+
+    /** Returns the first cached transaction whose id starts with short_id, or null if there is none */
+    message_ptr blockchain_tied_message_cache::find_transaction_by_short_id( short_transaction_id_type short_id ) const
+    {
+      // contents hashes sort bytewise, so every transaction id starting with short_id follows this one
+      fc::uint160_t first_possible_id;
+      memcpy( first_possible_id.data(), (const char*)&short_id, sizeof(short_id) );
+
+      const auto& idx = _message_cache.get<message_contents_hash_index>();
+      for( auto iter = idx.lower_bound( first_possible_id );
+           iter != idx.end() && get_short_transaction_id( iter->message_contents_hash ) == short_id; ++iter )
+        if( iter->message_body->msg_type == trx_message_type )
+          return iter->message_body;
+      return message_ptr();
+    }
+
     message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
     {
       if( hash_of_message_contents_to_lookup != fc::uint160_t() )
@@ -261,6 +306,8 @@ namespace graphene { namespace net {
 #define NODE_DELEGATE_METHOD_NAMES (has_item) \
                                    (handle_message) \
                                    (handle_block) \
+                                   (precheck_sync_blocks) \
+                                   (handle_sync_blocks) \
                                    (handle_transaction) \
                                    (get_block_ids) \
                                    (get_item) \
@@ -357,6 +404,8 @@ namespace graphene { namespace net {
       bool has_item( const net::item_id& id ) override;
       void handle_message( const message& ) override;
       bool handle_block( const graphene::net::block_message& block_message, bool sync_mode, std::vector<fc::uint160_t>& contained_transaction_message_ids ) override;
+      void precheck_sync_blocks( const std::vector<const graphene::net::block_message*>& blocks ) override;
+      std::vector<fc::oexception> handle_sync_blocks( const std::vector<const graphene::net::block_message*>& blocks ) override;
       void handle_transaction( const graphene::net::trx_message& transaction_message ) override;
       std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                              uint32_t& remaining_item_count,
@@ -382,10 +431,14 @@ namespace graphene { namespace net {
 #ifdef P2P_IN_DEDICATED_THREAD
       std::shared_ptr<fc::thread> _thread;
 #endif // P2P_IN_DEDICATED_THREAD
+      /// threads that decrypt and unpack large incoming messages, each connection is pinned to one
+      std::vector<std::shared_ptr<fc::thread>> _decode_threads;
+      uint32_t _next_decode_thread = 0;
       std::unique_ptr<statistics_gathering_node_delegate_wrapper> _delegate;
 
 #define NODE_CONFIGURATION_FILENAME      "node_config.json"
-#define POTENTIAL_PEER_DATABASE_FILENAME "peers.json"
+#define POTENTIAL_PEER_DATABASE_FILENAME "peers.dat"
+#define LEGACY_POTENTIAL_PEER_DATABASE_FILENAME "peers.json"
       fc::path             _node_configuration_directory;
       node_configuration   _node_configuration;
 
@@ -511,6 +564,8 @@ namespace graphene { namespace net {
 
       fc::future<void> _dump_node_status_task_done;
 
+      fc::future<void> _flush_peer_database_task_done;
+
       /* We have two alternate paths through the schedule_peer_for_deletion code -- one that
        * uses a mutex to prevent one fiber from adding items to the queue while another is deleting
        * items from it, and one that doesn't.  The one that doesn't is simpler and more efficient
@@ -533,6 +588,8 @@ namespace graphene { namespace net {
       std::atomic_bool _node_is_shutting_down; // set to true when we begin our destructor, used to prevent us from starting new tasks while we're shutting down
 
       std::list<fc::future<void> > _handle_message_calls_in_progress;
+      /// the number of sync blocks in the runs handed to send_sync_blocks_to_node_delegate that haven't been handled yet
+      uint32_t _number_of_sync_blocks_in_progress = 0;
       std::set<message_hash_type> _message_ids_currently_being_processed;
 
       std::atomic_int        _activeCalls;
@@ -565,6 +622,7 @@ namespace graphene { namespace net {
       void update_bandwidth_data(uint32_t bytes_read_this_second, uint32_t bytes_written_this_second);
       void bandwidth_monitor_loop();
       void dump_node_status_task();
+      void flush_peer_database_task();
 
       bool is_accepting_new_connections();
       bool is_wanting_new_connections();
@@ -581,8 +639,10 @@ namespace graphene { namespace net {
       fc::variant_object generate_hello_user_data();
       void parse_hello_user_data_for_peer( peer_connection* originating_peer, const fc::variant_object& user_data );
 
+      peer_connection_ptr create_peer_connection();
+
       void on_message( peer_connection* originating_peer,
-                       const message& received_message ) override;
+                       const received_message& received_message ) override;
 
       void on_hello_message( peer_connection* originating_peer,
                              const hello_message& hello_message_received );
@@ -637,16 +697,25 @@ namespace graphene { namespace net {
       void on_get_current_connections_reply_message(peer_connection* originating_peer,
                                                     const get_current_connections_reply_message& get_current_connections_reply_message_received);
 
+      message_ptr get_compact_block_message(const message_ptr& full_block_message, const message_hash_type& full_block_message_hash);
+      void on_compact_block_message(peer_connection* originating_peer,
+                                    const compact_block_message& compact_block_message_received);
+      void on_get_block_transactions_message(peer_connection* originating_peer,
+                                             const get_block_transactions_message& get_block_transactions_message_received);
+      void on_block_transactions_message(peer_connection* originating_peer,
+                                         const block_transactions_message& block_transactions_message_received);
+      void process_reconstructed_block(peer_connection* originating_peer, peer_connection::partially_received_block&& partial_block);
+
       void on_connection_closed(peer_connection* originating_peer) override;
 
-      void send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send);
+      void send_sync_blocks_to_node_delegate(const std::vector<graphene::net::block_message>& blocks_to_send);
       void process_backlog_of_sync_blocks();
       void trigger_process_backlog_of_sync_blocks();
       void process_block_during_sync(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
       void process_block_during_normal_operation(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
-      void process_block_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
+      void process_block_message(peer_connection* originating_peer, const received_message& message_to_process, const message_hash_type& message_hash);
 
-      void process_ordinary_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
+      void process_ordinary_message(peer_connection* originating_peer, const received_message& message_to_process, const message_hash_type& message_hash);
 
       void start_synchronizing();
       void start_synchronizing_with_peer(const peer_connection_ptr& peer);
@@ -709,7 +778,7 @@ namespace graphene { namespace net {
       void                       clear_peer_database();
       void                       set_total_bandwidth_limit( uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second );
       fc::variant_object         get_call_statistics() const;
-      message                    get_message_for_item(const item_id& item) override;
+      message_ptr                get_message_for_item(const item_id& item) override;
 
       fc::variant_object         network_get_info() const;
       fc::variant_object         network_get_usage_stats() const;
@@ -931,8 +1000,15 @@ namespace graphene { namespace net {
             bool initiated_connection_this_pass = false;
             _potential_peer_database_updated = false;
 
-            for (peer_database::iterator iter = _potential_peer_db.begin();
-                 iter != _potential_peer_db.end() && is_wanting_new_connections();
+            // the database iterates best scored peers first.  Connecting updates the records and
+            // can reorder them, so walk a copy
+            std::vector<potential_peer_record> candidates;
+            candidates.reserve(_potential_peer_db.size());
+            for (peer_database::iterator iter = _potential_peer_db.begin(); iter != _potential_peer_db.end(); ++iter)
+              candidates.push_back(*iter);
+
+            for (auto iter = candidates.begin();
+                 iter != candidates.end() && is_wanting_new_connections();
                  ++iter)
             {
               fc::microseconds delay_until_retry = fc::seconds((iter->number_of_failed_connection_attempts + 1) * _node_configuration.peer_connection_retry_timeout);
@@ -1284,16 +1360,14 @@ namespace graphene { namespace net {
             //wdump((inventory_to_advertise));
             for (const item_id& item_to_advertise : inventory_to_advertise)
             {
-              //if (peer->inventory_advertised_to_peer.find(item_to_advertise) != peer->inventory_advertised_to_peer.end() )
-              //   wdump((*peer->inventory_advertised_to_peer.find(item_to_advertise)));
               //if (peer->inventory_peer_advertised_to_us.find(item_to_advertise) != peer->inventory_peer_advertised_to_us.end() )
               //   wdump((*peer->inventory_peer_advertised_to_us.find(item_to_advertise)));
 
-              if (peer->inventory_advertised_to_peer.find(item_to_advertise) == peer->inventory_advertised_to_peer.end() &&
+              if (!peer->was_item_advertised_to_peer(item_to_advertise) &&
                   peer->inventory_peer_advertised_to_us.find(item_to_advertise) == peer->inventory_peer_advertised_to_us.end())
               {
                 items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
-                peer->inventory_advertised_to_peer.insert(peer_connection::timestamped_item_id(item_to_advertise, fc::time_point::now()));
+                peer->item_advertised_to_peer(item_to_advertise);
                 ++total_items_to_send_to_this_peer;
                 if (item_to_advertise.item_type == trx_message_type)
                   testnetlog("advertising transaction ${id} to peer ${endpoint}", ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
@@ -1621,6 +1695,22 @@ namespace graphene { namespace net {
                                                    "dump_node_status_task");
     }
 
+    void node_impl::flush_peer_database_task()
+    {
+      try
+      {
+        _potential_peer_db.flush();
+      }
+      catch (const fc::exception& e)
+      {
+        wlog("Exception thrown while flushing the peer database, ignoring: ${e}", ("e", e));
+      }
+      if (!_node_is_shutting_down && !_flush_peer_database_task_done.canceled())
+        _flush_peer_database_task_done = schedule_task([=](){ flush_peer_database_task(); },
+                                                      fc::time_point::now() + fc::seconds(GRAPHENE_NET_PEERDB_FLUSH_INTERVAL_SECONDS),
+                                                      "flush_peer_database_task");
+    }
+
     void node_impl::delayed_peer_deletion_task()
     {
 #ifdef USE_PEERS_TO_DELETE_MUTEX
@@ -1780,13 +1870,28 @@ namespace graphene { namespace net {
       }
     }
 
-    void node_impl::on_message( peer_connection* originating_peer, const message& received_message )
+    peer_connection_ptr node_impl::create_peer_connection()
+    {
+      VERIFY_CORRECT_THREAD();
+      peer_connection_ptr new_peer(peer_connection::make_shared(this));
+      new_peer->set_socket_buffer_size(_node_configuration.socket_buffer_size);
+
+      if (_node_configuration.message_decode_threads)
+      {
+        while (_decode_threads.size() < _node_configuration.message_decode_threads)
+          _decode_threads.push_back(std::make_shared<fc::thread>("p2p decode " + std::to_string(_decode_threads.size())));
+        new_peer->set_decode_thread(_decode_threads[_next_decode_thread++ % _node_configuration.message_decode_threads].get());
+      }
+      return new_peer;
+    }
+
+    void node_impl::on_message( peer_connection* originating_peer, const received_message& received_message )
     {
       VERIFY_CORRECT_THREAD();
 
       activity_tracer aTracer(__FUNCTION__, *this);
 
-      message_hash_type message_hash = received_message.id();
+      const message_hash_type& message_hash = received_message.hash;
       dlog("handling message ${type} ${hash} size ${size} from peer ${endpoint}",
            ("type", graphene::net::core_message_type_enum(received_message.msg_type))("hash", message_hash)
            ("size", received_message.size)
@@ -1847,6 +1952,15 @@ namespace graphene { namespace net {
       case core_message_type_enum::get_current_connections_reply_message_type:
         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::get_block_transactions_message_type:
+        on_get_block_transactions_message(originating_peer, received_message.as<get_block_transactions_message>());
+        break;
+      case core_message_type_enum::block_transactions_message_type:
+        on_block_transactions_message(originating_peer, received_message.as<block_transactions_message>());
+        break;
 
       default:
         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1891,6 +2005,7 @@ namespace graphene { namespace net {
         user_data["last_known_fork_block_number"] = _hard_fork_block_numbers.back();
 
       user_data["chain_id"] = _delegate->get_chain_id();
+      user_data["compact_blocks"] = true;
 
       return user_data;
     }
@@ -1916,6 +2031,8 @@ namespace graphene { namespace net {
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>();
       if (user_data.contains("chain_id"))
         originating_peer->chain_id = user_data["chain_id"].as<steem::protocol::chain_id_type>();
+      if (user_data.contains("compact_blocks"))
+        originating_peer->supports_compact_blocks = user_data["compact_blocks"].as<bool>();
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2770,7 +2887,7 @@ namespace graphene { namespace net {
       }
     }
 
-    message node_impl::get_message_for_item(const item_id& item)
+    message_ptr node_impl::get_message_for_item(const item_id& item)
     {
       activity_tracer aTracer(__FUNCTION__, *this);
 
@@ -2782,11 +2899,18 @@ namespace graphene { namespace net {
       {}
       try
       {
-        return _delegate->get_item(item);
+        // blocks are queued by block id, share the copy cached when the block was broadcast
+        return _message_cache.get_message_by_contents_hash(item.item_type, item.item_hash);
       }
       catch (fc::key_not_found_exception&)
       {}
-      return item_not_available_message(item);
+      try
+      {
+        return std::make_shared<message>(_delegate->get_item(item));
+      }
+      catch (fc::key_not_found_exception&)
+      {}
+      return std::make_shared<message>(item_not_available_message(item));
     }
 
     void node_impl::on_fetch_items_message(peer_connection* originating_peer, const fetch_items_message& fetch_items_message_received)
@@ -2797,20 +2921,28 @@ namespace graphene { namespace net {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
-      fc::optional<message> last_block_message_sent;
+      message_ptr last_block_message_sent;
 
-      std::list<message> reply_messages;
+      std::list<message_ptr> reply_messages;
       for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
       {
         try
         {
-          message requested_message = _message_cache.get_message(item_hash);
+          message_ptr requested_message = _message_cache.get_message(item_hash);
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
-               ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
+               ("id", item_hash));
           if (fetch_items_message_received.item_type == block_message_type)
+          {
             last_block_message_sent = requested_message;
+            // a block still in the cache is new, so the peer most likely has its transactions already
+            if (originating_peer->supports_compact_blocks && requested_message->msg_type == block_message_type)
+            {
+              reply_messages.push_back(get_compact_block_message(requested_message, item_hash));
+              continue;
+            }
+          }
+          reply_messages.push_back(requested_message);
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -2821,10 +2953,10 @@ namespace graphene { namespace net {
         item_id item_to_fetch(fetch_items_message_received.item_type, item_hash);
         try
         {
-          message requested_message = _delegate->get_item(item_to_fetch);
+          message_ptr requested_message = std::make_shared<message>(_delegate->get_item(item_to_fetch));
           dlog("received item request from peer ${endpoint}, returning the item from delegate with id ${id} size ${size}",
-               ("id", requested_message.id())
-               ("size", requested_message.size)
+               ("id", item_hash)
+               ("size", requested_message->size)
                ("endpoint", originating_peer->get_remote_endpoint()));
           reply_messages.push_back(requested_message);
           if (fetch_items_message_received.item_type == block_message_type)
@@ -2833,7 +2965,7 @@ namespace graphene { namespace net {
         }
         catch (fc::key_not_found_exception&)
         {
-          reply_messages.push_back(item_not_available_message(item_to_fetch));
+          reply_messages.push_back(std::make_shared<message>(item_not_available_message(item_to_fetch)));
           dlog("received item request from peer ${endpoint} but we don't have it",
                ("endpoint", originating_peer->get_remote_endpoint()));
         }
@@ -2847,10 +2979,10 @@ namespace graphene { namespace net {
         originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
       }
 
-      for (const message& reply : reply_messages)
+      for (const message_ptr& reply : reply_messages)
       {
-        if (reply.msg_type == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+        if (reply->msg_type == block_message_type)
+          originating_peer->send_item(item_id(block_message_type, reply->as<graphene::net::block_message>().block_id));
         else
           originating_peer->send_message(reply);
       }
@@ -2911,11 +3043,15 @@ namespace graphene { namespace net {
           // we've processed this item but haven't advertised it to our peers yet, don't fetch it again
           continue;
 
-        bool we_advertised_this_item_to_a_peer = false;
+        // blocks are checked against the exact per-peer sets.  Transactions are only tracked
+        // approximately per peer, but every one we advertised is still in the message cache
+        bool we_advertised_this_item_to_a_peer = advertised_item_id.item_type == trx_message_type &&
+                                                 _message_cache.has_message(item_hash);
         bool we_requested_this_item_from_a_peer = false;
         for (const peer_connection_ptr peer : _active_connections)
         {
-          if (peer->inventory_advertised_to_peer.find(advertised_item_id) != peer->inventory_advertised_to_peer.end())
+          if (advertised_item_id.item_type != trx_message_type &&
+              peer->inventory_advertised_to_peer.find(advertised_item_id) != peer->inventory_advertised_to_peer.end())
           {
             we_advertised_this_item_to_a_peer = true;
             break;
@@ -3033,6 +3169,11 @@ namespace graphene { namespace net {
           if (updated_peer_record)
           {
             updated_peer_record->last_seen_time = fc::time_point::now();
+            if (originating_peer->sync_bytes_received >= GRAPHENE_NET_MIN_SYNC_BYTES_FOR_THROUGHPUT &&
+                originating_peer->sync_receive_time > fc::microseconds())
+              updated_peer_record->sync_bytes_per_second = (uint32_t)std::min<uint64_t>(originating_peer->sync_bytes_received * 1000000 /
+                                                                                         originating_peer->sync_receive_time.count(),
+                                                                                         std::numeric_limits<uint32_t>::max());
             _potential_peer_db.update_entry(*updated_peer_record);
           }
         }
@@ -3089,51 +3230,33 @@ namespace graphene { namespace net {
       schedule_peer_for_deletion(originating_peer_ptr);
     }
 
-    void node_impl::send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send)
+    void node_impl::send_sync_blocks_to_node_delegate(const std::vector<graphene::net::block_message>& blocks_to_send)
     {
-      dlog("in send_sync_block_to_node_delegate()");
+      dlog("in send_sync_blocks_to_node_delegate(), ${count} blocks", ("count", blocks_to_send.size()));
 
-      bool client_accepted_block = false;
-      bool discontinue_fetching_blocks_from_peer = false;
+      // the run is counted from when it was queued, release it however this task ends
+      BOOST_SCOPE_EXIT(this_, &blocks_to_send) {
+        this_->_number_of_sync_blocks_in_progress -= blocks_to_send.size();
+      } BOOST_SCOPE_EXIT_END
 
-      fc::oexception handle_message_exception;
-
-      try
+      std::vector<const graphene::net::block_message*> blocks;
+      blocks.reserve(blocks_to_send.size());
+      for (const graphene::net::block_message& block_message_to_send : blocks_to_send)
       {
-        std::vector<fc::uint160_t> contained_transaction_message_ids;
         fc_ilog(fc::logger::get("sync"),
                 "p2p pushing sync block #${block_num} ${block_hash}",
                 ("block_num", block_message_to_send.block.block_num())
                 ("block_hash", block_message_to_send.block_id));
-        _delegate->handle_block(block_message_to_send, true, contained_transaction_message_ids);
-
-        auto bn = block_message_to_send.block.block_num();
-        //if(bn % 1000 == 0)
-        {
-         ilog("Successfully pushed sync block ${num} (id:${id})",
-               ("num", bn)
-               ("id", block_message_to_send.block_id));
-        }
-
-        _most_recent_blocks_accepted.push_back(block_message_to_send.block_id);
-
-        client_accepted_block = true;
+        blocks.push_back(&block_message_to_send);
       }
-      catch (const block_older_than_undo_history& e)
+
+      // the client applies the whole run at once and tells us what became of each block in it
+      std::vector<fc::oexception> results;
+      try
       {
-        fc_wlog(fc::logger::get("sync"),
-                "p2p failed to push sync block #${block_num} ${block_hash}: block is on a fork older than our undo history would "
-                "allow us to switch to: ${e}",
-                ("block_num", block_message_to_send.block.block_num())
-                ("block_hash", block_message_to_send.block_id)
-                ("e", (fc::exception)e));
-        wlog("Failed to push sync block ${num} (id:${id}): block is on a fork older than our undo history would "
-             "allow us to switch to: ${e}",
-             ("num", block_message_to_send.block.block_num())
-             ("id", block_message_to_send.block_id)
-             ("e", (fc::exception)e));
-        handle_message_exception = e;
-        discontinue_fetching_blocks_from_peer = true;
+        results = _delegate->handle_sync_blocks(blocks);
+        FC_ASSERT(results.size() == blocks.size(), "client returned ${results} results for ${blocks} sync blocks",
+                  ("results", results.size())("blocks", blocks.size()));
       }
       catch (const fc::canceled_exception&)
       {
@@ -3141,15 +3264,8 @@ namespace graphene { namespace net {
       }
       catch (const fc::exception& e)
       {
-        fc_wlog(fc::logger::get("sync"),
-                "p2p failed to push sync block #${block_num} ${block_hash}: client rejected sync block sent by peer: ${e}",
-                ("block_num", block_message_to_send.block.block_num())
-                ("block_hash", block_message_to_send.block_id)("e", e));
-        wlog("Failed to push sync block ${num} (id:${id}): client rejected sync block sent by peer: ${e}",
-             ("num", block_message_to_send.block.block_num())
-             ("id", block_message_to_send.block_id)
-             ("e", e));
-        handle_message_exception = e;
+        wlog("Failed to push a run of ${count} sync blocks: ${e}", ("count", blocks.size())("e", e));
+        results.assign(blocks.size(), fc::oexception(e));
       }
 
       // build up lists for any potentially-blocking operations we need to do, then do them
@@ -3158,99 +3274,141 @@ namespace graphene { namespace net {
       std::set<peer_connection_ptr> peers_we_need_to_sync_to;
       std::map<peer_connection_ptr, std::pair<std::string, fc::oexception> > peers_to_disconnect; // map peer -> pair<reason_string, exception>
 
-      if( client_accepted_block )
+      for (size_t i = 0; i < blocks_to_send.size(); ++i)
       {
-        --_total_number_of_unfetched_items;
-        dlog("sync: client accpted the block, we now have only ${count} items left to fetch before we're in sync",
-              ("count", _total_number_of_unfetched_items));
-        bool is_fork_block = is_hard_fork_block(block_message_to_send.block.block_num());
-        for (const peer_connection_ptr& peer : _active_connections)
+        const graphene::net::block_message& block_message_to_send = blocks_to_send[i];
+        const fc::oexception& handle_message_exception = results[i];
+        bool client_accepted_block = !handle_message_exception;
+        bool discontinue_fetching_blocks_from_peer = false;
+
+        if (client_accepted_block)
         {
-          ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
-          bool disconnecting_this_peer = false;
-          if (is_fork_block)
+          ilog("Successfully pushed sync block ${num} (id:${id})",
+               ("num", block_message_to_send.block.block_num())
+               ("id", block_message_to_send.block_id));
+          _most_recent_blocks_accepted.push_back(block_message_to_send.block_id);
+        }
+        else if (handle_message_exception->code() == block_older_than_undo_history::code_value)
+        {
+          fc_wlog(fc::logger::get("sync"),
+                  "p2p failed to push sync block #${block_num} ${block_hash}: block is on a fork older than our undo history would "
+                  "allow us to switch to: ${e}",
+                  ("block_num", block_message_to_send.block.block_num())
+                  ("block_hash", block_message_to_send.block_id)
+                  ("e", *handle_message_exception));
+          wlog("Failed to push sync block ${num} (id:${id}): block is on a fork older than our undo history would "
+               "allow us to switch to: ${e}",
+               ("num", block_message_to_send.block.block_num())
+               ("id", block_message_to_send.block_id)
+               ("e", *handle_message_exception));
+          discontinue_fetching_blocks_from_peer = true;
+        }
+        else
+        {
+          fc_wlog(fc::logger::get("sync"),
+                  "p2p failed to push sync block #${block_num} ${block_hash}: client rejected sync block sent by peer: ${e}",
+                  ("block_num", block_message_to_send.block.block_num())
+                  ("block_hash", block_message_to_send.block_id)("e", *handle_message_exception));
+          wlog("Failed to push sync block ${num} (id:${id}): client rejected sync block sent by peer: ${e}",
+               ("num", block_message_to_send.block.block_num())
+               ("id", block_message_to_send.block_id)
+               ("e", *handle_message_exception));
+        }
+
+        if( client_accepted_block )
+        {
+          --_total_number_of_unfetched_items;
+          dlog("sync: client accpted the block, we now have only ${count} items left to fetch before we're in sync",
+                ("count", _total_number_of_unfetched_items));
+          bool is_fork_block = is_hard_fork_block(block_message_to_send.block.block_num());
+          for (const peer_connection_ptr& peer : _active_connections)
           {
-            // we just pushed a hard fork block.  Find out if this peer is running a client
-            // that will be unable to process future blocks
-            if (peer->last_known_fork_block_number != 0)
+            ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
+            bool disconnecting_this_peer = false;
+            if (is_fork_block)
             {
-              uint32_t next_fork_block_number = get_next_known_hard_fork_block_number(peer->last_known_fork_block_number);
-              if (next_fork_block_number != 0 &&
-                  next_fork_block_number <= block_message_to_send.block.block_num())
+              // we just pushed a hard fork block.  Find out if this peer is running a client
+              // that will be unable to process future blocks
+              if (peer->last_known_fork_block_number != 0)
               {
-                std::ostringstream disconnect_reason_stream;
-                disconnect_reason_stream << "You need to upgrade your client due to hard fork at block " << block_message_to_send.block.block_num();
-                peers_to_disconnect[peer] = std::make_pair(disconnect_reason_stream.str(),
-                                                           fc::oexception(fc::exception(FC_LOG_MESSAGE(error, "You need to upgrade your client due to hard fork at block ${block_number}",
-                                                                                                       ("block_number", block_message_to_send.block.block_num())))));
+                uint32_t next_fork_block_number = get_next_known_hard_fork_block_number(peer->last_known_fork_block_number);
+                if (next_fork_block_number != 0 &&
+                    next_fork_block_number <= block_message_to_send.block.block_num())
+                {
+                  std::ostringstream disconnect_reason_stream;
+                  disconnect_reason_stream << "You need to upgrade your client due to hard fork at block " << block_message_to_send.block.block_num();
+                  peers_to_disconnect[peer] = std::make_pair(disconnect_reason_stream.str(),
+                                                             fc::oexception(fc::exception(FC_LOG_MESSAGE(error, "You need to upgrade your client due to hard fork at block ${block_number}",
+                                                                                                         ("block_number", block_message_to_send.block.block_num())))));
 #ifdef ENABLE_DEBUG_ULOGS
-                ulog("Disconnecting from peer during sync because their version is too old.  Their version date: ${date}", ("date", peer->graphene_git_revision_unix_timestamp));
+                  ulog("Disconnecting from peer during sync because their version is too old.  Their version date: ${date}", ("date", peer->graphene_git_revision_unix_timestamp));
 #endif
-                disconnecting_this_peer = true;
+                  disconnecting_this_peer = true;
+                }
               }
             }
-          }
-          if (!disconnecting_this_peer &&
-              peer->ids_of_items_to_get.empty() && peer->ids_of_items_being_processed.empty())
-          {
-            dlog( "Cannot pop first element off peer ${peer}'s list, its list is empty", ("peer", peer->get_remote_endpoint() ) );
-            // we don't know for sure that this peer has the item we just received.
-            // If peer is still syncing to us, we know they will ask us for
-            // sync item ids at least one more time and we'll notify them about
-            // the item then, so there's no need to do anything.  If we still need items
-            // from them, we'll be asking them for more items at some point, and
-            // that will clue them in that they are out of sync.  If we're fully in sync
-            // we need to kick off another round of synchronization with them so they can
-            // find out about the new item.
-            if (!peer->peer_needs_sync_items_from_us && !peer->we_need_sync_items_from_peer)
+            if (!disconnecting_this_peer &&
+                peer->ids_of_items_to_get.empty() && peer->ids_of_items_being_processed.empty())
             {
-              dlog("We will be restarting synchronization with peer ${peer}", ("peer", peer->get_remote_endpoint()));
-              peers_we_need_to_sync_to.insert(peer);
+              dlog( "Cannot pop first element off peer ${peer}'s list, its list is empty", ("peer", peer->get_remote_endpoint() ) );
+              // we don't know for sure that this peer has the item we just received.
+              // If peer is still syncing to us, we know they will ask us for
+              // sync item ids at least one more time and we'll notify them about
+              // the item then, so there's no need to do anything.  If we still need items
+              // from them, we'll be asking them for more items at some point, and
+              // that will clue them in that they are out of sync.  If we're fully in sync
+              // we need to kick off another round of synchronization with them so they can
+              // find out about the new item.
+              if (!peer->peer_needs_sync_items_from_us && !peer->we_need_sync_items_from_peer)
+              {
+                dlog("We will be restarting synchronization with peer ${peer}", ("peer", peer->get_remote_endpoint()));
+                peers_we_need_to_sync_to.insert(peer);
+              }
             }
-          }
-          else if (!disconnecting_this_peer)
-          {
-            auto items_being_processed_iter = peer->ids_of_items_being_processed.find(block_message_to_send.block_id);
-            if (items_being_processed_iter != peer->ids_of_items_being_processed.end())
+            else if (!disconnecting_this_peer)
             {
-              peer->last_block_delegate_has_seen = block_message_to_send.block_id;
-              peer->last_block_time_delegate_has_seen = block_message_to_send.block.timestamp;
-
-              peer->ids_of_items_being_processed.erase(items_being_processed_iter);
-              dlog("Removed item from ${endpoint}'s list of items being processed, still processing ${len} blocks",
-                   ("endpoint", peer->get_remote_endpoint())("len", peer->ids_of_items_being_processed.size()));
-
-              // if we just received the last item in our list from this peer, we will want to
-              // send another request to find out if we are in sync, but we can't do this yet
-              // (we don't want to allow a fiber swap in the middle of popping items off the list)
-              if (peer->ids_of_items_to_get.empty() &&
-                  peer->number_of_unfetched_item_ids == 0 &&
-                  peer->ids_of_items_being_processed.empty())
-                peers_with_newly_empty_item_lists.insert(peer);
-
-              // in this case, we know the peer was offering us this exact item, no need to
-              // try to inform them of its existence
+              auto items_being_processed_iter = peer->ids_of_items_being_processed.find(block_message_to_send.block_id);
+              if (items_being_processed_iter != peer->ids_of_items_being_processed.end())
+              {
+                peer->last_block_delegate_has_seen = block_message_to_send.block_id;
+                peer->last_block_time_delegate_has_seen = block_message_to_send.block.timestamp;
+
+                peer->ids_of_items_being_processed.erase(items_being_processed_iter);
+                dlog("Removed item from ${endpoint}'s list of items being processed, still processing ${len} blocks",
+                     ("endpoint", peer->get_remote_endpoint())("len", peer->ids_of_items_being_processed.size()));
+
+                // if we just received the last item in our list from this peer, we will want to
+                // send another request to find out if we are in sync, but we can't do this yet
+                // (we don't want to allow a fiber swap in the middle of popping items off the list)
+                if (peer->ids_of_items_to_get.empty() &&
+                    peer->number_of_unfetched_item_ids == 0 &&
+                    peer->ids_of_items_being_processed.empty())
+                  peers_with_newly_empty_item_lists.insert(peer);
+
+                // in this case, we know the peer was offering us this exact item, no need to
+                // try to inform them of its existence
+              }
             }
           }
         }
-      }
-      else
-      {
-        // invalid message received
-        for (const peer_connection_ptr& peer : _active_connections)
+        else
         {
-          ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
-
-          if (peer->ids_of_items_being_processed.find(block_message_to_send.block_id) != peer->ids_of_items_being_processed.end())
+          // invalid message received
+          for (const peer_connection_ptr& peer : _active_connections)
           {
-            if (discontinue_fetching_blocks_from_peer)
+            ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
+
+            if (peer->ids_of_items_being_processed.find(block_message_to_send.block_id) != peer->ids_of_items_being_processed.end())
             {
-              wlog("inhibiting fetching sync blocks from peer ${endpoint} because it is on a fork that's too old",
-                   ("endpoint", peer->get_remote_endpoint()));
-              peer->inhibit_fetching_sync_blocks = true;
+              if (discontinue_fetching_blocks_from_peer)
+              {
+                wlog("inhibiting fetching sync blocks from peer ${endpoint} because it is on a fork that's too old",
+                     ("endpoint", peer->get_remote_endpoint()));
+                peer->inhibit_fetching_sync_blocks = true;
+              }
+              else
+                peers_to_disconnect[peer] = std::make_pair(std::string("You offered us a block that we reject as invalid"), fc::oexception(handle_message_exception));
             }
-            else
-              peers_to_disconnect[peer] = std::make_pair(std::string("You offered us a block that we reject as invalid"), fc::oexception(handle_message_exception));
           }
         }
       }
@@ -3266,12 +3424,14 @@ namespace graphene { namespace net {
         disconnect_from_peer(peer.get(), reason_string, true, reason_exception);
       }
       for (const peer_connection_ptr& peer : peers_with_newly_empty_item_lists)
-        fetch_next_batch_of_item_ids_from_peer(peer.get());
+        if (peers_to_disconnect.find(peer) == peers_to_disconnect.end())
+          fetch_next_batch_of_item_ids_from_peer(peer.get());
 
       for (const peer_connection_ptr& peer : peers_we_need_to_sync_to)
-        start_synchronizing_with_peer(peer);
+        if (peers_to_disconnect.find(peer) == peers_to_disconnect.end())
+          start_synchronizing_with_peer(peer);
 
-      dlog("Leaving send_sync_block_to_node_delegate");
+      dlog("Leaving send_sync_blocks_to_node_delegate");
 
       if (// _suspend_fetching_sync_blocks && <-- you can use this if "maximum_number_of_blocks_to_handle_at_one_time" == "maximum_number_of_sync_blocks_to_prefetch"
           !_node_is_shutting_down &&
@@ -3293,18 +3453,18 @@ namespace graphene { namespace net {
       }
 
       dlog("in process_backlog_of_sync_blocks");
-      if (_handle_message_calls_in_progress.size() >= _node_configuration.maximum_number_of_blocks_to_handle_at_one_time)
+      if (_number_of_sync_blocks_in_progress >= _node_configuration.maximum_number_of_blocks_to_handle_at_one_time)
       {
         dlog("leaving process_backlog_of_sync_blocks because we're already processing too many blocks");
         return; // we will be rescheduled when the next block finishes its processing
       }
-      dlog("currently ${count} blocks in the process of being handled", ("count", _handle_message_calls_in_progress.size()));
+      dlog("currently ${count} blocks in the process of being handled", ("count", _number_of_sync_blocks_in_progress));
 
 
       if (_suspend_fetching_sync_blocks)
       {
         dlog("resuming processing sync block backlog because we only ${count} blocks in progress",
-             ("count", _handle_message_calls_in_progress.size()));
+             ("count", _number_of_sync_blocks_in_progress));
         _suspend_fetching_sync_blocks = false;
       }
 
@@ -3322,8 +3482,42 @@ namespace graphene { namespace net {
       std::set<peer_connection_ptr> peers_we_need_to_sync_to;
       std::map<peer_connection_ptr, fc::oexception> peers_with_rejected_block;
 
+      // consecutive blocks are handed to the client in runs so it can apply each run in one go
+      std::vector<graphene::net::block_message> blocks_to_send;
+      auto send_blocks_to_node_delegate = [&]()
+      {
+        if (blocks_to_send.empty())
+          return;
+        _handle_message_calls_in_progress.emplace_back(async_task([this, blocks = std::move(blocks_to_send)](){
+          send_sync_blocks_to_node_delegate(blocks);
+        }, "send_sync_blocks_to_node_delegate"));
+        blocks_to_send.clear();
+      };
+
       do
       {
+        if (!_new_received_sync_items.empty())
+        {
+          // blocks usually arrive well before their turn to be applied, let the client get the checks
+          // that don't depend on chain state out of the way for the whole batch now
+          std::vector<const graphene::net::block_message*> new_blocks;
+          new_blocks.reserve(_new_received_sync_items.size());
+          for (const graphene::net::block_message& new_block : _new_received_sync_items)
+            new_blocks.push_back(&new_block);
+          try
+          {
+            _delegate->precheck_sync_blocks(new_blocks);
+          }
+          catch (const fc::canceled_exception&)
+          {
+            throw;
+          }
+          catch (const fc::exception& e)
+          {
+            wlog("error prechecking sync blocks: ${e}", ("e", e));
+          }
+        }
+
         std::copy(std::make_move_iterator(_new_received_sync_items.begin()),
                   std::make_move_iterator(_new_received_sync_items.end()),
                   std::front_inserter(_received_sync_items));
@@ -3362,21 +3556,27 @@ namespace graphene { namespace net {
             if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
                           received_block_iter->block_id) == _most_recent_blocks_accepted.end())
             {
-              graphene::net::block_message block_message_to_process = *received_block_iter;
+              blocks_to_send.push_back(std::move(*received_block_iter));
               _received_sync_items.erase(received_block_iter);
-              _handle_message_calls_in_progress.emplace_back(async_task([this, block_message_to_process](){
-                send_sync_block_to_node_delegate(block_message_to_process);
-              }, "send_sync_block_to_node_delegate"));
+              ++_number_of_sync_blocks_in_progress;
+              if (blocks_to_send.size() >= GRAPHENE_NET_MAX_SYNC_BLOCKS_PER_RUN)
+                send_blocks_to_node_delegate();
               ++blocks_processed;
               block_processed_this_iteration = true;
             }
             else
             {
               dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
+              // drop the duplicate and keep going, the blocks queued behind it may be the next ones on our
+              // chain and nothing else will bring us back here once every block we asked for has arrived
+              item_hash_t accepted_block_id = received_block_iter->block_id;
+              _received_sync_items.erase(received_block_iter);
+              block_processed_this_iteration = true;
+
               std::vector< peer_connection_ptr > peers_needing_next_batch;
               for (const peer_connection_ptr& peer : _active_connections)
               {
-                auto items_being_processed_iter = peer->ids_of_items_being_processed.find(received_block_iter->block_id);
+                auto items_being_processed_iter = peer->ids_of_items_being_processed.find(accepted_block_id);
                 if (items_being_processed_iter != peer->ids_of_items_being_processed.end())
                 {
                   peer->ids_of_items_being_processed.erase(items_being_processed_iter);
@@ -3385,7 +3585,7 @@ namespace graphene { namespace net {
 
                   // if we just processed the last item in our list from this peer, we will want to
                   // send another request to find out if we are now in sync (this is normally handled in
-                  // send_sync_block_to_node_delegate)
+                  // send_sync_blocks_to_node_delegate)
                   if (peer->ids_of_items_to_get.empty() &&
                       peer->number_of_unfetched_item_ids == 0 &&
                       peer->ids_of_items_being_processed.empty())
@@ -3403,10 +3603,10 @@ namespace graphene { namespace net {
           } // end if potential_first_block
         } // end for each block in _received_sync_items
 
-        if (_handle_message_calls_in_progress.size() >= _node_configuration.maximum_number_of_blocks_to_handle_at_one_time)
+        if (_number_of_sync_blocks_in_progress >= _node_configuration.maximum_number_of_blocks_to_handle_at_one_time)
         {
           dlog("stopping processing sync block backlog because we have ${count} blocks in progress",
-               ("count", _handle_message_calls_in_progress.size()));
+               ("count", _number_of_sync_blocks_in_progress));
           //ulog("stopping processing sync block backlog because we have ${count} blocks in progress, total on hand: ${received}",
           //     ("count", _handle_message_calls_in_progress.size())("received", _received_sync_items.size()));
           if (_received_sync_items.size() >= _node_configuration.maximum_number_of_sync_blocks_to_prefetch)
@@ -3415,6 +3615,8 @@ namespace graphene { namespace net {
         }
       } while (block_processed_this_iteration);
 
+      send_blocks_to_node_delegate();
+
       dlog("leaving process_backlog_of_sync_blocks, ${count} processed", ("count", blocks_processed));
 
       if (!_suspend_fetching_sync_blocks)
@@ -3600,7 +3802,7 @@ namespace graphene { namespace net {
       }
     }
     void node_impl::process_block_message(peer_connection* originating_peer,
-                                          const message& message_to_process,
+                                          const received_message& message_to_process,
                                           const message_hash_type& message_hash)
     {
       VERIFY_CORRECT_THREAD();
@@ -3609,7 +3811,11 @@ namespace graphene { namespace net {
       // (it's possible that we request an item during normal operation and then get kicked into sync
       // mode before we receive and process the item.  In that case, we should process the item as a normal
       // item to avoid confusing the sync code)
-      graphene::net::block_message block_message_to_process(message_to_process.as<graphene::net::block_message>());
+      // the read loop normally unpacked the block already, unpacking here only reproduces its error
+      graphene::net::block_message unpacked_block_message;
+      if (!message_to_process.block)
+        unpacked_block_message = message_to_process.as<graphene::net::block_message>();
+      const graphene::net::block_message& block_message_to_process = message_to_process.block ? *message_to_process.block : unpacked_block_message;
       auto item_iter = originating_peer->items_requested_from_peer.find(item_id(graphene::net::block_message_type, message_hash));
       if (item_iter != originating_peer->items_requested_from_peer.end())
       {
@@ -3632,6 +3838,8 @@ namespace graphene { namespace net {
           // of the function so we can log if this ever happens.
           try
           {
+            originating_peer->sync_bytes_received += message_to_process.size;
+            originating_peer->sync_receive_time += message_receive_time - originating_peer->last_sync_item_received_time;
             originating_peer->last_sync_item_received_time = fc::time_point::now();
             _active_sync_requests.erase(block_message_to_process.block_id);
             process_block_during_sync(originating_peer, block_message_to_process, message_hash);
@@ -3700,6 +3908,22 @@ namespace graphene { namespace net {
                                                          (current_time_reply_message_received.reply_transmitted_time - reply_received_time)).count() / 2);
       originating_peer->round_trip_delay = (reply_received_time - current_time_reply_message_received.request_sent_time) -
                                            (current_time_reply_message_received.reply_transmitted_time - current_time_reply_message_received.request_received_time);
+
+      fc::optional<fc::ip::endpoint> inbound_endpoint = originating_peer->get_endpoint_for_connecting();
+      if (inbound_endpoint && originating_peer->round_trip_delay > fc::microseconds())
+      {
+        fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+        if (updated_peer_record)
+        {
+          // a moving average, so one slow reply doesn't push the peer down the list
+          if (updated_peer_record->average_round_trip_delay == fc::microseconds())
+            updated_peer_record->average_round_trip_delay = originating_peer->round_trip_delay;
+          else
+            updated_peer_record->average_round_trip_delay = fc::microseconds((updated_peer_record->average_round_trip_delay.count() * 3 +
+                                                                              originating_peer->round_trip_delay.count()) / 4);
+          _potential_peer_db.update_entry(*updated_peer_record);
+        }
+      }
     }
 
     void node_impl::forward_firewall_check_to_next_available_peer(firewall_check_state_data* firewall_check_state)
@@ -3780,7 +4004,7 @@ namespace graphene { namespace net {
         {
           // we're not connected to them, so we need to set up a connection to them
           // to test.
-          peer_connection_ptr peer_for_testing(peer_connection::make_shared(this));
+          peer_connection_ptr peer_for_testing(create_peer_connection());
           peer_for_testing->firewall_check_state = new firewall_check_state_data;
           peer_for_testing->firewall_check_state->endpoint_to_test = check_firewall_message_received.endpoint_to_check;
           peer_for_testing->firewall_check_state->expected_node_id = check_firewall_message_received.node_id;
@@ -3940,13 +4164,182 @@ namespace graphene { namespace net {
     }
 
 
+    message_ptr node_impl::get_compact_block_message(const message_ptr& full_block_message, const message_hash_type& full_block_message_hash)
+    {
+      VERIFY_CORRECT_THREAD();
+      // every peer asking for a new block gets the same compact message, so build it once and keep it
+      // in the message cache next to the full block, filed under the block id like the full block is
+      const block_id_type block_id = _message_cache.get_message_contents_hash(full_block_message_hash);
+      try
+      {
+        return _message_cache.get_message_by_contents_hash(compact_block_message_type, block_id);
+      }
+      catch (const fc::key_not_found_exception&)
+      {
+      }
+
+      graphene::net::block_message block = full_block_message->as<graphene::net::block_message>();
+      message compact_message(compact_block_message(block.block, block.block_id));
+      message_propagation_data propagation_data{fc::time_point::now(), fc::time_point::now(), _node_id};
+      _message_cache.cache_message(compact_message, compact_message.id(), propagation_data, block.block_id);
+      return _message_cache.get_message_by_contents_hash(compact_block_message_type, block.block_id);
+    }
+
+    void node_impl::on_compact_block_message(peer_connection* originating_peer,
+                                             const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      // a compact block only ever answers one of our block requests.  Those are filed under the hash of the
+      // full block message, which is only known once the block is rebuilt, so here we can only check that a
+      // request is open; process_block_message checks the rebuilt block against the exact request.
+      bool block_was_requested =
+        originating_peer->sync_items_requested_from_peer.find(compact_block_message_received.block_id) !=
+          originating_peer->sync_items_requested_from_peer.end() ||
+        std::any_of(originating_peer->items_requested_from_peer.begin(), originating_peer->items_requested_from_peer.end(),
+                    [](const peer_connection::item_to_time_map_type::value_type& item_and_time) {
+                      return item_and_time.first.item_type == block_message_type;
+                    });
+      if (!block_was_requested ||
+          (!originating_peer->partial_blocks_from_peer.count(compact_block_message_received.block_id) &&
+           originating_peer->partial_blocks_from_peer.size() >= originating_peer->items_requested_from_peer.size() +
+                                                                originating_peer->sync_items_requested_from_peer.size()))
+      {
+        wlog("received a compact block ${block_id} I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint())
+             ("block_id", compact_block_message_received.block_id));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a block that I didn't ask for, block_id: ${block_id}",
+                                                    ("block_id", compact_block_message_received.block_id)));
+        disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
+        return;
+      }
+
+      peer_connection::partially_received_block partial_block(compact_block_message_received,
+        [this](short_transaction_id_type short_id) -> fc::optional<signed_transaction> {
+          message_ptr transaction_message = _message_cache.find_transaction_by_short_id(short_id);
+          if (transaction_message)
+            return transaction_message->as<trx_message>().trx;
+          return fc::optional<signed_transaction>();
+        });
+
+      dlog("received compact block ${block_id} from peer ${endpoint}, missing ${missing} of ${total} transactions",
+           ("block_id", compact_block_message_received.block_id)
+           ("endpoint", originating_peer->get_remote_endpoint())
+           ("missing", partial_block.missing_transaction_indexes.size())
+           ("total", partial_block.block.transactions.size()));
+
+      process_reconstructed_block(originating_peer, std::move(partial_block));
+    }
+
+    void node_impl::on_get_block_transactions_message(peer_connection* originating_peer,
+                                                      const get_block_transactions_message& get_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      block_transactions_message reply;
+      reply.block_id = get_block_transactions_message_received.block_id;
+
+      try
+      {
+        message_ptr full_block_message;
+        try
+        {
+          full_block_message = _message_cache.get_message_by_contents_hash(block_message_type, reply.block_id);
+        }
+        catch (const fc::key_not_found_exception&)
+        {
+          full_block_message = std::make_shared<message>(_delegate->get_item(item_id(block_message_type, reply.block_id)));
+        }
+
+        const graphene::net::block_message full_block = full_block_message->as<graphene::net::block_message>();
+        const signed_block& block = full_block.block;
+        reply.transactions.reserve(get_block_transactions_message_received.transaction_indexes.size());
+        for (uint32_t index : get_block_transactions_message_received.transaction_indexes)
+        {
+          FC_ASSERT(index < block.transactions.size(), "transaction index ${index} out of range", ("index", index));
+          reply.transactions.push_back(block.transactions[index]);
+        }
+      }
+      catch (const fc::exception& e)
+      {
+        // an empty reply tells the peer to drop the partial block and get it elsewhere
+        wlog("unable to supply transactions of block ${block_id} to peer ${endpoint}: ${e}",
+             ("block_id", reply.block_id)("endpoint", originating_peer->get_remote_endpoint())("e", e));
+        reply.transactions.clear();
+      }
+
+      originating_peer->send_message(message(reply));
+    }
+
+    void node_impl::on_block_transactions_message(peer_connection* originating_peer,
+                                                  const block_transactions_message& block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      auto partial_block_iter = originating_peer->partial_blocks_from_peer.find(block_transactions_message_received.block_id);
+      if (partial_block_iter == originating_peer->partial_blocks_from_peer.end())
+      {
+        wlog("received transactions for block ${block_id} from peer ${endpoint}, which we are not waiting for",
+             ("block_id", block_transactions_message_received.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+
+      peer_connection::partially_received_block partial_block = std::move(partial_block_iter->second);
+      originating_peer->partial_blocks_from_peer.erase(partial_block_iter);
+
+      if (!partial_block.add_missing_transactions(block_transactions_message_received.transactions))
+      {
+        // the block request stays open, so it is fetched again once it times out
+        wlog("peer ${endpoint} sent ${count} transactions for block ${block_id} but we asked for ${expected}, dropping the block",
+             ("endpoint", originating_peer->get_remote_endpoint())
+             ("count", block_transactions_message_received.transactions.size())
+             ("block_id", partial_block.block_id)
+             ("expected", partial_block.missing_transaction_indexes.size()));
+        return;
+      }
+
+      process_reconstructed_block(originating_peer, std::move(partial_block));
+    }
+
+    void node_impl::process_reconstructed_block(peer_connection* originating_peer, peer_connection::partially_received_block&& partial_block)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (partial_block.has_short_id_collision())
+      {
+        // a short id matched a different transaction than the one in the block, ask for all of them
+        dlog("compact block ${block_id} from peer ${endpoint} did not match its merkle root, requesting all transactions",
+             ("block_id", partial_block.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        partial_block.mark_all_transactions_missing();
+      }
+
+      if (!partial_block.missing_transaction_indexes.empty())
+      {
+        // a newer compact block for the same block replaces one still waiting for its transactions
+        get_block_transactions_message request;
+        request.block_id = partial_block.block_id;
+        request.transaction_indexes = partial_block.missing_transaction_indexes;
+        originating_peer->partial_blocks_from_peer.erase(partial_block.block_id);
+        originating_peer->partial_blocks_from_peer.emplace(partial_block.block_id, std::move(partial_block));
+        originating_peer->send_message(message(request));
+        return;
+      }
+
+      // From here on the block is handled exactly as if it had arrived in a block_message.  It packs to
+      // the same bytes as the block the peer offered, so its hash matches our request for it.
+      received_message reconstructed_message;
+      auto reconstructed_block = std::make_shared<graphene::net::block_message>(std::move(partial_block.block));
+      message full_block_message(*reconstructed_block);
+      static_cast<message_header&>(reconstructed_message) = full_block_message;
+      reconstructed_message.data = std::move(full_block_message.data);
+      reconstructed_message.hash = reconstructed_message.id();
+      reconstructed_message.block = reconstructed_block;
+      process_block_message(originating_peer, reconstructed_message, reconstructed_message.hash);
+    }
+
     // this handles any message we get that doesn't require any special processing.
     // currently, this is any message other than block messages and p2p-specific
     // messages.  (transaction messages would be handled here, for example)
     // this just passes the message to the client, and does the bookkeeping
     // related to requesting and rebroadcasting the message.
     void node_impl::process_ordinary_message( peer_connection* originating_peer,
-                                              const message& message_to_process, const message_hash_type& message_hash )
+                                              const received_message& message_to_process, const message_hash_type& message_hash )
     {
       VERIFY_CORRECT_THREAD();
       fc::time_point message_receive_time = fc::time_point::now();
@@ -3975,7 +4368,18 @@ namespace graphene { namespace net {
         {
           if (message_to_process.msg_type == trx_message_type)
           {
-            trx_message transaction_message_to_process = message_to_process.as<trx_message>();
+            if (!originating_peer->transaction_tokens.try_consume())
+            {
+              // the peer is sending more than its share, drop the transaction without looking at it
+              ++originating_peer->number_of_transactions_dropped;
+              dlog("dropping transaction from ${peer}, it has exceeded its transaction rate", ("peer", originating_peer->get_remote_endpoint()));
+              return;
+            }
+
+            trx_message unpacked_transaction_message;
+            if (!message_to_process.trx)
+              unpacked_transaction_message = message_to_process.as<trx_message>();
+            const trx_message& transaction_message_to_process = message_to_process.trx ? *message_to_process.trx : unpacked_transaction_message;
             dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process.trx.id()));
             _delegate->handle_transaction(transaction_message_to_process);
           }
@@ -3992,6 +4396,22 @@ namespace graphene { namespace net {
           wlog( "client rejected message sent by peer ${peer}, ${e}", ("peer", originating_peer->get_remote_endpoint() )("e", e) );
           // record it so we don't try to fetch this item again
           _recently_failed_items.insert(peer_connection::timestamped_item_id(item_id(message_to_process.msg_type, message_hash ), fc::time_point::now()));
+
+          // only transactions that are invalid whatever the chain state count against the peer.  A
+          // duplicate or expired transaction may just mean the peer's view of the chain differs from ours
+          if (message_to_process.msg_type == trx_message_type &&
+              e.code() == invalid_transaction_exception::code_value)
+          {
+            ++originating_peer->number_of_transactions_rejected;
+            if (!originating_peer->rejected_transaction_tokens.try_consume())
+            {
+              wlog("peer ${peer} has sent us ${count} invalid transactions, disconnecting",
+                   ("peer", originating_peer->get_remote_endpoint())("count", originating_peer->number_of_transactions_rejected));
+              fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent too many invalid transactions, ${count} so far",
+                                                          ("count", originating_peer->number_of_transactions_rejected)));
+              disconnect_from_peer(originating_peer, "You sent too many invalid transactions", true, detailed_error);
+            }
+          }
           return;
         }
 
@@ -4337,6 +4757,20 @@ namespace graphene { namespace net {
       {
         wlog( "Exception thrown while terminating Dump node status task, ignoring" );
       }
+
+      try
+      {
+        _flush_peer_database_task_done.cancel_and_wait("node_impl::close()");
+        dlog("Flush peer database task terminated");
+      }
+      catch ( const fc::exception& e )
+      {
+        wlog( "Exception thrown while terminating Flush peer database task, ignoring: ${e}", ("e", e) );
+      }
+      catch (...)
+      {
+        wlog( "Exception thrown while terminating Flush peer database task, ignoring" );
+      }
     } // node_impl::close()
 
     void node_impl::accept_connection_task( peer_connection_ptr new_peer )
@@ -4349,7 +4783,7 @@ namespace graphene { namespace net {
     {
       while ( !_accept_loop_complete.canceled() )
       {
-        peer_connection_ptr new_peer(peer_connection::make_shared(this));
+        peer_connection_ptr new_peer(create_peer_connection());
 
         try
         {
@@ -4591,12 +5025,19 @@ namespace graphene { namespace net {
       {
         _potential_peer_db.open(potential_peer_database_file_name);
 
+        // nodes upgrading from the json peer database keep the peers they already know
+        fc::path legacy_peer_database_file_name(_node_configuration_directory / LEGACY_POTENTIAL_PEER_DATABASE_FILENAME);
+        if (_potential_peer_db.size() == 0 && fc::exists(legacy_peer_database_file_name))
+          _potential_peer_db.import_json(legacy_peer_database_file_name);
+
         // push back the time on all peers loaded from the database so we will be able to retry them immediately
+        const fc::time_point_sec retry_time = fc::time_point::now() - fc::seconds(_node_configuration.peer_connection_retry_timeout);
         for (peer_database::iterator itr = _potential_peer_db.begin(); itr != _potential_peer_db.end(); ++itr)
         {
+          if (itr->last_connection_attempt_time <= retry_time)
+            continue;
           potential_peer_record updated_peer_record = *itr;
-          updated_peer_record.last_connection_attempt_time = std::min<fc::time_point_sec>(updated_peer_record.last_connection_attempt_time,
-                                                                                          fc::time_point::now() - fc::seconds(_node_configuration.peer_connection_retry_timeout));
+          updated_peer_record.last_connection_attempt_time = retry_time;
           _potential_peer_db.update_entry(updated_peer_record);
         }
 
@@ -4717,7 +5158,8 @@ namespace graphene { namespace net {
              !_terminate_inactive_connections_loop_done.valid() &&
              !_fetch_updated_peer_lists_loop_done.valid() &&
              !_bandwidth_monitor_loop_done.valid() &&
-             !_dump_node_status_task_done.valid());
+             !_dump_node_status_task_done.valid() &&
+             !_flush_peer_database_task_done.valid());
       if (_node_configuration.accept_incoming_connections)
         _accept_loop_complete = async_task( [=](){ accept_loop(); }, "accept_loop");
       _p2p_network_connect_loop_done = async_task( [=]() { p2p_network_connect_loop(); }, "p2p_network_connect_loop" );
@@ -4728,6 +5170,9 @@ namespace graphene { namespace net {
       _fetch_updated_peer_lists_loop_done = async_task([=](){ fetch_updated_peer_lists_loop(); }, "fetch_updated_peer_lists_loop");
       _bandwidth_monitor_loop_done = async_task([=](){ bandwidth_monitor_loop(); }, "bandwidth_monitor_loop");
       _dump_node_status_task_done = async_task([=](){ dump_node_status_task(); }, "dump_node_status_task");
+      _flush_peer_database_task_done = schedule_task([=](){ flush_peer_database_task(); },
+                                                    fc::time_point::now() + fc::seconds(GRAPHENE_NET_PEERDB_FLUSH_INTERVAL_SECONDS),
+                                                    "flush_peer_database_task");
     }
 
     void node_impl::add_node(const fc::ip::endpoint& ep)
@@ -4775,7 +5220,7 @@ namespace graphene { namespace net {
                            ("endpoint", remote_endpoint));
 
       dlog("node_impl::connect_to_endpoint(${endpoint})", ("endpoint", remote_endpoint));
-      peer_connection_ptr new_peer(peer_connection::make_shared(this));
+      peer_connection_ptr new_peer(create_peer_connection());
       new_peer->set_remote_endpoint(remote_endpoint);
       initiate_connect_to(new_peer);
     }
@@ -4877,6 +5322,7 @@ namespace graphene { namespace net {
         ilog( "    peer.ids_of_items_to_get size: ${size}", ("size", peer->ids_of_items_to_get.size() ) );
         ilog( "    peer.inventory_peer_advertised_to_us size: ${size}", ("size", peer->inventory_peer_advertised_to_us.size() ) );
         ilog( "    peer.inventory_advertised_to_peer size: ${size}", ("size", peer->inventory_advertised_to_peer.size() ) );
+        ilog( "    peer.transactions_advertised_to_peer approximate size: ${size}", ("size", peer->transactions_advertised_to_peer.size() ) );
         ilog( "    peer.items_requested_from_peer size: ${size}", ("size", peer->items_requested_from_peer.size() ) );
         ilog( "    peer.sync_items_requested_from_peer size: ${size}", ("size", peer->sync_items_requested_from_peer.size() ) );
       }
@@ -4994,7 +5440,8 @@ namespace graphene { namespace net {
         peer_details["inbound"] = peer->direction == peer_connection_direction::inbound;
         peer_details["firewall_status"] = peer->is_firewalled;
         peer_details["startingheight"] = "";
-        peer_details["banscore"] = "";
+        peer_details["banscore"] = peer->number_of_transactions_rejected;
+        peer_details["transactions_dropped"] = peer->number_of_transactions_dropped;
         peer_details["syncnode"] = "";
 
         if (peer->fc_git_revision_sha)
@@ -5114,6 +5561,11 @@ namespace graphene { namespace net {
       // Private key could have been overridden at this point. Update public key just in case
       _node_public_key = _node_configuration.private_key.get_public_key().serialize();
 
+      FC_ASSERT( _node_configuration.socket_buffer_size >= 16 &&
+                 _node_configuration.socket_buffer_size <= GRAPHENE_NET_MAX_SOCKET_BUFFER_SIZE,
+                 "socket_buffer_size must be between 16 and ${max} bytes",
+                 ("socket_buffer_size", _node_configuration.socket_buffer_size)("max", GRAPHENE_NET_MAX_SOCKET_BUFFER_SIZE) );
+
       if( _node_configuration.desired_number_of_connections > _node_configuration.maximum_number_of_connections )
       {
          wlog( "Reducing desired_number_of_connections from ${x0} to maximum_number_of_connections=${x1}",
@@ -5593,6 +6045,16 @@ namespace graphene { namespace net {
       INVOKE_AND_COLLECT_STATISTICS(handle_block, block_message, sync_mode, contained_transaction_message_ids);
     }
 
+    void statistics_gathering_node_delegate_wrapper::precheck_sync_blocks( const std::vector<const graphene::net::block_message*>& blocks )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(precheck_sync_blocks, blocks);
+    }
+
+    std::vector<fc::oexception> statistics_gathering_node_delegate_wrapper::handle_sync_blocks( const std::vector<const graphene::net::block_message*>& blocks )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(handle_sync_blocks, blocks);
+    }
+
     void statistics_gathering_node_delegate_wrapper::handle_transaction( const graphene::net::trx_message& transaction_message )
     {
       INVOKE_AND_COLLECT_STATISTICS(handle_transaction, transaction_message);
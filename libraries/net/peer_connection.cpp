@@ -43,24 +43,35 @@
 
 namespace graphene { namespace net
   {
-    message peer_connection::real_queued_message::get_message(peer_connection_delegate*)
+    message_ptr peer_connection::real_queued_message::get_message(peer_connection_delegate*)
     {
       if (message_send_time_field_offset != (size_t)-1)
       {
         // patch the current time into the message.  Since this operates on the packed version of the structure,
         // it won't work for anything after a variable-length field
         std::vector<char> packed_current_time = fc::raw::pack_to_vector(fc::time_point::now());
-        assert(message_send_time_field_offset + packed_current_time.size() <= message_to_send.data.size());
-        memcpy(message_to_send.data.data() + message_send_time_field_offset,
+        assert(message_send_time_field_offset + packed_current_time.size() <= message_to_send->data.size());
+        memcpy(message_to_send->data.data() + message_send_time_field_offset,
                packed_current_time.data(), packed_current_time.size());
       }
       return message_to_send;
     }
     size_t peer_connection::real_queued_message::get_size_in_queue()
     {
-      return message_to_send.data.size();
+      return message_to_send->data.size();
     }
-    message peer_connection::virtual_queued_message::get_message(peer_connection_delegate* node)
+
+    message_ptr peer_connection::shared_queued_message::get_message(peer_connection_delegate*)
+    {
+      return message_to_send;
+    }
+    size_t peer_connection::shared_queued_message::get_size_in_queue()
+    {
+      // the memory is shared, but the queue limit protects against slow peers so count it in full
+      return message_to_send->data.size();
+    }
+
+    message_ptr peer_connection::virtual_queued_message::get_message(peer_connection_delegate* node)
     {
       return node->get_message_for_item(item_to_send);
     }
@@ -85,6 +96,9 @@ namespace graphene { namespace net
       peer_needs_sync_items_from_us(true),
       we_need_sync_items_from_peer(true),
       inhibit_fetching_sync_blocks(false),
+      transactions_advertised_to_peer(GRAPHENE_NET_INVENTORY_FILTER_ITEMS_PER_GENERATION,
+                                      GRAPHENE_NET_INVENTORY_FILTER_FALSE_POSITIVE_RATE,
+                                      fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES)),
       transaction_fetching_inhibited_until(fc::time_point::min()),
       last_known_fork_block_number(0),
       firewall_check_state(nullptr),
@@ -184,6 +198,18 @@ namespace graphene { namespace net
       return _message_connection.get_socket();
     }
 
+    void peer_connection::set_socket_buffer_size(size_t buffer_size)
+    {
+      VERIFY_CORRECT_THREAD();
+      _message_connection.set_socket_buffer_size(buffer_size);
+    }
+
+    void peer_connection::set_decode_thread(fc::thread* decode_thread)
+    {
+      VERIFY_CORRECT_THREAD();
+      _message_connection.set_decode_thread(decode_thread);
+    }
+
     void peer_connection::accept_connection()
     {
       VERIFY_CORRECT_THREAD();
@@ -264,7 +290,7 @@ namespace graphene { namespace net
       }
     } // connect_to()
 
-    void peer_connection::on_message( message_oriented_connection* originating_connection, const message& received_message )
+    void peer_connection::on_message( message_oriented_connection* originating_connection, const received_message& received_message )
     {
       VERIFY_CORRECT_THREAD();
       _currently_handling_message = true;
@@ -294,13 +320,13 @@ namespace graphene { namespace net
       while (!_queued_messages.empty())
       {
         _queued_messages.front()->transmission_start_time = fc::time_point::now();
-        message message_to_send = _queued_messages.front()->get_message(_node);
+        message_ptr message_to_send = _queued_messages.front()->get_message(_node);
         try
         {
           //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
           //     "to send message of type ${type} for peer ${endpoint}",
           //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
-          _message_connection.send_message(message_to_send);
+          _message_connection.send_message(*message_to_send);
           //dlog("peer_connection::send_queued_messages_task()'s call to message_oriented_connection::send_message() completed normally for peer ${endpoint}",
           //     ("endpoint", get_remote_endpoint()));
         }
@@ -378,6 +404,13 @@ namespace graphene { namespace net
       send_queueable_message(std::move(message_to_enqueue));
     }
 
+    void peer_connection::send_message(const message_ptr& message_to_send)
+    {
+      VERIFY_CORRECT_THREAD();
+      std::unique_ptr<queued_message> message_to_enqueue(new shared_queued_message(message_to_send));
+      send_queueable_message(std::move(message_to_enqueue));
+    }
+
     void peer_connection::send_item(const item_id& item_to_send)
     {
       VERIFY_CORRECT_THREAD();
@@ -485,17 +518,85 @@ namespace graphene { namespace net
       unsigned number_of_elements_advertised_to_peer_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
       inventory_advertised_to_peer.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
 
+      // the filter of transactions advertised to the peer drops a whole generation at a time
+      transactions_advertised_to_peer.expire_old_generation();
+
       // also expire items from inventory_peer_advertised_to_us
       oldest_inventory_to_keep_iter = inventory_peer_advertised_to_us.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
       begin_iter = inventory_peer_advertised_to_us.get<timestamp_index>().begin();
       unsigned number_of_elements_peer_advertised_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
       inventory_peer_advertised_to_us.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
-      dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left), and ${to_us} advertised to us (${remain_to_us} left)",
+      dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left, about ${remain_trx_to_peer} transactions), and ${to_us} advertised to us (${remain_to_us} left)",
            ("peer", get_remote_endpoint())
            ("to_peer", number_of_elements_advertised_to_peer_to_discard)("remain_to_peer", inventory_advertised_to_peer.size())
+           ("remain_trx_to_peer", transactions_advertised_to_peer.size())
            ("to_us", number_of_elements_peer_advertised_to_discard)("remain_to_us", inventory_peer_advertised_to_us.size()));
     }
 
+    bool peer_connection::was_item_advertised_to_peer(const item_id& item) const
+    {
+      VERIFY_CORRECT_THREAD();
+      if (item.item_type == trx_message_type)
+        return transactions_advertised_to_peer.contains(item);
+      return inventory_advertised_to_peer.find(item) != inventory_advertised_to_peer.end();
+    }
+
+    void peer_connection::item_advertised_to_peer(const item_id& item)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (item.item_type == trx_message_type)
+        transactions_advertised_to_peer.insert(item);
+      else
+        inventory_advertised_to_peer.insert(timestamped_item_id(item, fc::time_point::now()));
+    }
+
+    peer_connection::partially_received_block::partially_received_block(const compact_block_message& compact_block,
+                                                                        const transaction_lookup_type& find_transaction) :
+      block_id(compact_block.block_id)
+    {
+      static_cast<signed_block_header&>(block) = compact_block.header;
+      block.transactions.resize(compact_block.short_transaction_ids.size());
+
+      for (uint32_t i = 0; i < compact_block.short_transaction_ids.size(); ++i)
+      {
+        fc::optional<signed_transaction> transaction = find_transaction(compact_block.short_transaction_ids[i]);
+        if (transaction)
+        {
+          block.transactions[i] = std::move(*transaction);
+          has_transactions_found_by_short_id = true;
+        }
+        else
+          missing_transaction_indexes.push_back(i);
+      }
+    }
+
+    bool peer_connection::partially_received_block::add_missing_transactions(const std::vector<signed_transaction>& transactions)
+    {
+      if (transactions.size() != missing_transaction_indexes.size())
+        return false;
+
+      for (uint32_t i = 0; i < missing_transaction_indexes.size(); ++i)
+        block.transactions[missing_transaction_indexes[i]] = transactions[i];
+      missing_transaction_indexes.clear();
+      return true;
+    }
+
+    bool peer_connection::partially_received_block::has_short_id_collision() const
+    {
+      // with every transaction sent by the peer a mismatch is the block's own fault, not ours
+      return missing_transaction_indexes.empty() &&
+             has_transactions_found_by_short_id &&
+             block.calculate_merkle_root() != block.transaction_merkle_root;
+    }
+
+    void peer_connection::partially_received_block::mark_all_transactions_missing()
+    {
+      missing_transaction_indexes.resize(block.transactions.size());
+      for (uint32_t i = 0; i < missing_transaction_indexes.size(); ++i)
+        missing_transaction_indexes[i] = i;
+      has_transactions_found_by_short_id = false;
+    }
+
     // we have a higher limit for blocks than transactions so we will still fetch blocks even when transactions are throttled
     bool peer_connection::is_inventory_advertised_to_us_list_full_for_transactions() const
     {
@@ -32,11 +32,33 @@
 #include <fc/io/raw_variant.hpp>
 #include <fc/log/logger.hpp>
 #include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
+
+#include <fstream>
+#include <unordered_set>
 
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/config.hpp>
 
 namespace graphene { namespace net {
+
+  int64_t potential_peer_record::connection_score() const
+  {
+    // the share of successful connections, scaled to 0..1000.  A peer we know nothing about starts at 500
+    int64_t score = 1000 * (int64_t(number_of_successful_connection_attempts) + 1) /
+                    (int64_t(number_of_successful_connection_attempts) + number_of_failed_connection_attempts + 2);
+
+    // up to 500 for sync throughput, 25 for each doubling of the bytes per second it delivered
+    int64_t throughput_bits = 0;
+    for (uint32_t rate = sync_bytes_per_second; rate > 1; rate >>= 1)
+      ++throughput_bits;
+    score += std::min<int64_t>(25 * throughput_bits, 500);
+
+    // and up to 500 off for a slow round trip, one for every 4ms
+    score -= std::min<int64_t>(average_round_trip_delay.count() / 4000, 500);
+    return score;
+  }
+
   namespace detail
   {
     using namespace boost::multi_index;
@@ -44,13 +66,14 @@ namespace graphene { namespace net {
     class peer_database_impl
     {
     public:
-      struct last_seen_time_index {};
+      struct score_index {};
       struct endpoint_index {};
       typedef boost::multi_index_container<potential_peer_record, 
-                                           indexed_by<ordered_non_unique<tag<last_seen_time_index>, 
-                                                                         member<potential_peer_record, 
-                                                                                fc::time_point_sec, 
-                                                                                &potential_peer_record::last_seen_time> >,
+                                           indexed_by<ordered_non_unique<tag<score_index>, 
+                                                                         const_mem_fun<potential_peer_record, 
+                                                                                       int64_t, 
+                                                                                       &potential_peer_record::connection_score>,
+                                                                         std::greater<int64_t> >,
                                                       hashed_unique<tag<endpoint_index>, 
                                                                     member<potential_peer_record, 
                                                                            fc::ip::endpoint, 
@@ -58,13 +81,28 @@ namespace graphene { namespace net {
                                                                     std::hash<fc::ip::endpoint> > > > potential_peer_set;
 
     private:
+      enum journal_entry_type : uint8_t
+      {
+        journal_update_entry,
+        journal_erase_entry
+      };
+
       potential_peer_set     _potential_peer_set;
       fc::path _peer_database_filename;
+      std::fstream _journal;
+      size_t _journal_entries = 0;
+      /// endpoints updated or erased since the journal was last written
+      std::unordered_set<fc::ip::endpoint> _dirty_endpoints;
+
+      void load_journal();
+      void rewrite_journal();
 
     public:
       void open(const fc::path& databaseFilename);
       void close();
       void clear();
+      void flush();
+      void import_json(const fc::path& json_filename);
       void erase(const fc::ip::endpoint& endpointToErase);
       void update_entry(const potential_peer_record& updatedRecord);
       potential_peer_record lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup);
@@ -78,9 +116,9 @@ namespace graphene { namespace net {
     class peer_database_iterator_impl
     {
     public:
-      typedef peer_database_impl::potential_peer_set::index<peer_database_impl::last_seen_time_index>::type::iterator last_seen_time_index_iterator;
-      last_seen_time_index_iterator _iterator;
-      peer_database_iterator_impl(const last_seen_time_index_iterator& iterator) :
+      typedef peer_database_impl::potential_peer_set::index<peer_database_impl::score_index>::type::iterator score_index_iterator;
+      score_index_iterator _iterator;
+      peer_database_iterator_impl(const score_index_iterator& iterator) :
         _iterator(iterator)
       {}
     };
@@ -94,12 +132,11 @@ namespace graphene { namespace net {
       {
         try
         {
-          std::vector<potential_peer_record> peer_records = fc::json::from_file(_peer_database_filename).as<std::vector<potential_peer_record> >();
-          std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
+          load_journal();
 
           if (_potential_peer_set.size() > GRAPHENE_NET_MAX_PEERDB_SIZE)
           {
-            // prune database to a reasonable size
+            // prune database to a reasonable size, keeping the peers we would connect to first
             auto iter = _potential_peer_set.begin();
             std::advance(iter, GRAPHENE_NET_MAX_PEERDB_SIZE);
             _potential_peer_set.erase(iter, _potential_peer_set.end());
@@ -109,41 +146,179 @@ namespace graphene { namespace net {
         {
           elog("error opening peer database file ${peer_database_filename}, starting with a clean database", 
                ("peer_database_filename", _peer_database_filename));
+          _potential_peer_set.clear();
         }
       }
-    }
-
-    void peer_database_impl::close()
-    {
-      std::vector<potential_peer_record> peer_records;
-      peer_records.reserve(_potential_peer_set.size());
-      std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
 
       try
       {
         fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
         if (!fc::exists(peer_database_filename_dir))
           fc::create_directories(peer_database_filename_dir);
-        fc::json::save_to_file(peer_records, _peer_database_filename);
+        rewrite_journal();
+      }
+      catch (const fc::exception& e)
+      {
+        elog("error writing peer database file ${peer_database_filename}, changes to it will not be saved",
+             ("peer_database_filename", _peer_database_filename));
+      }
+    }
+
+    void peer_database_impl::close()
+    {
+      try
+      {
+        if (_journal.is_open())
+          rewrite_journal();
       }
       catch (const fc::exception& e)
       {
         elog("error saving peer database to file ${peer_database_filename}", 
              ("peer_database_filename", _peer_database_filename));
       }
+      if (_journal.is_open())
+        _journal.close();
       _potential_peer_set.clear();
+      _dirty_endpoints.clear();
     }
 
     void peer_database_impl::clear()
     {
       _potential_peer_set.clear();
+      _dirty_endpoints.clear();
+      if (_journal.is_open())
+        rewrite_journal();
+    }
+
+    void peer_database_impl::import_json(const fc::path& json_filename)
+    {
+      try
+      {
+        std::vector<potential_peer_record> peer_records = fc::json::from_file(json_filename).as<std::vector<potential_peer_record> >();
+        for (const potential_peer_record& record : peer_records)
+          if (_potential_peer_set.size() < GRAPHENE_NET_MAX_PEERDB_SIZE)
+            _potential_peer_set.insert(record);
+        if (_journal.is_open())
+          rewrite_journal();
+        ilog("imported ${count} peers from ${filename}", ("count", _potential_peer_set.size())("filename", json_filename));
+      }
+      catch (const fc::exception& e)
+      {
+        elog("error importing peer database file ${filename}", ("filename", json_filename));
+      }
+    }
+
+    void peer_database_impl::load_journal()
+    {
+      std::ifstream journal(_peer_database_filename.generic_string().c_str(), std::ios::in | std::ios::binary);
+      std::vector<char> contents((std::istreambuf_iterator<char>(journal)), std::istreambuf_iterator<char>());
+
+      fc::datastream<const char*> ds(contents.data(), contents.size());
+      uint32_t magic = 0;
+      uint32_t version = 0;
+      fc::raw::unpack(ds, magic);
+      fc::raw::unpack(ds, version);
+      FC_ASSERT(magic == GRAPHENE_NET_PEERDB_MAGIC && version == GRAPHENE_NET_PEERDB_VERSION,
+                "not a peer database or an unsupported version", ("magic", magic)("version", version));
+
+      try
+      {
+        while (ds.remaining())
+        {
+          uint8_t type = 0;
+          std::vector<char> entry;
+          fc::raw::unpack(ds, type);
+          fc::raw::unpack(ds, entry);
+          if (type == journal_update_entry)
+          {
+            potential_peer_record record = fc::raw::unpack_from_vector<potential_peer_record>(entry);
+            auto iter = _potential_peer_set.get<endpoint_index>().find(record.endpoint);
+            if (iter != _potential_peer_set.get<endpoint_index>().end())
+              _potential_peer_set.get<endpoint_index>().replace(iter, record);
+            else
+              _potential_peer_set.insert(record);
+          }
+          else if (type == journal_erase_entry)
+            _potential_peer_set.get<endpoint_index>().erase(fc::raw::unpack_from_vector<fc::ip::endpoint>(entry));
+        }
+      }
+      catch (const fc::exception& e)
+      {
+        // the tail of the journal was cut short while it was being written, everything before it is good
+        wlog("ignoring a truncated entry at the end of peer database file ${peer_database_filename}",
+             ("peer_database_filename", _peer_database_filename));
+      }
+    }
+
+    void peer_database_impl::rewrite_journal()
+    {
+      if (_journal.is_open())
+        _journal.close();
+
+      fc::path temporary_filename = _peer_database_filename.generic_string() + ".tmp";
+      {
+        std::ofstream rewritten(temporary_filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        std::vector<char> header = fc::raw::pack_to_vector(std::make_pair(uint32_t(GRAPHENE_NET_PEERDB_MAGIC), uint32_t(GRAPHENE_NET_PEERDB_VERSION)));
+        rewritten.write(header.data(), header.size());
+        for (const potential_peer_record& record : _potential_peer_set)
+        {
+          std::vector<char> entry = fc::raw::pack_to_vector(std::make_pair(uint8_t(journal_update_entry), fc::raw::pack_to_vector(record)));
+          rewritten.write(entry.data(), entry.size());
+        }
+        rewritten.flush();
+        FC_ASSERT(rewritten.good(), "unable to write ${filename}", ("filename", temporary_filename));
+      }
+      fc::rename(temporary_filename, _peer_database_filename);
+
+      _journal.open(_peer_database_filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app);
+      _journal_entries = _potential_peer_set.size();
+      _dirty_endpoints.clear();
+    }
+
+    void peer_database_impl::flush()
+    {
+      if (!_journal.is_open() || _dirty_endpoints.empty())
+        return;
+
+      if (_journal_entries + _dirty_endpoints.size() >
+          GRAPHENE_NET_PEERDB_JOURNAL_COMPACTION_FACTOR * std::max<size_t>(_potential_peer_set.size(), GRAPHENE_NET_MAX_PEERDB_SIZE))
+      {
+        // the set already holds these changes, so rewriting it covers them too
+        try
+        {
+          rewrite_journal();
+        }
+        catch (const fc::exception& e)
+        {
+          elog("error compacting peer database file ${peer_database_filename}", ("peer_database_filename", _peer_database_filename));
+        }
+        return;
+      }
+
+      // an endpoint is written once however often it changed, as its record or as an erase if it is gone
+      std::vector<char> entries;
+      for (const fc::ip::endpoint& endpoint : _dirty_endpoints)
+      {
+        auto iter = _potential_peer_set.get<endpoint_index>().find(endpoint);
+        std::vector<char> packed_entry = iter != _potential_peer_set.get<endpoint_index>().end() ?
+          fc::raw::pack_to_vector(std::make_pair(uint8_t(journal_update_entry), fc::raw::pack_to_vector(*iter))) :
+          fc::raw::pack_to_vector(std::make_pair(uint8_t(journal_erase_entry), fc::raw::pack_to_vector(endpoint)));
+        entries.insert(entries.end(), packed_entry.begin(), packed_entry.end());
+      }
+      _journal.write(entries.data(), entries.size());
+      _journal.flush();
+      _journal_entries += _dirty_endpoints.size();
+      _dirty_endpoints.clear();
     }
 
     void peer_database_impl::erase(const fc::ip::endpoint& endpointToErase)
     {
       auto iter = _potential_peer_set.get<endpoint_index>().find(endpointToErase);
       if (iter != _potential_peer_set.get<endpoint_index>().end())
+      {
         _potential_peer_set.get<endpoint_index>().erase(iter);
+        _dirty_endpoints.insert(endpointToErase);
+      }
     }
 
     void peer_database_impl::update_entry(const potential_peer_record& updatedRecord)
@@ -153,6 +328,7 @@ namespace graphene { namespace net {
         _potential_peer_set.get<endpoint_index>().modify(iter, [&updatedRecord](potential_peer_record& record) { record = updatedRecord; });
       else
         _potential_peer_set.get<endpoint_index>().insert(updatedRecord);
+      _dirty_endpoints.insert(updatedRecord.endpoint);
     }
 
     potential_peer_record peer_database_impl::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup)
@@ -173,12 +349,12 @@ namespace graphene { namespace net {
 
     peer_database::iterator peer_database_impl::begin() const
     {
-      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().begin()));
+      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<score_index>().begin()));
     }
 
     peer_database::iterator peer_database_impl::end() const
     {
-      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().end()));
+      return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<score_index>().end()));
     }
 
     size_t peer_database_impl::size() const
@@ -239,6 +415,16 @@ namespace graphene { namespace net {
     my->clear();
   }
 
+  void peer_database::import_json(const fc::path& json_filename)
+  {
+    my->import_json(json_filename);
+  }
+
+  void peer_database::flush()
+  {
+    my->flush();
+  }
+
   void peer_database::erase(const fc::ip::endpoint& endpointToErase)
   {
     my->erase(endpointToErase);
@@ -33,13 +33,15 @@
 #include <fc/exception/exception.hpp>
 
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/config.hpp>
 
 namespace graphene { namespace net {
 
 stcp_socket::stcp_socket()
 //:_buf_len(0)
+   : _buffer_size(GRAPHENE_NET_DEFAULT_SOCKET_BUFFER_SIZE)
 #ifndef NDEBUG
-   : _read_buffer_in_use(false),
+   , _read_buffer_in_use(false),
      _write_buffer_in_use(false)
 #endif
 {
@@ -64,8 +66,9 @@ void stcp_socket::do_key_exchange()
 //    ilog("shared secret ${s}", ("s", shared_secret) );
   _send_aes.init( fc::sha256::hash( (char*)&_shared_secret, sizeof(_shared_secret) ), 
                   fc::city_hash_crc_128((char*)&_shared_secret,sizeof(_shared_secret) ) );
-  _recv_aes.init( fc::sha256::hash( (char*)&_shared_secret, sizeof(_shared_secret) ), 
-                  fc::city_hash_crc_128((char*)&_shared_secret,sizeof(_shared_secret) ) );
+  _recv_key = fc::sha256::hash( (char*)&_shared_secret, sizeof(_shared_secret) );
+  _recv_iv = fc::city_hash_crc_128((char*)&_shared_secret,sizeof(_shared_secret) );
+  _recv_aes.init( _recv_key, _recv_iv );
 }
 
 
@@ -80,6 +83,22 @@ void stcp_socket::bind( const fc::ip::endpoint& local_endpoint )
   _sock.bind(local_endpoint);
 }
 
+void stcp_socket::set_buffer_size( size_t buffer_size )
+{
+  buffer_size &= ~size_t(15);
+  FC_ASSERT( buffer_size >= 16 && buffer_size <= GRAPHENE_NET_MAX_SOCKET_BUFFER_SIZE,
+             "invalid socket buffer size", ("buffer_size", buffer_size) );
+#ifndef NDEBUG
+  assert( !_read_buffer_in_use && !_write_buffer_in_use );
+#endif
+  if( buffer_size == _buffer_size )
+    return;
+  // the buffers are allocated lazily at the new size on the next read or write
+  _buffer_size = buffer_size;
+  _read_buffer.reset();
+  _write_buffer.reset();
+}
+
 /**
  *   This method must read at least 16 bytes at a time from
  *   the underlying TCP socket so that it can decrypt them. It
@@ -100,11 +119,12 @@ size_t stcp_socket::readsome( char* buffer, size_t len )
     } buffer_in_use_checker(_read_buffer_in_use);
 #endif
 
-    const size_t read_buffer_length = 4096;
     if (!_read_buffer)
-      _read_buffer.reset(new char[read_buffer_length], [](char* p){ delete[] p; });
+      _read_buffer.reset(new char[_buffer_size], [](char* p){ delete[] p; });
 
-    len = std::min<size_t>(read_buffer_length, len);
+    // the ciphertext is staged in _read_buffer, which the socket keeps alive if this task is
+    // canceled mid-read, and decrypted in one call straight into the caller's buffer
+    len = std::min<size_t>(_buffer_size, len);
 
     size_t s = _sock.readsome( _read_buffer, len, 0 );
     if( s % 16 ) 
@@ -112,6 +132,8 @@ size_t stcp_socket::readsome( char* buffer, size_t len )
       _sock.read(_read_buffer, 16 - (s%16), s);
       s += 16-(s%16);
     }
+    // the iv is copied as raw bytes, matching how aes_decoder::init() hands it to openssl
+    memcpy( (char*)&_recv_iv, _read_buffer.get() + s - 16, 16 );
     _recv_aes.decode( _read_buffer.get(), s, buffer );
     return s;
 } FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
@@ -121,6 +143,35 @@ size_t stcp_socket::readsome( const std::shared_ptr<char>& buf, size_t len, size
   return readsome(buf.get() + offset, len);
 }
 
+/**
+ *   In CBC mode each block is decrypted from its own ciphertext and the one before it, so a
+ *   span can be decrypted on its own given the last ciphertext block that preceded it.  After
+ *   handing the span out, _recv_aes is restarted from the span's last block.
+ */
+stcp_socket::encrypted_data stcp_socket::read_encrypted( size_t len )
+{ try {
+    FC_ASSERT( len > 0 && (len % 16) == 0, "encrypted reads must be a multiple of 16 bytes", ("len",len) );
+
+    encrypted_data result;
+    result.data.reset(new char[len], [](char* p){ delete[] p; });
+    result.size = len;
+    result.key = _recv_key;
+    result.iv = _recv_iv;
+
+    _sock.read( result.data, len, 0 );
+
+    memcpy( (char*)&_recv_iv, result.data.get() + len - 16, 16 );
+    _recv_aes.init( _recv_key, _recv_iv );
+    return result;
+} FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
+
+void stcp_socket::encrypted_data::decrypt( char* plaintext )const
+{
+  fc::aes_decoder decoder;
+  decoder.init( key, iv );
+  decoder.decode( data.get(), size, plaintext );
+}
+
 bool stcp_socket::eof()const
 {
   return _sock.eof();
@@ -141,17 +192,9 @@ size_t stcp_socket::writesome( const char* buffer, size_t len )
     } buffer_in_use_checker(_write_buffer_in_use);
 #endif
 
-    const std::size_t write_buffer_length = 4096;
     if (!_write_buffer)
-      _write_buffer.reset(new char[write_buffer_length], [](char* p){ delete[] p; });
-    len = std::min<size_t>(write_buffer_length, len);
-    memset(_write_buffer.get(), 0, len); // just in case aes.encode screws up
-    /**
-     * every sizeof(crypt_buf) bytes the aes channel
-     * has an error and doesn't decrypt properly...  disable
-     * for now because we are going to upgrade to something
-     * better.
-     */
+      _write_buffer.reset(new char[_buffer_size], [](char* p){ delete[] p; });
+    len = std::min<size_t>(_buffer_size, len);
     uint32_t ciphertext_len = _send_aes.encode( buffer, len, _write_buffer.get() );
     assert(ciphertext_len == len);
     _sock.write( _write_buffer, ciphertext_len );
@@ -163,6 +206,81 @@ size_t stcp_socket::writesome( const std::shared_ptr<const char>& buf, size_t le
   return writesome(buf.get() + offset, len);
 }
 
+/**
+ *   Segments are encrypted straight into _write_buffer, which is sent whenever it fills up.
+ *   Only the few bytes of a cipher block that straddles two segments are staged separately.
+ */
+void stcp_socket::write_gather( const write_segment* segments, size_t count )
+{ try {
+    size_t total = 0;
+    for( size_t i = 0; i < count; ++i )
+      total += segments[i].size;
+    FC_ASSERT( total % 16 == 0, "gathered write must be a multiple of 16 bytes", ("size", total) );
+
+#ifndef NDEBUG
+    struct check_buffer_in_use {
+      bool& _buffer_in_use;
+      check_buffer_in_use(bool& buffer_in_use) : _buffer_in_use(buffer_in_use) { assert(!_buffer_in_use); _buffer_in_use = true; }
+      ~check_buffer_in_use() { assert(_buffer_in_use); _buffer_in_use = false; }
+    } buffer_in_use_checker(_write_buffer_in_use);
+#endif
+
+    const size_t write_buffer_length = _buffer_size;
+    if (!_write_buffer)
+      _write_buffer.reset(new char[write_buffer_length], [](char* p){ delete[] p; });
+
+    char*  out = _write_buffer.get();
+    size_t out_len = 0;
+    char   partial_block[16];
+    size_t partial_len = 0;
+
+    auto send_output = [&]() {
+      if( out_len )
+        _sock.write( _write_buffer, out_len );
+      out_len = 0;
+    };
+
+    for( size_t i = 0; i < count; ++i )
+    {
+      const char* data = segments[i].data;
+      size_t remaining = segments[i].size;
+
+      if( partial_len )
+      {
+        size_t n = std::min<size_t>( remaining, 16 - partial_len );
+        memcpy( partial_block + partial_len, data, n );
+        partial_len += n;
+        data += n;
+        remaining -= n;
+        if( partial_len < 16 )
+          continue;
+
+        if( out_len == write_buffer_length )
+          send_output();
+        _send_aes.encode( partial_block, 16, out + out_len );
+        out_len += 16;
+        partial_len = 0;
+      }
+
+      while( remaining >= 16 )
+      {
+        if( out_len == write_buffer_length )
+          send_output();
+        size_t n = std::min<size_t>( remaining, write_buffer_length - out_len ) & ~size_t(15);
+        _send_aes.encode( data, n, out + out_len );
+        out_len += n;
+        data += n;
+        remaining -= n;
+      }
+
+      memcpy( partial_block, data, remaining );
+      partial_len = remaining;
+    }
+
+    assert( partial_len == 0 );
+    send_output();
+} FC_RETHROW_EXCEPTIONS( warn, "", ("count",count) ) }
+
 void stcp_socket::flush()
 {
   _sock.flush();
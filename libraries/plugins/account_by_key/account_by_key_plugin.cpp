@@ -54,14 +54,14 @@ struct pre_operation_visitor
    void operator()( const account_update_operation& op )const
    {
       _plugin.clear_cache();
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( op.account );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( op.account );
       if( acct_itr ) _plugin.cache_auths( *acct_itr );
    }
 
    void operator()( const recover_account_operation& op )const
    {
       _plugin.clear_cache();
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( op.account_to_recover );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( op.account_to_recover );
       if( acct_itr ) _plugin.cache_auths( *acct_itr );
    }
 
@@ -100,31 +100,31 @@ struct post_operation_visitor
 
    void operator()( const account_create_operation& op )const
    {
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( op.new_account_name );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( op.new_account_name );
       if( acct_itr ) _plugin.update_key_lookup( *acct_itr );
    }
 
    void operator()( const account_create_with_delegation_operation& op )const
    {
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( op.new_account_name );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( op.new_account_name );
       if( acct_itr ) _plugin.update_key_lookup( *acct_itr );
    }
 
    void operator()( const account_update_operation& op )const
    {
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( op.account );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( op.account );
       if( acct_itr ) _plugin.update_key_lookup( *acct_itr );
    }
 
    void operator()( const recover_account_operation& op )const
    {
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( op.account_to_recover );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( op.account_to_recover );
       if( acct_itr ) _plugin.update_key_lookup( *acct_itr );
    }
 
    void operator()( const pow_operation& op )const
    {
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( op.worker_account );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( op.worker_account );
       if( acct_itr ) _plugin.update_key_lookup( *acct_itr );
    }
 
@@ -133,7 +133,7 @@ struct post_operation_visitor
       const account_name_type* worker_account = op.work.visit( pow2_work_get_account_visitor() );
       if( worker_account == nullptr )
          return;
-      auto acct_itr = _plugin._db.find< account_authority_object, by_account >( *worker_account );
+      auto acct_itr = _plugin._db.find< account_authority_object, by_account_lookup >( *worker_account );
       if( acct_itr ) _plugin.update_key_lookup( *acct_itr );
    }
 
@@ -21,6 +21,7 @@ namespace steem { namespace plugins { namespace account_history {
 
 using namespace steem::protocol;
 
+using chain::block_notification;
 using chain::database;
 using chain::operation_notification;
 using chain::operation_object;
@@ -35,6 +36,7 @@ class account_history_plugin_impl
 
       virtual ~account_history_plugin_impl() {}
 
+      void on_pre_apply_block( const block_notification& note );
       void on_pre_apply_operation( const operation_notification& note );
 
       flat_map< account_name_type, account_name_type > _tracked_accounts;
@@ -42,14 +44,18 @@ class account_history_plugin_impl
       bool                                             _blacklist = false;
       flat_set< string >                               _op_list;
       bool                                             _prune = true;
+      /// (offset, size) of every packed transaction in the block being applied
+      vector< std::pair< uint32_t, uint32_t > >       _trx_locations;
       database&                        _db;
+      boost::signals2::connection      _pre_apply_block_conn;
       boost::signals2::connection      _pre_apply_operation_conn;
 };
 
 struct operation_visitor
 {
-   operation_visitor( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, bool prune )
-      :_db(db), _note(note), new_obj(n), item(i), _prune(prune) {}
+   operation_visitor( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, bool prune,
+      const vector< std::pair< uint32_t, uint32_t > >& trx_locations )
+      :_db(db), _note(note), new_obj(n), item(i), _prune(prune), _trx_locations(trx_locations) {}
 
    typedef void result_type;
 
@@ -58,6 +64,7 @@ struct operation_visitor
    const operation_object*& new_obj;
    account_name_type item;
    bool _prune;
+   const vector< std::pair< uint32_t, uint32_t > >& _trx_locations;
 
    template<typename Op>
    void operator()( Op&& )const
@@ -78,6 +85,12 @@ struct operation_visitor
             obj.serialized_op.resize( size );
             fc::datastream< char* > ds( obj.serialized_op.data(), size );
             fc::raw::pack( ds, _note.op );
+
+            if( _db.is_processing_block() && _note.trx_in_block < _trx_locations.size() )
+            {
+               obj.trx_offset = _trx_locations[ _note.trx_in_block ].first;
+               obj.trx_size   = _trx_locations[ _note.trx_in_block ].second;
+            }
          });
       }
 
@@ -88,9 +101,16 @@ struct operation_visitor
 
       _db.create< chain::account_history_object >( [&]( chain::account_history_object& ahist )
       {
-         ahist.account  = item;
-         ahist.sequence = sequence;
-         ahist.op       = new_obj->id;
+         ahist.account       = item;
+         ahist.sequence      = sequence;
+         ahist.op            = new_obj->id;
+         ahist.trx_id        = new_obj->trx_id;
+         ahist.block         = new_obj->block;
+         ahist.trx_in_block  = new_obj->trx_in_block;
+         ahist.op_in_trx     = new_obj->op_in_trx;
+         ahist.virtual_op    = new_obj->virtual_op;
+         ahist.timestamp     = new_obj->timestamp;
+         ahist.serialized_op = new_obj->serialized_op;
       });
 
       if( _prune )
@@ -108,7 +128,7 @@ struct operation_visitor
 
          while( seq_itr->account == item
                && sequence - seq_itr->sequence > 30
-               && now - _db.get< chain::operation_object >( seq_itr->op ).timestamp > fc::days(30) )
+               && now - seq_itr->timestamp > fc::days(30) )
          {
             to_remove.push_back( &(*seq_itr) );
             --seq_itr;
@@ -124,8 +144,9 @@ struct operation_visitor
 
 struct operation_visitor_filter : operation_visitor
 {
-   operation_visitor_filter( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, const flat_set< string >& filter, bool p, bool blacklist ):
-      operation_visitor( db, note, n, i, p ), _filter( filter ), _blacklist( blacklist ) {}
+   operation_visitor_filter( database& db, const operation_notification& note, const operation_object*& n, account_name_type i, const flat_set< string >& filter, bool p, bool blacklist,
+      const vector< std::pair< uint32_t, uint32_t > >& trx_locations ):
+      operation_visitor( db, note, n, i, p, trx_locations ), _filter( filter ), _blacklist( blacklist ) {}
 
    const flat_set< string >& _filter;
    bool _blacklist;
@@ -146,6 +167,24 @@ struct operation_visitor_filter : operation_visitor
    }
 };
 
+void account_history_plugin_impl::on_pre_apply_block( const block_notification& note )
+{
+   // signed_block packs as its header followed by the transaction vector
+   const auto& trxs = note.block.transactions;
+   uint32_t offset = fc::raw::pack_size( static_cast< const signed_block_header& >( note.block ) )
+      + fc::raw::pack_size( fc::unsigned_int( trxs.size() ) );
+
+   _trx_locations.clear();
+   _trx_locations.reserve( trxs.size() );
+
+   for( const auto& trx : trxs )
+   {
+      uint32_t size = fc::raw::pack_size( trx );
+      _trx_locations.emplace_back( offset, size );
+      offset += size;
+   }
+}
+
 void account_history_plugin_impl::on_pre_apply_operation( const operation_notification& note )
 {
    flat_set<account_name_type> impacted;
@@ -185,11 +224,11 @@ void account_history_plugin_impl::on_pre_apply_operation( const operation_notifi
       {
          if(_filter_content)
          {
-            note.op.visit( operation_visitor_filter( _db, note, new_obj, item, _op_list, _prune, _blacklist ) );
+            note.op.visit( operation_visitor_filter( _db, note, new_obj, item, _op_list, _prune, _blacklist, _trx_locations ) );
          }
          else
          {
-            note.op.visit( operation_visitor( _db, note, new_obj, item, _prune ) );
+            note.op.visit( operation_visitor( _db, note, new_obj, item, _prune, _trx_locations ) );
          }
       }
    }
@@ -220,6 +259,9 @@ void account_history_plugin::plugin_initialize( const boost::program_options::va
 {
    my = std::make_unique< detail::account_history_plugin_impl >();
 
+   my->_pre_apply_block_conn = my->_db.add_pre_apply_block_handler(
+      [&]( const block_notification& note ){ my->on_pre_apply_block( note ); }, *this, 0 );
+
    my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler(
       [&]( const operation_notification& note ){ my->on_pre_apply_operation(note); }, *this, 0 );
 
@@ -322,6 +364,7 @@ void account_history_plugin::plugin_startup() {}
 
 void account_history_plugin::plugin_shutdown()
 {
+   chain::util::disconnect_signal( my->_pre_apply_block_conn );
    chain::util::disconnect_signal( my->_pre_apply_operation_conn );
 }
 
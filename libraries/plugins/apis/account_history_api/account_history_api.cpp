@@ -68,10 +68,9 @@ DEFINE_API_IMPL( account_history_api_chainbase_impl, get_transaction )
       auto itr = idx.lower_bound( args.id );
       if( itr != idx.end() && itr->trx_id == args.id )
       {
-         auto blk = _db.fetch_block_by_number( itr->block );
-         FC_ASSERT( blk.valid() );
-         FC_ASSERT( blk->transactions.size() > itr->trx_in_block );
-         result = blk->transactions[itr->trx_in_block];
+         auto trx = _db.fetch_transaction_by_location( itr->block, itr->trx_in_block, itr->trx_offset, itr->trx_size );
+         FC_ASSERT( trx.valid() );
+         result = *trx;
          result.block_num       = itr->block;
          result.transaction_num = itr->trx_in_block;
       }
@@ -105,7 +104,8 @@ DEFINE_API_IMPL( account_history_api_chainbase_impl, get_account_history )
             break;
          if( n >= args.limit )
             break;
-         result.history[ itr->sequence ] = _db.get( itr->op );
+         // by_account walks sequences in descending order, so every entry goes to the front of the map
+         result.history.emplace_hint( result.history.begin(), itr->sequence, api_operation_object( *itr ) );
          ++itr;
          ++n;
       }
@@ -5,6 +5,10 @@
 
 #include <steem/protocol/get_config.hpp>
 
+#include <boost/thread/mutex.hpp>
+
+#include <limits>
+
 namespace steem { namespace plugins { namespace block_api {
 
 class block_api_impl
@@ -16,9 +20,16 @@ class block_api_impl
       DECLARE_API_IMPL(
          (get_block_header)
          (get_block)
+         (get_raw_blocks)
       )
 
+      std::shared_ptr< const api_signed_block_object > get_recent_block( uint32_t block_num );
+
       chain::database& _db;
+
+      /// Recent blocks are polled by many clients, build their api object (and recover the signee) once
+      boost::mutex                                                                  _recent_blocks_mtx;
+      std::map< uint32_t, std::shared_ptr< const api_signed_block_object > >        _recent_blocks;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -60,6 +71,17 @@ DEFINE_API_IMPL( block_api_impl, get_block_header )
 DEFINE_API_IMPL( block_api_impl, get_block )
 {
    get_block_return result;
+
+   if( args.block_num + BLOCK_API_RECENT_BLOCK_CACHE_SIZE > _db.head_block_num() )
+   {
+      auto block = get_recent_block( args.block_num );
+
+      if( block )
+         result.block = *block;
+
+      return result;
+   }
+
    auto block = _db.fetch_block_by_number( args.block_num );
 
    if( block )
@@ -68,9 +90,66 @@ DEFINE_API_IMPL( block_api_impl, get_block )
    return result;
 }
 
+DEFINE_API_IMPL( block_api_impl, get_raw_blocks )
+{
+   FC_ASSERT( args.count <= BLOCK_API_SINGLE_QUERY_LIMIT, "count of ${c} is greater than maximum allowed", ("c", args.count) );
+
+   get_raw_blocks_return result;
+   result.blocks.reserve( args.count );
+
+   // block_num + count may not fit in a uint32_t, stop at the largest block number instead of wrapping
+   uint32_t end_block_num = args.count > std::numeric_limits< uint32_t >::max() - args.block_num ?
+      std::numeric_limits< uint32_t >::max() : args.block_num + args.count;
+
+   for( uint32_t block_num = args.block_num; block_num < end_block_num; ++block_num )
+   {
+      api_raw_block_object raw;
+      raw.data = _db.fetch_block_data_by_number( block_num );
+
+      if( raw.data.empty() )
+         break;
+
+      raw.block_num = block_num;
+      result.blocks.push_back( std::move( raw ) );
+   }
+
+   return result;
+}
+
+std::shared_ptr< const api_signed_block_object > block_api_impl::get_recent_block( uint32_t block_num )
+{
+   std::shared_ptr< const api_signed_block_object > result;
+
+   // Reversible blocks can be replaced by a fork, the cached entry is only valid while its id is on our chain
+   auto block_id = _db.find_block_id_for_num( block_num );
+   if( block_id == block_id_type() )
+      return result;
+
+   {
+      boost::lock_guard< boost::mutex > guard( _recent_blocks_mtx );
+      auto itr = _recent_blocks.find( block_num );
+      if( itr != _recent_blocks.end() && itr->second->block_id == block_id )
+         return itr->second;
+   }
+
+   auto block = _db.fetch_block_by_id( block_id );
+   if( !block )
+      return result;
+
+   result = std::make_shared< const api_signed_block_object >( *block );
+
+   boost::lock_guard< boost::mutex > guard( _recent_blocks_mtx );
+   _recent_blocks[ block_num ] = result;
+   while( _recent_blocks.size() > BLOCK_API_RECENT_BLOCK_CACHE_SIZE )
+      _recent_blocks.erase( _recent_blocks.begin() );
+
+   return result;
+}
+
 DEFINE_READ_APIS( block_api,
    (get_block_header)
    (get_block)
+   (get_raw_blocks)
 )
 
 } } } // steem::plugins::block_api
@@ -5,6 +5,7 @@
 #include <steem/plugins/block_api/block_api_args.hpp>
 
 #define BLOCK_API_SINGLE_QUERY_LIMIT 1000
+#define BLOCK_API_RECENT_BLOCK_CACHE_SIZE 64
 
 namespace steem { namespace plugins { namespace block_api {
 
@@ -35,6 +36,14 @@ class block_api
          * @return the referenced block, or null if no matching block was found
          */
          (get_block)
+
+         /**
+         * @brief Retrieve a range of blocks as packed binary, as they are stored in the block log
+         * @param block_num Height of the first block to be returned
+         * @param count Number of blocks to return, at most BLOCK_API_SINGLE_QUERY_LIMIT
+         * @return the packed blocks, stopping early at the first block that was not found
+         */
+         (get_raw_blocks)
       )
 
    private:
@@ -32,6 +32,24 @@ struct get_block_return
    optional< api_signed_block_object > block;
 };
 
+/* get_raw_blocks */
+struct get_raw_blocks_args
+{
+   uint32_t block_num;
+   uint32_t count = 1;
+};
+
+struct api_raw_block_object
+{
+   uint32_t             block_num = 0;
+   std::vector< char >  data;
+};
+
+struct get_raw_blocks_return
+{
+   vector< api_raw_block_object > blocks;
+};
+
 } } } // steem::block_api
 
 FC_REFLECT( steem::plugins::block_api::get_block_header_args,
@@ -46,3 +64,12 @@ FC_REFLECT( steem::plugins::block_api::get_block_args,
 FC_REFLECT( steem::plugins::block_api::get_block_return,
    (block) )
 
+
+FC_REFLECT( steem::plugins::block_api::get_raw_blocks_args,
+   (block_num)(count) )
+
+FC_REFLECT( steem::plugins::block_api::api_raw_block_object,
+   (block_num)(data) )
+
+FC_REFLECT( steem::plugins::block_api::get_raw_blocks_return,
+   (blocks) )
@@ -2183,6 +2183,11 @@ DEFINE_LOCKLESS_APIS( condenser_api,
    (broadcast_transaction_synchronous)
    (broadcast_block)
    (get_market_history_buckets)
+   (get_chain_properties)
+   (get_current_median_history_price)
+   (get_feed_history)
+   (get_witness_schedule)
+   (get_hardfork_version)
 )
 
 DEFINE_READ_APIS( condenser_api,
@@ -2193,11 +2198,6 @@ DEFINE_READ_APIS( condenser_api,
    (get_block)
    (get_ops_in_block)
    (get_dynamic_global_properties)
-   (get_chain_properties)
-   (get_current_median_history_price)
-   (get_feed_history)
-   (get_witness_schedule)
-   (get_hardfork_version)
    (get_next_scheduled_hardfork)
    (get_reward_fund)
    (get_key_references)
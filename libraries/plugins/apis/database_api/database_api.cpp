@@ -7,6 +7,10 @@
 #include <steem/protocol/exceptions.hpp>
 #include <steem/protocol/transaction_util.hpp>
 
+#include <steem/chain/util/signal.hpp>
+
+#include <atomic>
+
 namespace steem { namespace plugins { namespace database_api {
 
 class database_api_impl
@@ -28,7 +32,6 @@ class database_api_impl
          (find_witnesses)
          (list_witness_votes)
          (get_active_witnesses)
-         (list_accounts)
          (find_accounts)
          (list_owner_histories)
          (find_owner_histories)
@@ -50,9 +53,7 @@ class database_api_impl
          (find_sbd_conversion_requests)
          (list_decline_voting_rights_requests)
          (find_decline_voting_rights_requests)
-         (list_comments)
          (find_comments)
-         (list_votes)
          (find_votes)
          (list_limit_orders)
          (find_limit_orders)
@@ -68,6 +69,30 @@ class database_api_impl
 #endif
       )
 
+      DECLARE_CHUNKED_API_IMPL
+      (
+         (list_accounts)
+         (list_comments)
+         (list_votes)
+      )
+
+      /**
+       * Immutable copy of the singleton objects nearly every client polls. It is rebuilt while the
+       * write lock is held whenever the head moves (a block is applied or popped, including the pops
+       * of a fork switch or a debug_node update) and swapped in atomically so readers never lock.
+       */
+      struct head_state
+      {
+         get_dynamic_global_properties_return   dynamic_global_properties;
+         get_witness_schedule_return            witness_schedule;
+         get_hardfork_properties_return         hardfork_properties;
+         get_reward_funds_return                reward_funds;
+         get_feed_history_return                feed_history;
+      };
+
+      void update_head_state();
+      std::shared_ptr< const head_state > get_head_state()const;
+
       template< typename ResultType >
       static ResultType on_push_default( const ResultType& r ) { return r; }
 
@@ -85,7 +110,75 @@ class database_api_impl
          }
       }
 
+      /**
+       * When lock is set the caller does not hold the read lock. The index is then walked in chunks of
+       * DATABASE_API_READ_CHUNK_SIZE objects, each under its own read lock, and every chunk resumes from
+       * the key of the first object not yet visited. Block application can proceed between chunks, so
+       * the result is not a single snapshot, but no object is returned twice or skipped unless it was
+       * removed in the meantime. Without lock this is iterate_results.
+       */
+      template< typename IndexType, typename OrderType, typename KeyType, typename ResultType, typename OnPush, typename GetKey >
+      void iterate_results_chunked( bool lock, KeyType start, vector< ResultType >& result, uint32_t limit, OnPush&& on_push, GetKey&& get_key )
+      {
+         if( !lock )
+         {
+            iterate_results< IndexType, OrderType >( start, result, limit, on_push );
+            return;
+         }
+
+         optional< KeyType > next( start );
+
+         while( next.valid() && result.size() < limit )
+         {
+            _db.with_read_lock( [&]()
+            {
+               const auto& idx = _db.get_index< IndexType, OrderType >();
+               auto itr = idx.lower_bound( *next );
+               auto end = idx.end();
+               size_t chunk_limit = std::min< size_t >( limit, result.size() + DATABASE_API_READ_CHUNK_SIZE );
+
+               while( result.size() < chunk_limit && itr != end )
+               {
+                  result.push_back( on_push( *itr ) );
+                  ++itr;
+               }
+
+               if( itr == end )
+                  next.reset();
+               else
+                  next = get_key( *itr );
+            });
+         }
+      }
+
+      template< typename Lambda >
+      auto with_read_lock_if( bool lock, Lambda&& callback ) -> decltype( callback() )
+      {
+         if( lock )
+            return _db.with_read_lock( [&](){ return callback(); } );
+
+         return callback();
+      }
+
+      comment_id_type find_comment_id( bool lock, const account_name_type& author, const string& permlink )
+      {
+         return with_read_lock_if( lock, [&]()
+         {
+            auto comment = _db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( author, permlink ) );
+            FC_ASSERT( comment != nullptr, "Could not find comment ${a}/${p}.", ("a", author)("p", permlink) );
+            return comment->id;
+         });
+      }
+
       chain::database& _db;
+
+      std::shared_ptr< const head_state >    _head_state;
+      /// Blocks applied during a reindex don't refresh the head state, post_reindex does once at the end
+      bool                                   _reindexing = false;
+      boost::signals2::connection            _post_apply_block_conn;
+      boost::signals2::connection            _post_pop_block_conn;
+      boost::signals2::connection            _pre_reindex_conn;
+      boost::signals2::connection            _post_reindex_conn;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -98,15 +191,71 @@ database_api::database_api()
    : my( new database_api_impl() )
 {
    JSON_RPC_REGISTER_API( STEEM_DATABASE_API_PLUGIN_NAME );
+
+   auto& plugin = appbase::app().get_plugin< database_api_plugin >();
+   auto refresh = [&]( const chain::block_notification& )
+   {
+      if( !my->_reindexing )
+         my->update_head_state();
+   };
+
+   my->_post_apply_block_conn = my->_db.add_post_apply_block_handler( refresh, plugin );
+   my->_post_pop_block_conn = my->_db.add_post_pop_block_handler( refresh, plugin );
+   my->_pre_reindex_conn = my->_db.add_pre_reindex_handler(
+      [&]( const chain::reindex_notification& ){ my->_reindexing = true; }, plugin );
+   my->_post_reindex_conn = my->_db.add_post_reindex_handler( [&]( const chain::reindex_notification& )
+   {
+      my->_reindexing = false;
+      my->update_head_state();
+   }, plugin );
 }
 
 database_api::~database_api() {}
 
+void database_api::api_startup()
+{
+   my->_db.with_read_lock( [&]()
+   {
+      my->update_head_state();
+   });
+}
+
+void database_api::api_shutdown()
+{
+   chain::util::disconnect_signal( my->_post_apply_block_conn );
+   chain::util::disconnect_signal( my->_post_pop_block_conn );
+   chain::util::disconnect_signal( my->_pre_reindex_conn );
+   chain::util::disconnect_signal( my->_post_reindex_conn );
+}
+
 database_api_impl::database_api_impl()
    : _db( appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db() ) {}
 
 database_api_impl::~database_api_impl() {}
 
+void database_api_impl::update_head_state()
+{
+   auto state = std::make_shared< head_state >();
+
+   state->dynamic_global_properties = _db.get_dynamic_global_properties();
+   state->witness_schedule = api_witness_schedule_object( _db.get_witness_schedule_object() );
+   state->hardfork_properties = _db.get_hardfork_property_object();
+   state->feed_history = _db.get_feed_history();
+
+   const auto& rf_idx = _db.get_index< reward_fund_index, by_id >();
+   for( auto itr = rf_idx.begin(); itr != rf_idx.end(); ++itr )
+      state->reward_funds.funds.push_back( *itr );
+
+   std::atomic_store( &_head_state, std::shared_ptr< const head_state >( std::move( state ) ) );
+}
+
+std::shared_ptr< const database_api_impl::head_state > database_api_impl::get_head_state()const
+{
+   auto state = std::atomic_load( &_head_state );
+   FC_ASSERT( state, "database_api has not started yet" );
+   return state;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Globals                                                          //
@@ -121,43 +270,32 @@ DEFINE_API_IMPL( database_api_impl, get_config )
 
 DEFINE_API_IMPL( database_api_impl, get_dynamic_global_properties )
 {
-   return _db.get_dynamic_global_properties();
+   return get_head_state()->dynamic_global_properties;
 }
 
 DEFINE_API_IMPL( database_api_impl, get_witness_schedule )
 {
-   return api_witness_schedule_object( _db.get_witness_schedule_object() );
+   return get_head_state()->witness_schedule;
 }
 
 DEFINE_API_IMPL( database_api_impl, get_hardfork_properties )
 {
-   return _db.get_hardfork_property_object();
+   return get_head_state()->hardfork_properties;
 }
 
 DEFINE_API_IMPL( database_api_impl, get_reward_funds )
 {
-   get_reward_funds_return result;
-
-   const auto& rf_idx = _db.get_index< reward_fund_index, by_id >();
-   auto itr = rf_idx.begin();
-
-   while( itr != rf_idx.end() )
-   {
-      result.funds.push_back( *itr );
-      ++itr;
-   }
-
-   return result;
+   return get_head_state()->reward_funds;
 }
 
 DEFINE_API_IMPL( database_api_impl, get_current_price_feed )
 {
-   return _db.get_feed_history().current_median_history;;
+   return get_head_state()->feed_history.current_median_history;
 }
 
 DEFINE_API_IMPL( database_api_impl, get_feed_history )
 {
-   return _db.get_feed_history();
+   return get_head_state()->feed_history;
 }
 
 
@@ -286,7 +424,7 @@ DEFINE_API_IMPL( database_api_impl, get_active_witnesses )
 
 /* Accounts */
 
-DEFINE_API_IMPL( database_api_impl, list_accounts )
+DEFINE_CHUNKED_API_IMPL( database_api_impl, list_accounts )
 {
    FC_ASSERT( args.limit <= DATABASE_API_SINGLE_QUERY_LIMIT );
 
@@ -297,31 +435,37 @@ DEFINE_API_IMPL( database_api_impl, list_accounts )
    {
       case( by_name ):
       {
-         iterate_results< chain::account_index, chain::by_name >(
+         iterate_results_chunked< chain::account_index, chain::by_name >(
+            lock,
             args.start.as< protocol::account_name_type >(),
             result.accounts,
             args.limit,
-            [&]( const account_object& a ){ return api_account_object( a, _db ); } );
+            [&]( const account_object& a ){ return api_account_object( a, _db ); },
+            []( const account_object& a ){ return a.name; } );
          break;
       }
       case( by_proxy ):
       {
          auto key = args.start.as< std::pair< account_name_type, account_name_type > >();
-         iterate_results< chain::account_index, chain::by_proxy >(
+         iterate_results_chunked< chain::account_index, chain::by_proxy >(
+            lock,
             boost::make_tuple( key.first, key.second ),
             result.accounts,
             args.limit,
-            [&]( const account_object& a ){ return api_account_object( a, _db ); } );
+            [&]( const account_object& a ){ return api_account_object( a, _db ); },
+            []( const account_object& a ){ return boost::make_tuple( a.proxy, a.name ); } );
          break;
       }
       case( by_next_vesting_withdrawal ):
       {
          auto key = args.start.as< std::pair< fc::time_point_sec, account_name_type > >();
-         iterate_results< chain::account_index, chain::by_next_vesting_withdrawal >(
+         iterate_results_chunked< chain::account_index, chain::by_next_vesting_withdrawal >(
+            lock,
             boost::make_tuple( key.first, key.second ),
             result.accounts,
             args.limit,
-            [&]( const account_object& a ){ return api_account_object( a, _db ); } );
+            [&]( const account_object& a ){ return api_account_object( a, _db ); },
+            []( const account_object& a ){ return boost::make_tuple( a.next_vesting_withdrawal, a.name ); } );
          break;
       }
       default:
@@ -906,7 +1050,7 @@ DEFINE_API_IMPL( database_api_impl, find_decline_voting_rights_requests )
 
 /* Comments */
 
-DEFINE_API_IMPL( database_api_impl, list_comments )
+DEFINE_CHUNKED_API_IMPL( database_api_impl, list_comments )
 {
    FC_ASSERT( args.limit <= DATABASE_API_SINGLE_QUERY_LIMIT );
 
@@ -925,27 +1069,27 @@ DEFINE_API_IMPL( database_api_impl, list_comments )
          comment_id_type comment_id;
 
          if( author != account_name_type() || permlink.size() )
-         {
-            auto comment = _db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( author, permlink ) );
-            FC_ASSERT( comment != nullptr, "Could not find comment ${a}/${p}.", ("a", author)("p", permlink) );
-            comment_id = comment->id;
-         }
+            comment_id = find_comment_id( lock, author, permlink );
 
-         iterate_results< chain::comment_index, chain::by_cashout_time >(
+         iterate_results_chunked< chain::comment_index, chain::by_cashout_time >(
+            lock,
             boost::make_tuple( key[0].as< fc::time_point_sec >(), comment_id ),
             result.comments,
             args.limit,
-            [&]( const comment_object& c ){ return api_comment_object( c, _db ); } );
+            [&]( const comment_object& c ){ return api_comment_object( c, _db ); },
+            []( const comment_object& c ){ return boost::make_tuple( c.cashout_time, c.id ); } );
          break;
       }
       case( by_permlink ):
       {
          auto key = args.start.as< std::pair< account_name_type, string > >();
-         iterate_results< chain::comment_index, chain::by_permlink >(
+         iterate_results_chunked< chain::comment_index, chain::by_permlink >(
+            lock,
             boost::make_tuple( key.first, key.second ),
             result.comments,
             args.limit,
-            [&]( const comment_object& c ){ return api_comment_object( c, _db ); } );
+            [&]( const comment_object& c ){ return api_comment_object( c, _db ); },
+            []( const comment_object& c ){ return boost::make_tuple( c.author, chain::to_string( c.permlink ) ); } );
          break;
       }
       case( by_root ):
@@ -958,28 +1102,22 @@ DEFINE_API_IMPL( database_api_impl, list_comments )
          comment_id_type root_id;
 
          if( root_author != account_name_type() || root_permlink.size() )
-         {
-            auto root = _db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( root_author, root_permlink ) );
-            FC_ASSERT( root != nullptr, "Could not find comment ${a}/${p}.", ("a", root_author)("p", root_permlink) );
-            root_id = root->id;
-         }
+            root_id = find_comment_id( lock, root_author, root_permlink );
 
          auto child_author = key[2].as< account_name_type >();
          auto child_permlink = key[3].as< string >();
          comment_id_type child_id;
 
          if( child_author != account_name_type() || child_permlink.size() )
-         {
-            auto child = _db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( child_author, child_permlink ) );
-            FC_ASSERT( child != nullptr, "Could not find comment ${a}/${p}.", ("a", child_author)("p", child_permlink) );
-            child_id = child->id;
-         }
+            child_id = find_comment_id( lock, child_author, child_permlink );
 
-         iterate_results< chain::comment_index, chain::by_root >(
+         iterate_results_chunked< chain::comment_index, chain::by_root >(
+            lock,
             boost::make_tuple( root_id, child_id ),
             result.comments,
             args.limit,
-            [&]( const comment_object& c ){ return api_comment_object( c, _db ); } );
+            [&]( const comment_object& c ){ return api_comment_object( c, _db ); },
+            []( const comment_object& c ){ return boost::make_tuple( c.root_comment, c.id ); } );
          break;
       }
       case( by_parent ):
@@ -992,17 +1130,15 @@ DEFINE_API_IMPL( database_api_impl, list_comments )
          comment_id_type child_id;
 
          if( child_author != account_name_type() || child_permlink.size() )
-         {
-            auto child = _db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( child_author, child_permlink ) );
-            FC_ASSERT( child != nullptr, "Could not find comment ${a}/${p}.", ("a", child_author)("p", child_permlink) );
-            child_id = child->id;
-         }
+            child_id = find_comment_id( lock, child_author, child_permlink );
 
-         iterate_results< chain::comment_index, chain::by_parent >(
+         iterate_results_chunked< chain::comment_index, chain::by_parent >(
+            lock,
             boost::make_tuple( key[0].as< account_name_type >(), key[1].as< string >(), child_id ),
             result.comments,
             args.limit,
-            [&]( const comment_object& c ){ return api_comment_object( c, _db ); } );
+            [&]( const comment_object& c ){ return api_comment_object( c, _db ); },
+            []( const comment_object& c ){ return boost::make_tuple( c.parent_author, chain::to_string( c.parent_permlink ), c.id ); } );
          break;
       }
 #ifndef IS_LOW_MEM
@@ -1016,17 +1152,15 @@ DEFINE_API_IMPL( database_api_impl, list_comments )
          comment_id_type child_id;
 
          if( child_author != account_name_type() || child_permlink.size() )
-         {
-            auto child = _db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( child_author, child_permlink ) );
-            FC_ASSERT( child != nullptr, "Could not find comment ${a}/${p}.", ("a", child_author)("p", child_permlink) );
-            child_id = child->id;
-         }
+            child_id = find_comment_id( lock, child_author, child_permlink );
 
-         iterate_results< chain::comment_index, chain::by_last_update >(
+         iterate_results_chunked< chain::comment_index, chain::by_last_update >(
+            lock,
             boost::make_tuple( key[0].as< account_name_type >(), key[1].as< fc::time_point_sec >(), child_id ),
             result.comments,
             args.limit,
-            [&]( const comment_object& c ){ return api_comment_object( c, _db ); } );
+            [&]( const comment_object& c ){ return api_comment_object( c, _db ); },
+            []( const comment_object& c ){ return boost::make_tuple( c.parent_author, c.last_update, c.id ); } );
          break;
       }
       case( by_author_last_update ):
@@ -1039,17 +1173,15 @@ DEFINE_API_IMPL( database_api_impl, list_comments )
          comment_id_type comment_id;
 
          if( author != account_name_type() || permlink.size() )
-         {
-            auto comment = _db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( author, permlink ) );
-            FC_ASSERT( comment != nullptr, "Could not find comment ${a}/${p}.", ("a", author)("p", permlink) );
-            comment_id = comment->id;
-         }
+            comment_id = find_comment_id( lock, author, permlink );
 
-         iterate_results< chain::comment_index, chain::by_last_update >(
+         iterate_results_chunked< chain::comment_index, chain::by_last_update >(
+            lock,
             boost::make_tuple( key[0].as< account_name_type >(), key[1].as< fc::time_point_sec >(), comment_id ),
             result.comments,
             args.limit,
-            [&]( const comment_object& c ){ return api_comment_object( c, _db ); } );
+            [&]( const comment_object& c ){ return api_comment_object( c, _db ); },
+            []( const comment_object& c ){ return boost::make_tuple( c.parent_author, c.last_update, c.id ); } );
          break;
       }
 #endif
@@ -1084,7 +1216,7 @@ namespace last_votes_misc
 
    //====================================================votes_impl====================================================
    template< sort_order_type SORTORDERTYPE >
-   void votes_impl( database_api_impl& _impl, vector< api_comment_vote_object >& c, size_t nr_args, uint32_t limit, vector< fc::variant >& key, fc::time_point_sec& timestamp, uint64_t weight )
+   void votes_impl( database_api_impl& _impl, bool lock, vector< api_comment_vote_object >& c, size_t nr_args, uint32_t limit, vector< fc::variant >& key, fc::time_point_sec& timestamp, uint64_t weight )
    {
       if( SORTORDERTYPE == by_comment_voter )
          FC_ASSERT( key.size() == nr_args, "by_comment_voter start requires ${nr_args} values. (account_name_type, string, account_name_type)", ("nr_args", nr_args ) );
@@ -1113,33 +1245,36 @@ namespace last_votes_misc
 
       if( voter != account_name_type() )
       {
-         auto account = _impl._db.find< chain::account_object, chain::by_name >( voter );
-         FC_ASSERT( account != nullptr, "Could not find voter ${v}.", ("v", voter ) );
-         voter_id = account->id;
+         voter_id = _impl.with_read_lock_if( lock, [&]()
+         {
+            auto account = _impl._db.find< chain::account_object, chain::by_name >( voter );
+            FC_ASSERT( account != nullptr, "Could not find voter ${v}.", ("v", voter ) );
+            return account->id;
+         });
       }
 
       if( author != account_name_type() || permlink.size() )
-      {
-         auto comment = _impl._db.find< chain::comment_object, chain::by_permlink >( boost::make_tuple( author, permlink ) );
-         FC_ASSERT( comment != nullptr, "Could not find comment ${a}/${p}.", ("a", author)("p", permlink) );
-         comment_id = comment->id;
-      }
+         comment_id = _impl.find_comment_id( lock, author, permlink );
 
       if( SORTORDERTYPE == by_comment_voter )
       {
-         _impl.iterate_results< chain::comment_vote_index, chain::by_comment_voter >(
+         _impl.iterate_results_chunked< chain::comment_vote_index, chain::by_comment_voter >(
+         lock,
          boost::make_tuple( comment_id, voter_id ),
          c,
          limit,
-         [&]( const comment_vote_object& cv ){ return api_comment_vote_object( cv, _impl._db ); } );
+         [&]( const comment_vote_object& cv ){ return api_comment_vote_object( cv, _impl._db ); },
+         []( const comment_vote_object& cv ){ return boost::make_tuple( cv.comment, cv.voter ); } );
       }
       else if( SORTORDERTYPE == by_voter_comment )
       {
-         _impl.iterate_results< chain::comment_vote_index, chain::by_voter_comment >(
+         _impl.iterate_results_chunked< chain::comment_vote_index, chain::by_voter_comment >(
+         lock,
          boost::make_tuple( voter_id, comment_id ),
          c,
          limit,
-         [&]( const comment_vote_object& cv ){ return api_comment_vote_object( cv, _impl._db ); } );
+         [&]( const comment_vote_object& cv ){ return api_comment_vote_object( cv, _impl._db ); },
+         []( const comment_vote_object& cv ){ return boost::make_tuple( cv.voter, cv.comment ); } );
       }
    }
 
@@ -1149,7 +1284,7 @@ namespace last_votes_misc
 
 /* Votes */
 
-DEFINE_API_IMPL( database_api_impl, list_votes )
+DEFINE_CHUNKED_API_IMPL( database_api_impl, list_votes )
 {
    FC_ASSERT( args.limit <= DATABASE_API_SINGLE_QUERY_LIMIT );
 
@@ -1163,13 +1298,13 @@ DEFINE_API_IMPL( database_api_impl, list_votes )
       case( by_comment_voter ):
       {
          static fc::time_point_sec t( -1 );
-         last_votes_misc::votes_impl< by_comment_voter >( *this, result.votes, 3/*nr_args*/, args.limit, key, t, 0 );
+         last_votes_misc::votes_impl< by_comment_voter >( *this, lock, result.votes, 3/*nr_args*/, args.limit, key, t, 0 );
          break;
       }
       case( by_voter_comment ):
       {
          static fc::time_point_sec t( -1 );
-         last_votes_misc::votes_impl< by_voter_comment >( *this, result.votes, 3/*nr_args*/, args.limit, key, t, 0 );
+         last_votes_misc::votes_impl< by_voter_comment >( *this, lock, result.votes, 3/*nr_args*/, args.limit, key, t, 0 );
          break;
       }
       default:
@@ -1435,20 +1570,27 @@ DEFINE_API_IMPL( database_api_impl, get_smt_next_identifier )
 }
 #endif
 
-DEFINE_LOCKLESS_APIS( database_api, (get_config) )
-
-DEFINE_READ_APIS( database_api,
+DEFINE_LOCKLESS_APIS( database_api,
+   (get_config)
    (get_dynamic_global_properties)
    (get_witness_schedule)
    (get_hardfork_properties)
    (get_reward_funds)
    (get_current_price_feed)
    (get_feed_history)
+)
+
+DEFINE_CHUNKED_READ_APIS( database_api,
+   (list_accounts)
+   (list_comments)
+   (list_votes)
+)
+
+DEFINE_READ_APIS( database_api,
    (list_witnesses)
    (find_witnesses)
    (list_witness_votes)
    (get_active_witnesses)
-   (list_accounts)
    (find_accounts)
    (list_owner_histories)
    (find_owner_histories)
@@ -1470,9 +1612,7 @@ DEFINE_READ_APIS( database_api,
    (find_sbd_conversion_requests)
    (list_decline_voting_rights_requests)
    (find_decline_voting_rights_requests)
-   (list_comments)
    (find_comments)
-   (list_votes)
    (find_votes)
    (list_limit_orders)
    (find_limit_orders)
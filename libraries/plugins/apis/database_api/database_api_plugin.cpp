@@ -15,8 +15,14 @@ void database_api_plugin::plugin_initialize( const variables_map& options )
    api = std::make_shared< database_api >();
 }
 
-void database_api_plugin::plugin_startup() {}
+void database_api_plugin::plugin_startup()
+{
+   api->api_startup();
+}
 
-void database_api_plugin::plugin_shutdown() {}
+void database_api_plugin::plugin_shutdown()
+{
+   api->api_shutdown();
+}
 
 } } } // steem::plugins::database_api
@@ -6,6 +6,7 @@
 #include <steem/plugins/database_api/database_api_objects.hpp>
 
 #define DATABASE_API_SINGLE_QUERY_LIMIT 1000
+#define DATABASE_API_READ_CHUNK_SIZE 100
 
 namespace steem { namespace plugins { namespace database_api {
 
@@ -30,6 +31,9 @@ class database_api
 
          /**
          * @brief Retrieve the current @ref dynamic_global_property_object
+         *
+         * This and the other singleton getters below are served from a snapshot taken at the end
+         * of each applied block and do not take the database lock.
          */
          (get_dynamic_global_properties)
          (get_witness_schedule)
@@ -141,6 +145,10 @@ class database_api
       )
 
    private:
+      friend class database_api_plugin;
+      void api_startup();
+      void api_shutdown();
+
       std::unique_ptr< database_api_impl > my;
 };
 
@@ -212,7 +212,7 @@ struct api_account_object
       for( size_t i=0; i<n; i++ )
          proxied_vsf_votes.push_back( a.proxied_vsf_votes[i] );
 
-      const auto& auth = db.get< account_authority_object, by_account >( name );
+      const auto& auth = db.get< account_authority_object, by_account_lookup >( name );
       owner = authority( auth.owner );
       active = authority( auth.active );
       posting = authority( auth.posting );
@@ -33,6 +33,7 @@ class debug_node_api_impl
          (debug_set_hardfork)
          (debug_has_hardfork)
          (debug_get_json_schema)
+         (debug_get_state_digest)
       )
 
       chain::database& _db;
@@ -150,6 +151,14 @@ DEFINE_API_IMPL( debug_node_api_impl, debug_get_json_schema )
    return { _db.get_json_schema() };
 }
 
+DEFINE_API_IMPL( debug_node_api_impl, debug_get_state_digest )
+{
+   return _db.with_read_lock( [&]()
+   {
+      return _db.get_state_digest();
+   });
+}
+
 } // detail
 
 debug_node_api::debug_node_api(): my( new detail::debug_node_api_impl() )
@@ -169,6 +178,7 @@ DEFINE_LOCKLESS_APIS( debug_node_api,
    (debug_set_hardfork)
    (debug_has_hardfork)
    (debug_get_json_schema)
+   (debug_get_state_digest)
 )
 
 } } } // steem::plugins::debug_node
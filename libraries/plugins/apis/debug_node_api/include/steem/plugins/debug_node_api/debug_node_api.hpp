@@ -3,6 +3,8 @@
 #include <steem/plugins/database_api/database_api_objects.hpp>
 #include <steem/plugins/debug_node/debug_node_plugin.hpp>
 
+#include <steem/chain/util/state_digest.hpp>
+
 #include <steem/protocol/types.hpp>
 
 #include <fc/optional.hpp>
@@ -70,6 +72,9 @@ struct debug_get_json_schema_return
    std::string schema;
 };
 
+typedef void_type debug_get_state_digest_args;
+typedef steem::chain::util::state_digest debug_get_state_digest_return;
+
 
 class debug_node_api
 {
@@ -103,6 +108,11 @@ class debug_node_api
          (debug_set_hardfork)
          (debug_has_hardfork)
          (debug_get_json_schema)
+
+         /*
+          * Digests of the chain state, requires the node to run with enable-state-digest
+          */
+         (debug_get_state_digest)
       )
 
    private:
@@ -1,4 +1,5 @@
 #include <steem/chain/database_exceptions.hpp>
+#include <steem/chain/transaction_prevalidator.hpp>
 
 #include <steem/plugins/chain/chain_plugin.hpp>
 #include <steem/plugins/statsd/utility.hpp>
@@ -42,7 +43,17 @@ struct generate_block_request
    signed_block block;
 };
 
-typedef fc::static_variant< const signed_block*, const signed_transaction*, generate_block_request* > write_request_ptr;
+struct accept_blocks_request
+{
+   accept_blocks_request( const vector< const signed_block* >& b, vector< fc::optional< fc::exception > >& r ) :
+      blocks( b ),
+      results( r ) {}
+
+   const vector< const signed_block* >&         blocks;
+   vector< fc::optional< fc::exception > >&     results;
+};
+
+typedef fc::static_variant< const signed_block*, const signed_transaction*, const pending_transaction*, generate_block_request*, accept_blocks_request* > write_request_ptr;
 typedef fc::static_variant< boost::promise< void >*, fc::future< void >* > promise_ptr;
 
 struct write_context
@@ -77,9 +88,11 @@ class chain_plugin_impl
       bool                             dump_memory_details = false;
       bool                             benchmark_is_enabled =false;
       bool                             statsd_on_replay = false;
+      bool                             enable_state_digest = false;
       uint32_t                         stop_replay_at = 0;
       uint32_t                         benchmark_interval = 0;
       uint32_t                         flush_interval = 0;
+      uint32_t                         parallel_validation_threads = 0;
       flat_map<uint32_t,block_id_type> loaded_checkpoints;
 
       uint32_t allow_future_time = 5;
@@ -150,6 +163,40 @@ struct write_request_visitor
       return result;
    }
 
+   bool operator()( const pending_transaction* trx )
+   {
+      bool result = false;
+
+      try
+      {
+         STATSD_START_TIMER( chain, write_time, push_tx, 1.0f )
+         db->push_transaction( *trx );
+         STATSD_STOP_TIMER( chain, write_time, push_tx )
+
+         result = true;
+      }
+      catch( fc::exception& e )
+      {
+         *except = e;
+      }
+      catch( ... )
+      {
+         *except = fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unexpected exception while pushing transaction." ),
+                                           std::current_exception() );
+      }
+
+      return result;
+   }
+
+   bool operator()( accept_blocks_request* req )
+   {
+      STATSD_START_TIMER( chain, write_time, push_blocks, 1.0f )
+      bool result = db->push_blocks( req->blocks, req->results, skip );
+      STATSD_STOP_TIMER( chain, write_time, push_blocks )
+
+      return result;
+   }
+
    bool operator()( generate_block_request* req )
    {
       bool result = false;
@@ -304,6 +351,10 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("flush-state-interval", bpo::value<uint32_t>(),
             "flush shared memory changes to disk every N blocks")
+         ("parallel-validation-threads", bpo::value<uint32_t>()->default_value(0),
+            "Experimental. Number of threads validating operations and recovering signatures of a block's transactions before the block is applied. 0 disables it." )
+         ("enable-state-digest", bpo::bool_switch()->default_value(false),
+            "Keep an incremental digest of every object index. It is reported at set-benchmark-interval checkpoints and by debug_node_api.debug_get_state_digest." )
          ;
    cli.add_options()
          ("replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain database and replay all blocks" )
@@ -354,6 +405,9 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
    else
       my->flush_interval = 10000;
 
+   my->parallel_validation_threads = options.at( "parallel-validation-threads" ).as< uint32_t >();
+   my->enable_state_digest = options.at( "enable-state-digest" ).as< bool >();
+
    if(options.count("checkpoint"))
    {
       auto cps = options.at("checkpoint").as<vector<string>>();
@@ -433,8 +487,10 @@ void chain_plugin::plugin_startup()
    db_open_args.do_validate_invariants = my->validate_invariants;
    db_open_args.stop_replay_at = my->stop_replay_at;
    db_open_args.benchmark_is_enabled = my->benchmark_is_enabled;
+   db_open_args.parallel_validation_threads = my->parallel_validation_threads;
+   db_open_args.enable_state_digest = my->enable_state_digest;
 
-   auto benchmark_lambda = [&dumper, &get_indexes_memory_details, dump_memory_details] ( uint32_t current_block_number,
+   auto benchmark_lambda = [this, &dumper, &get_indexes_memory_details, dump_memory_details] ( uint32_t current_block_number,
       const chainbase::database::abstract_index_cntr_t& abstract_index_cntr )
    {
       if( current_block_number == 0 ) // initial call
@@ -457,14 +513,28 @@ void chain_plugin::plugin_startup()
          return;
       }
 
+      std::string state_digest;
+      if( my->enable_state_digest )
+      {
+         auto digest = my->db.get_state_digest();
+         if( digest.valid )
+            state_digest = digest.digest.str();
+         ilog( "State digest at block ${n}: ${d}", ("n", current_block_number)("d", digest.valid ? state_digest : "invalid") );
+      }
+
       const steem::utilities::benchmark_dumper::measurement& measure =
-         dumper.measure(current_block_number, get_indexes_memory_details);
+         dumper.measure(current_block_number, get_indexes_memory_details, state_digest);
       ilog( "Performance report at block ${n}. Elapsed time: ${rt} ms (real), ${ct} ms (cpu). Memory usage: ${cm} (current), ${pm} (peak) kilobytes.",
          ("n", current_block_number)
          ("rt", measure.real_ms)
          ("ct", measure.cpu_ms)
          ("cm", measure.current_mem)
          ("pm", measure.peak_mem) );
+      if( steem::utilities::benchmark_dumper::heap_counters_available() )
+         ilog( "Heap usage at block ${n}: ${ha} allocations, ${hb} bytes.",
+            ("n", current_block_number)
+            ("ha", measure.heap_allocations)
+            ("hb", measure.heap_allocated_bytes) );
    };
 
    if(my->replay)
@@ -483,6 +553,10 @@ void chain_plugin::plugin_startup()
                ("ct", total_data.cpu_ms)
                ("cm", total_data.current_mem)
                ("pm", total_data.peak_mem) );
+         if( steem::utilities::benchmark_dumper::heap_counters_available() )
+            ilog( "Heap usage (total): ${ha} allocations, ${hb} bytes.",
+                  ("ha", total_data.heap_allocations)
+                  ("hb", total_data.heap_allocated_bytes) );
       }
 
       if( my->stop_replay_at > 0 && my->stop_replay_at == last_block_number )
@@ -531,6 +605,14 @@ void chain_plugin::plugin_shutdown()
 {
    ilog("closing chain database");
    my->stop_write_processing();
+
+   if( my->db.get_transaction_prevalidator() != nullptr )
+   {
+      const auto& stats = my->db.get_transaction_prevalidator()->get_stats();
+      ilog( "Parallel validation: ${b} blocks, ${t} transactions, ${f} left to serial checks, ${g} independent groups, largest group ${l}",
+         ("b", stats.blocks)("t", stats.transactions)("f", stats.failed)("g", stats.independent_groups)("l", stats.largest_group) );
+   }
+
    my->db.close();
    ilog("database closed successfully");
 }
@@ -561,6 +643,59 @@ bool chain_plugin::accept_block( const steem::chain::signed_block& block, bool c
    return cxt.success;
 }
 
+vector< fc::optional< fc::exception > > chain_plugin::accept_blocks( const vector< const steem::chain::signed_block* >& blocks, uint32_t skip )
+{
+   vector< fc::optional< fc::exception > > results( blocks.size() );
+
+   for( size_t i = 0; i < blocks.size(); ++i )
+   {
+      const auto& block = *blocks[i];
+      if( block.block_num() % 10000 == 0 )
+      {
+         ilog("Syncing Blockchain --- Got block: #${n} time: ${t} producer: ${p}",
+              ("t", block.timestamp)
+              ("n", block.block_num())
+              ("p", block.witness) );
+      }
+
+      try
+      {
+         check_time_in_block( block );
+      }
+      catch( const fc::exception& e )
+      {
+         results[i] = e;
+      }
+   }
+
+   accept_blocks_request req( blocks, results );
+   boost::promise< void > prom;
+   write_context cxt;
+   cxt.req_ptr = &req;
+   cxt.skip = skip;
+   cxt.prom_ptr = &prom;
+
+   my->write_queue.push( &cxt );
+
+   prom.get_future().get();
+
+   return results;
+}
+
+void chain_plugin::accept_transaction( const steem::chain::pending_transaction& trx )
+{
+   boost::promise< void > prom;
+   write_context cxt;
+   cxt.req_ptr = &trx;
+   cxt.prom_ptr = &prom;
+
+   my->write_queue.push( &cxt );
+
+   prom.get_future().get();
+
+   if( cxt.except ) throw *(cxt.except);
+}
+
 void chain_plugin::accept_transaction( const steem::chain::signed_transaction& trx )
 {
    boost::promise< void > prom;
@@ -583,6 +718,8 @@ steem::chain::signed_block chain_plugin::generate_block(
    const fc::ecc::private_key& block_signing_private_key,
    uint32_t skip )
 {
+   // Measures the whole slot critical path as seen by the witness, including the wait for the write lock.
+   STATSD_START_TIMER( chain, latency, generate_block, 1.0f )
    generate_block_request req( when, witness_owner, block_signing_private_key, skip );
    boost::promise< void > prom;
    write_context cxt;
@@ -592,6 +729,7 @@ steem::chain::signed_block chain_plugin::generate_block(
    my->write_queue.push( &cxt );
 
    prom.get_future().get();
+   STATSD_STOP_TIMER( chain, latency, generate_block )
 
    if( cxt.except ) throw *(cxt.except);
 
@@ -34,7 +34,17 @@ public:
    virtual void plugin_shutdown() override;
 
    bool accept_block( const steem::chain::signed_block& block, bool currently_syncing, uint32_t skip );
+
+   /**
+    * Pushes a run of sync blocks as a single write request, so the whole run is applied under one
+    * hold of the write lock. Every block is attempted in order. The result has one entry per block,
+    * empty if the block was accepted or holding the exception it was rejected with.
+    */
+   vector< fc::optional< fc::exception > > accept_blocks( const vector< const steem::chain::signed_block* >& blocks, uint32_t skip );
+
    void accept_transaction( const steem::chain::signed_transaction& trx );
+   /// Accepts a transaction checked with database::precheck_transaction, reusing its recovered signature keys
+   void accept_transaction( const steem::chain::pending_transaction& trx );
    steem::chain::signed_block generate_block(
       const fc::time_point_sec when,
       const account_name_type& witness_owner,
@@ -22,7 +22,7 @@ void follow_evaluator::do_apply( const follow_operation& o )
          return follow_map;
       }();
 
-      const auto& idx = _db.get_index<follow_index>().indices().get< by_follower_following >();
+      const auto& idx = _db.get_index<follow_index>().indices().get< by_follower_following_lookup >();
       auto itr = idx.find( boost::make_tuple( o.follower, o.following ) );
 
       uint16_t what = 0;
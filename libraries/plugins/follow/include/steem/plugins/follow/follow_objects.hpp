@@ -170,6 +170,17 @@ typedef oid< follow_count_object > follow_count_id_type;
 struct by_following_follower;
 struct by_follower_following;
 
+/**
+ * Index for finding a single follow by ( follower, following ). Building with HASHED_NAME_INDEX adds a
+ * hashed by_follower_following_hash index, the walks over a blogger's followers stay on the ordered indices.
+ */
+#ifdef HASHED_NAME_INDEX
+struct by_follower_following_hash;
+typedef by_follower_following_hash by_follower_following_lookup;
+#else
+typedef by_follower_following by_follower_following_lookup;
+#endif
+
 using namespace boost::multi_index;
 
 typedef multi_index_container<
@@ -190,6 +201,16 @@ typedef multi_index_container<
          >,
          composite_key_compare< std::less< account_name_type >, std::less< account_name_type > >
       >
+#ifdef HASHED_NAME_INDEX
+      ,
+      hashed_unique< tag< by_follower_following_hash >,
+         composite_key< follow_object,
+            member< follow_object, account_name_type, &follow_object::follower >,
+            member< follow_object, account_name_type, &follow_object::following >
+         >,
+         composite_key_hash< chainbase::byte_hash< account_name_type >, chainbase::byte_hash< account_name_type > >
+      >
+#endif
    >,
    allocator< follow_object >
 > follow_index;
@@ -42,6 +42,19 @@ BOOST_PP_SEQ_FOR_EACH( DECLARE_API_IMPL_HELPER, _, METHODS )
 #define DEFINE_API_IMPL( class, method )                                                        \
 BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _args )& args )   \
 
+/**
+ * Chunked APIs receive the lock flag in their implementation and take the read lock themselves,
+ * so long scans can release it between chunks instead of holding it for the whole call.
+ */
+#define DECLARE_CHUNKED_API_IMPL_HELPER( r, data, method ) \
+BOOST_PP_CAT( method, _return ) method( const BOOST_PP_CAT( method, _args )& args, bool lock );
+
+#define DECLARE_CHUNKED_API_IMPL( METHODS ) \
+BOOST_PP_SEQ_FOR_EACH( DECLARE_CHUNKED_API_IMPL_HELPER, _, METHODS )
+
+#define DEFINE_CHUNKED_API_IMPL( class, method )                                                            \
+BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _args )& args, bool lock )   \
+
 #define DEFINE_READ_API_HELPER( r, class, method )                                                       \
 BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _args )& args, bool lock ) \
 {                                                                                                        \
@@ -81,6 +94,15 @@ BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _a
 #define DEFINE_WRITE_APIS( class, METHODS ) \
    BOOST_PP_SEQ_FOR_EACH( DEFINE_WRITE_API_HELPER, class, METHODS )
 
+#define DEFINE_CHUNKED_READ_API_HELPER( r, class, method )                                               \
+BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _args )& args, bool lock ) \
+{                                                                                                        \
+   return my->method( args, lock );                                                                      \
+}
+
+#define DEFINE_CHUNKED_READ_APIS( class, METHODS ) \
+   BOOST_PP_SEQ_FOR_EACH( DEFINE_CHUNKED_READ_API_HELPER, class, METHODS )
+
 #define DEFINE_LOCKLESS_APIS( class, METHODS ) \
    BOOST_PP_SEQ_FOR_EACH( DEFINE_LOCKLESS_API_HELPER, class, METHODS )
 
@@ -90,6 +90,8 @@ public:
    // node_delegate interface
    virtual bool has_item( const graphene::net::item_id& ) override;
    virtual bool handle_block( const graphene::net::block_message&, bool, std::vector<fc::uint160_t>& ) override;
+   virtual void precheck_sync_blocks( const std::vector< const graphene::net::block_message* >& ) override;
+   virtual std::vector< fc::oexception > handle_sync_blocks( const std::vector< const graphene::net::block_message* >& ) override;
    virtual void handle_transaction( const graphene::net::trx_message& ) override;
    virtual void handle_message( const graphene::net::message& ) override;
    virtual std::vector< graphene::net::item_hash_t > get_block_ids( const std::vector< graphene::net::item_hash_t >&, uint32_t&, uint32_t ) override;
@@ -238,6 +240,68 @@ bool p2p_plugin_impl::handle_block( const graphene::net::block_message& blk_msg,
    return false;
 } FC_CAPTURE_AND_RETHROW( (blk_msg)(sync_mode) ) }
 
+void p2p_plugin_impl::precheck_sync_blocks( const std::vector< const graphene::net::block_message* >& blk_msgs )
+{
+   if( !running.load() )
+      return;
+
+   // Witness key recovery does not touch chain state, so it skips the write queue. It is only queued
+   // on the validation threads, this thread never waits for it.
+   std::vector< const chain::signed_block* > blocks;
+   blocks.reserve( blk_msgs.size() );
+   for( const auto* blk_msg : blk_msgs )
+      blocks.push_back( &blk_msg->block );
+   chain.db().precheck_block_signees( blocks );
+}
+
+std::vector< fc::oexception > p2p_plugin_impl::handle_sync_blocks( const std::vector< const graphene::net::block_message* >& blk_msgs )
+{
+   if( !running.load() )
+   {
+      ilog("Sync blocks ignored due to started p2p_plugin shutdown");
+      if(handleBlockFinished.second.valid() == false)
+         handleBlockFinished.first.set_value();
+      FC_THROW("Preventing further processing of ignored blocks...");
+   }
+
+   shutdown_helper helper(*this, activeHandleBlock, handleBlockFinished);
+
+   std::vector< const chain::signed_block* > blocks;
+   blocks.reserve( blk_msgs.size() );
+   for( const auto* blk_msg : blk_msgs )
+      blocks.push_back( &blk_msg->block );
+
+   if( blocks.size() )
+      fc_ilog(fc::logger::get("sync"),
+            "chain pushing ${count} sync blocks #${first} to #${last}",
+            ("count", blocks.size())
+            ("first", blocks.front()->block_num())
+            ("last", blocks.back()->block_num()));
+
+   // The whole run goes to the write thread as one request, errors come back for each block
+   std::vector< fc::oexception > results = chain.accept_blocks( blocks,
+      ( block_producer | force_validate ) ? chain::database::skip_nothing : chain::database::skip_transaction_signatures );
+
+   for( size_t i = 0; i < results.size(); ++i )
+   {
+      if( !results[i] )
+         continue;
+
+      fc_elog(fc::logger::get("sync"),
+            "Error when pushing sync block #${n}:\n${e}",
+            ("n", blocks[i]->block_num())
+            ("e", results[i]->to_detail_string()));
+      elog("Error when pushing block:\n${e}", ("e", results[i]->to_detail_string()));
+
+      // translate to a graphene::net exception
+      if( results[i]->code() == chain::unlinkable_block_exception::code_value )
+         results[i] = graphene::net::unlinkable_block_exception( FC_LOG_MESSAGE( error, "Error when pushing block:\n${e}",
+            ("e", results[i]->to_detail_string()) ) );
+   }
+
+   return results;
+}
+
 void p2p_plugin_impl::handle_transaction( const graphene::net::trx_message& trx_msg )
 {
    if(running.load())
@@ -246,7 +310,49 @@ void p2p_plugin_impl::handle_transaction( const graphene::net::trx_message& trx_
       {
          shutdown_helper helper(*this, activeHandleTx, handleTxFinished);
 
-         chain.accept_transaction( trx_msg.trx );
+         // Turn away what the chain would reject anyway before the transaction waits for the write lock.
+         // Malformed and badly signed transactions are reported as invalid_transaction_exception, the
+         // node holds only those against the peer. Duplicate, expired and TaPoS-invalid transactions
+         // depend on our view of the chain and are not the peer's fault. The keys recovered here are
+         // reused when the transaction is applied.
+         chain::pending_transaction ptrx( trx_msg.trx );
+         try
+         {
+            ptrx.trx.validate();
+            ptrx.get_signature_keys( chain.db().get_chain_id() );
+         }
+         catch( const fc::exception& e )
+         {
+            throw graphene::net::invalid_transaction_exception( FC_LOG_MESSAGE( warn, "Invalid transaction:\n${e}",
+               ("e", e.to_detail_string()) ) );
+         }
+
+         chain.db().with_read_lock( [&]()
+         {
+            chain.db().precheck_transaction( ptrx );
+         });
+
+         try
+         {
+            chain.accept_transaction( ptrx );
+         }
+         catch( const fc::exception& e )
+         {
+            // the exception crossed from the write thread as a plain fc::exception, only its code is left
+            switch( e.code() )
+            {
+               case protocol::tx_missing_active_auth::code_value:
+               case protocol::tx_missing_owner_auth::code_value:
+               case protocol::tx_missing_posting_auth::code_value:
+               case protocol::tx_missing_other_auth::code_value:
+               case protocol::tx_irrelevant_sig::code_value:
+               case protocol::tx_duplicate_sig::code_value:
+                  throw graphene::net::invalid_transaction_exception( FC_LOG_MESSAGE( warn, "Invalid transaction:\n${e}",
+                     ("e", e.to_detail_string()) ) );
+               default:
+                  throw;
+            }
+         }
 
       } FC_CAPTURE_AND_RETHROW( (trx_msg) )
    }
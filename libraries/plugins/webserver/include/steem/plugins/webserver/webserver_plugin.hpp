@@ -26,6 +26,13 @@ using namespace appbase;
   * The HTTP service will run in its own thread with its own io_service to
   * make sure that HTTP request processing does not interfer with other
   * plugins.
+  *
+  * Websocket clients may also call webserver.subscribe with
+  * {"irreversible_blocks":bool,"virtual_ops":bool,"accounts":[...]} to have
+  * webserver.notice messages pushed to them as blocks are applied, and
+  * webserver.unsubscribe to stop them. Operations are pushed from reversible
+  * blocks; a block_undone notice follows if such a block is popped. See
+  * webserver_subscriptions.
   */
 class webserver_plugin : public appbase::plugin< webserver_plugin >
 {
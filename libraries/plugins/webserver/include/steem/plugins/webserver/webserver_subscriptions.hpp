@@ -0,0 +1,145 @@
+#pragma once
+#include <appbase/application.hpp>
+
+#include <steem/chain/database.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <websocketpp/common/connection_hdl.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define STEEM_WEBSERVER_SUBSCRIBE_METHOD     "webserver.subscribe"
+#define STEEM_WEBSERVER_UNSUBSCRIBE_METHOD   "webserver.unsubscribe"
+#define STEEM_WEBSERVER_NOTICE_METHOD        "webserver.notice"
+#define STEEM_WEBSERVER_MAX_SUBSCRIBED_ACCOUNTS 1000
+
+namespace steem { namespace plugins { namespace webserver {
+
+using websocketpp::connection_hdl;
+
+/**
+ * What a websocket connection wants pushed to it. A connection holds at most one subscription,
+ * subscribing again replaces it.
+ */
+struct subscribe_args
+{
+   bool                                         irreversible_blocks = false;
+   bool                                         virtual_ops = false;
+   fc::flat_set< protocol::account_name_type >  accounts;
+};
+
+struct block_notice
+{
+   uint32_t                      block_num = 0;
+   protocol::block_id_type       block_id;
+};
+
+struct operation_notice
+{
+   operation_notice() {}
+   operation_notice( const chain::operation_notification& note, const protocol::block_id_type& id, const fc::time_point_sec& t ) :
+      trx_id( note.trx_id ),
+      block( note.block ),
+      block_id( id ),
+      trx_in_block( note.trx_in_block ),
+      op_in_trx( note.op_in_trx ),
+      virtual_op( note.virtual_op ),
+      timestamp( t ),
+      op( note.op )
+   {}
+
+   protocol::transaction_id_type trx_id;
+   uint32_t                      block = 0;
+   protocol::block_id_type       block_id;
+   uint32_t                      trx_in_block = 0;
+   uint32_t                      op_in_trx = 0;
+   uint32_t                      virtual_op = 0;
+   fc::time_point_sec            timestamp;
+   protocol::operation           op;
+};
+
+/**
+ * Keeps the webserver.subscribe state of every websocket connection and turns chain events into
+ * webserver.notice messages.
+ *
+ * Operations are collected on the write thread while a block is being applied and handed off at
+ * post_apply_block. Operation notices are sent as soon as their block is applied, so when that
+ * block is later popped (by a fork switch or pop_block) every connection that receives operations
+ * is sent a block_undone notice with the id of the removed block. Subscribers that need final
+ * data should wait for the irreversible_block notice of that block number.
+ *
+ * Notices are rendered once and handed to send_notice on the given io_service through a strand, so
+ * they reach each connection in chain order.
+ */
+class webserver_subscriptions
+{
+   public:
+      typedef std::function< void( connection_hdl, const std::string& ) > send_notice_type;
+
+      webserver_subscriptions( boost::asio::io_service& ios, send_notice_type send_notice );
+
+      /// Returns the JSON-RPC response if payload was a subscription request
+      boost::optional< std::string > handle_request( connection_hdl hdl, const std::string& payload );
+      void remove( connection_hdl hdl );
+
+      void connect( chain::database& db, const appbase::abstract_plugin& plugin );
+      void disconnect();
+
+   private:
+      typedef std::map< connection_hdl, std::shared_ptr< const subscribe_args >, std::owner_less< connection_hdl > > subscription_map;
+      typedef std::vector< std::pair< connection_hdl, std::shared_ptr< const subscribe_args > > > subscription_list;
+
+      void update_flags();
+      subscription_list get_subscriptions();
+
+      void on_pre_apply_block( const chain::block_notification& note );
+      void on_post_apply_operation( const chain::operation_notification& note );
+      void on_post_apply_block( const chain::block_notification& note );
+      void on_post_pop_block( const chain::block_notification& note );
+      void on_irreversible_block( uint32_t block_num );
+
+      void dispatch_operations( const std::vector< operation_notice >& ops );
+      void dispatch_block( const std::string& type, const block_notice& block, bool to_operation_subscribers );
+
+      chain::database*                    _db = nullptr;
+      send_notice_type                    _send_notice;
+
+      boost::mutex                        _mtx;
+      subscription_map                    _subscriptions;
+      std::atomic< bool >                 _wants_ops{ false };
+      std::atomic< bool >                 _wants_blocks{ false };
+
+      boost::asio::io_service::strand     _strand;
+
+      /// Only touched from the chain write thread
+      std::vector< operation_notice >     _block_ops;
+      protocol::block_id_type             _block_id;
+      fc::time_point_sec                  _block_time;
+
+      boost::signals2::connection         _pre_apply_block_con;
+      boost::signals2::connection         _post_apply_operation_con;
+      boost::signals2::connection         _post_apply_block_con;
+      boost::signals2::connection         _post_pop_block_con;
+      boost::signals2::connection         _irreversible_block_con;
+};
+
+} } } // steem::plugins::webserver
+
+FC_REFLECT( steem::plugins::webserver::subscribe_args,
+   (irreversible_blocks)(virtual_ops)(accounts) )
+
+FC_REFLECT( steem::plugins::webserver::block_notice,
+   (block_num)(block_id) )
+
+FC_REFLECT( steem::plugins::webserver::operation_notice,
+   (trx_id)(block)(block_id)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(op) )
@@ -1,5 +1,7 @@
 #include <steem/plugins/webserver/webserver_plugin.hpp>
 
+#include <steem/plugins/webserver/webserver_subscriptions.hpp>
+
 #include <steem/plugins/chain/chain_plugin.hpp>
 
 #include <fc/network/ip.hpp>
@@ -83,7 +85,8 @@ class webserver_plugin_impl
 {
    public:
       webserver_plugin_impl(thread_pool_size_t thread_pool_size) :
-         thread_pool_work( this->thread_pool_ios )
+         thread_pool_work( this->thread_pool_ios ),
+         subscriptions( this->thread_pool_ios, boost::bind( &webserver_plugin_impl::send_notice, this, _1, _2 ) )
       {
          for( uint32_t i = 0; i < thread_pool_size; ++i )
             thread_pool.create_thread( boost::bind( &asio::io_service::run, &thread_pool_ios ) );
@@ -95,6 +98,8 @@ class webserver_plugin_impl
       void handle_ws_message( websocket_server_type*, connection_hdl, detail::websocket_server_type::message_ptr );
       void handle_http_message( websocket_server_type*, connection_hdl );
 
+      void send_notice( connection_hdl hdl, const string& notice );
+
       shared_ptr< std::thread >  http_thread;
       asio::io_service           http_ios;
       optional< tcp::endpoint >  http_endpoint;
@@ -111,6 +116,9 @@ class webserver_plugin_impl
 
       plugins::json_rpc::json_rpc_plugin* api;
       boost::signals2::connection         chain_sync_con;
+
+      webserver_subscriptions             subscriptions;
+      size_t                              max_subscription_buffer = 0;
 };
 
 void webserver_plugin_impl::start_webserver()
@@ -128,6 +136,7 @@ void webserver_plugin_impl::start_webserver()
             ws_server.set_reuse_addr( true );
 
             ws_server.set_message_handler( boost::bind( &webserver_plugin_impl::handle_ws_message, this, &ws_server, _1, _2 ) );
+            ws_server.set_close_handler( boost::bind( &webserver_subscriptions::remove, &subscriptions, _1 ) );
 
             if( http_endpoint && http_endpoint == ws_endpoint )
             {
@@ -208,12 +217,15 @@ void webserver_plugin_impl::handle_ws_message( websocket_server_type* server, co
 {
    auto con = server->get_con_from_hdl( hdl );
 
-   thread_pool_ios.post( [con, msg, this]()
+   thread_pool_ios.post( [con, hdl, msg, this]()
    {
       try
       {
          if( msg->get_opcode() == websocketpp::frame::opcode::text )
-            con->send( api->call( msg->get_payload() ) );
+         {
+            auto response = subscriptions.handle_request( hdl, msg->get_payload() );
+            con->send( response ? *response : api->call( msg->get_payload() ) );
+         }
          else
             con->send( "error: string payload expected" );
       }
@@ -287,6 +299,29 @@ void webserver_plugin_impl::handle_http_message( websocket_server_type* server,
    });
 }
 
+void webserver_plugin_impl::send_notice( connection_hdl hdl, const string& notice )
+{
+   websocketpp::lib::error_code ec;
+   auto con = ws_server.get_con_from_hdl( hdl, ec );
+
+   if( ec )
+   {
+      subscriptions.remove( hdl );
+      return;
+   }
+
+   // A consumer that cannot keep up is dropped instead of growing its send buffer without bound
+   if( con->get_buffered_amount() + notice.size() > max_subscription_buffer )
+   {
+      wlog( "Dropping slow websocket subscriber ${r}", ("r", con->get_remote_endpoint()) );
+      subscriptions.remove( hdl );
+      con->close( websocketpp::close::status::try_again_later, "subscription buffer full", ec );
+      return;
+   }
+
+   con->send( notice );
+}
+
 } // detail
 
 webserver_plugin::webserver_plugin() {}
@@ -300,6 +335,8 @@ void webserver_plugin::set_program_options( options_description&, options_descri
       ("rpc-endpoint", bpo::value< string >(), "Local http and websocket endpoint for webserver requests. Deprecated in favor of webserver-http-endpoint and webserver-ws-endpoint" )
       ("webserver-thread-pool-size", bpo::value<thread_pool_size_t>()->default_value(32),
        "Number of threads used to handle queries. Default: 32.")
+      ("webserver-ws-subscription-buffer-mb", bpo::value< uint32_t >()->default_value(4),
+       "Megabytes of unsent subscription notices a websocket connection may queue before it is dropped. Default: 4.")
       ;
 }
 
@@ -309,6 +346,7 @@ void webserver_plugin::plugin_initialize( const variables_map& options )
    FC_ASSERT(thread_pool_size > 0, "webserver-thread-pool-size must be greater than 0");
    ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
    my.reset(new detail::webserver_plugin_impl(thread_pool_size));
+   my->max_subscription_buffer = size_t( options.at( "webserver-ws-subscription-buffer-mb" ).as< uint32_t >() ) * 1024 * 1024;
 
    if( options.count( "webserver-http-endpoint" ) )
    {
@@ -356,6 +394,9 @@ void webserver_plugin::plugin_startup()
    FC_ASSERT( my->api != nullptr, "Could not find API Register Plugin" );
 
    plugins::chain::chain_plugin* chain = appbase::app().find_plugin< plugins::chain::chain_plugin >();
+   if( chain != nullptr && my->ws_endpoint )
+      my->subscriptions.connect( chain->db(), *this );
+
    if( chain != nullptr && chain->get_state() != appbase::abstract_plugin::started )
    {
       ilog( "Waiting for chain plugin to start" );
@@ -372,6 +413,7 @@ void webserver_plugin::plugin_startup()
 
 void webserver_plugin::plugin_shutdown()
 {
+   my->subscriptions.disconnect();
    my->stop_webserver();
 }
 
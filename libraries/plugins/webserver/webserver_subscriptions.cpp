@@ -0,0 +1,256 @@
+#include <steem/plugins/webserver/webserver_subscriptions.hpp>
+
+#include <steem/plugins/json_rpc/json_rpc_plugin.hpp>
+
+#include <steem/chain/util/impacted.hpp>
+#include <steem/chain/util/signal.hpp>
+
+#include <fc/io/json.hpp>
+
+namespace steem { namespace plugins { namespace webserver {
+
+using std::string;
+using boost::optional;
+
+webserver_subscriptions::webserver_subscriptions( boost::asio::io_service& ios, send_notice_type send_notice ) :
+   _send_notice( send_notice ),
+   _strand( ios )
+{}
+
+optional< string > webserver_subscriptions::handle_request( connection_hdl hdl, const string& payload )
+{
+   optional< string > response;
+
+   if( _db == nullptr || payload.find( "webserver." ) == string::npos )
+      return response;
+
+   fc::variant v;
+   try
+   {
+      v = fc::json::from_string( payload );
+   }
+   catch( ... )
+   {
+      // Let json_rpc report the parse error
+      return response;
+   }
+
+   if( !v.is_object() )
+      return response;
+
+   const auto& request = v.get_object();
+   if( !request.contains( "method" ) || !request[ "method" ].is_string() )
+      return response;
+
+   const auto& method = request[ "method" ].get_string();
+   if( method != STEEM_WEBSERVER_SUBSCRIBE_METHOD && method != STEEM_WEBSERVER_UNSUBSCRIBE_METHOD )
+      return response;
+
+   fc::mutable_variant_object reply( "jsonrpc", "2.0" );
+   reply( "id", request.contains( "id" ) ? request[ "id" ] : fc::variant() );
+
+   try
+   {
+      if( method == STEEM_WEBSERVER_SUBSCRIBE_METHOD )
+      {
+         auto args = std::make_shared< subscribe_args >();
+         if( request.contains( "params" ) )
+            fc::from_variant( request[ "params" ], *args );
+
+         FC_ASSERT( args->accounts.size() <= STEEM_WEBSERVER_MAX_SUBSCRIBED_ACCOUNTS,
+            "Cannot subscribe to more than ${n} accounts", ("n", STEEM_WEBSERVER_MAX_SUBSCRIBED_ACCOUNTS) );
+
+         {
+            boost::lock_guard< boost::mutex > guard( _mtx );
+            _subscriptions[ hdl ] = args;
+         }
+         update_flags();
+      }
+      else
+      {
+         remove( hdl );
+      }
+
+      reply( "result", fc::variant_object() );
+   }
+   catch( const fc::exception& e )
+   {
+      reply( "error", fc::mutable_variant_object( "code", JSON_RPC_INVALID_PARAMS )( "message", e.to_string() ) );
+   }
+
+   response = fc::json::to_string( reply );
+   return response;
+}
+
+void webserver_subscriptions::remove( connection_hdl hdl )
+{
+   {
+      boost::lock_guard< boost::mutex > guard( _mtx );
+      if( !_subscriptions.erase( hdl ) )
+         return;
+   }
+   update_flags();
+}
+
+void webserver_subscriptions::update_flags()
+{
+   bool ops = false;
+   bool blocks = false;
+
+   boost::lock_guard< boost::mutex > guard( _mtx );
+   for( const auto& s : _subscriptions )
+   {
+      ops = ops || s.second->virtual_ops || s.second->accounts.size();
+      blocks = blocks || s.second->irreversible_blocks;
+   }
+
+   _wants_ops.store( ops );
+   _wants_blocks.store( blocks );
+}
+
+webserver_subscriptions::subscription_list webserver_subscriptions::get_subscriptions()
+{
+   boost::lock_guard< boost::mutex > guard( _mtx );
+   return subscription_list( _subscriptions.begin(), _subscriptions.end() );
+}
+
+void webserver_subscriptions::connect( chain::database& db, const appbase::abstract_plugin& plugin )
+{
+   _db = &db;
+
+   _pre_apply_block_con = _db->add_pre_apply_block_handler(
+      [this]( const chain::block_notification& note ){ on_pre_apply_block( note ); }, plugin );
+   _post_apply_operation_con = _db->add_post_apply_operation_handler(
+      [this]( const chain::operation_notification& note ){ on_post_apply_operation( note ); }, plugin );
+   _post_apply_block_con = _db->add_post_apply_block_handler(
+      [this]( const chain::block_notification& note ){ on_post_apply_block( note ); }, plugin );
+   _post_pop_block_con = _db->add_post_pop_block_handler(
+      [this]( const chain::block_notification& note ){ on_post_pop_block( note ); }, plugin );
+   _irreversible_block_con = _db->add_irreversible_block_handler(
+      [this]( uint32_t block_num ){ on_irreversible_block( block_num ); }, plugin );
+}
+
+void webserver_subscriptions::disconnect()
+{
+   chain::util::disconnect_signal( _pre_apply_block_con );
+   chain::util::disconnect_signal( _post_apply_operation_con );
+   chain::util::disconnect_signal( _post_apply_block_con );
+   chain::util::disconnect_signal( _post_pop_block_con );
+   chain::util::disconnect_signal( _irreversible_block_con );
+}
+
+void webserver_subscriptions::on_pre_apply_block( const chain::block_notification& note )
+{
+   _block_ops.clear();
+   _block_id = note.block_id;
+   _block_time = note.block.timestamp;
+}
+
+void webserver_subscriptions::on_post_apply_operation( const chain::operation_notification& note )
+{
+   // Operations of pending transactions are not part of a block yet
+   if( !_wants_ops.load( std::memory_order_relaxed ) || !_db->is_processing_block() )
+      return;
+
+   _block_ops.emplace_back( note, _block_id, _block_time );
+}
+
+void webserver_subscriptions::on_post_apply_block( const chain::block_notification& note )
+{
+   if( _block_ops.empty() )
+      return;
+
+   auto ops = std::make_shared< std::vector< operation_notice > >( std::move( _block_ops ) );
+   _block_ops.clear();
+
+   _strand.post( [this, ops](){ dispatch_operations( *ops ); } );
+}
+
+void webserver_subscriptions::on_post_pop_block( const chain::block_notification& note )
+{
+   if( !_wants_ops.load( std::memory_order_relaxed ) )
+      return;
+
+   block_notice block;
+   block.block_num = note.block_num;
+   block.block_id = note.block_id;
+
+   _strand.post( [this, block](){ dispatch_block( "block_undone", block, true ); } );
+}
+
+void webserver_subscriptions::on_irreversible_block( uint32_t block_num )
+{
+   if( !_wants_blocks.load( std::memory_order_relaxed ) )
+      return;
+
+   block_notice block;
+   block.block_num = block_num;
+   block.block_id = _db->get_block_id_for_num( block_num );
+
+   _strand.post( [this, block](){ dispatch_block( "irreversible_block", block, false ); } );
+}
+
+static string render_notice( const string& type, const fc::variant& data )
+{
+   return fc::json::to_string( fc::mutable_variant_object
+      ( "jsonrpc", "2.0" )
+      ( "method", STEEM_WEBSERVER_NOTICE_METHOD )
+      ( "params", fc::mutable_variant_object( "type", type )( "data", data ) ) );
+}
+
+void webserver_subscriptions::dispatch_operations( const std::vector< operation_notice >& ops )
+{
+   auto subs = get_subscriptions();
+   if( subs.empty() )
+      return;
+
+   fc::flat_set< protocol::account_name_type > impacted;
+
+   for( const auto& op : ops )
+   {
+      bool is_virtual = protocol::is_virtual_operation( op.op );
+      string notice;
+
+      impacted.clear();
+      app::operation_get_impacted_accounts( op.op, impacted );
+
+      for( const auto& s : subs )
+      {
+         bool matched = is_virtual && s.second->virtual_ops;
+
+         for( auto itr = impacted.begin(); !matched && itr != impacted.end(); ++itr )
+            matched = s.second->accounts.find( *itr ) != s.second->accounts.end();
+
+         if( !matched )
+            continue;
+
+         // Render once and fan out the same bytes to every matching connection
+         if( notice.empty() )
+            notice = render_notice( "operation", fc::variant( op ) );
+
+         _send_notice( s.first, notice );
+      }
+   }
+}
+
+void webserver_subscriptions::dispatch_block( const string& type, const block_notice& block, bool to_operation_subscribers )
+{
+   string notice;
+
+   for( const auto& s : get_subscriptions() )
+   {
+      bool matched = to_operation_subscribers ?
+         s.second->virtual_ops || s.second->accounts.size() :
+         s.second->irreversible_blocks;
+
+      if( !matched )
+         continue;
+
+      if( notice.empty() )
+         notice = render_notice( type, fc::variant( block ) );
+
+      _send_notice( s.first, notice );
+   }
+}
+
+} } } // steem::plugins::webserver
@@ -44,20 +44,36 @@ namespace steem { namespace protocol {
       if( transactions.size() == 0 )
          return checksum_type();
 
+      // Pack all transactions into one buffer and hash the leaves in a single batch
+      vector< uint32_t > sizes( transactions.size() );
+      size_t total_size = 0;
+      for( uint32_t i = 0; i < transactions.size(); ++i )
+      {
+         sizes[i] = fc::raw::pack_size( transactions[i] );
+         total_size += sizes[i];
+      }
+
+      vector< char > packed( total_size );
+      vector< const char* > leaves( transactions.size() );
+      fc::datastream< char* > ds( packed.data(), packed.size() );
+      for( uint32_t i = 0; i < transactions.size(); ++i )
+      {
+         leaves[i] = packed.data() + ds.tellp();
+         fc::raw::pack( ds, transactions[i] );
+      }
+
       vector<digest_type> ids;
       ids.resize( transactions.size() );
-      for( uint32_t i = 0; i < transactions.size(); ++i )
-         ids[i] = transactions[i].merkle_digest();
+      digest_type::hash_many( leaves.data(), sizes.data(), ids.data(), ids.size() );
 
       vector<digest_type>::size_type current_number_of_hashes = ids.size();
       while( current_number_of_hashes > 1 )
       {
          // hash ID's in pairs
          uint32_t i_max = current_number_of_hashes - (current_number_of_hashes&1);
-         uint32_t k = 0;
+         uint32_t k = i_max / 2;
 
-         for( uint32_t i = 0; i < i_max; i += 2 )
-            ids[k++] = digest_type::hash( std::make_pair( ids[i], ids[i+1] ) );
+         digest_type::hash_pairs( ids.data(), ids.data(), k );
 
          if( current_number_of_hashes&1 )
             ids[k++] = ids[i_max];
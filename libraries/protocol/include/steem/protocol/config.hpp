@@ -243,6 +243,7 @@
 
 #define STEEM_MIN_UNDO_HISTORY                10
 #define STEEM_MAX_UNDO_HISTORY                10000
+#define STEEM_MAX_PRECHECKED_BLOCK_SIGNEES    10000 /// witness keys recovered ahead of sync blocks, not consensus
 
 #define STEEM_MIN_TRANSACTION_EXPIRATION_LIMIT (STEEM_BLOCK_INTERVAL * 5) // 5 transactions per block
 #define STEEM_BLOCKCHAIN_PRECISION            uint64_t( 1000 )
@@ -58,6 +58,41 @@ namespace fc
 
 namespace steem { namespace protocol {
 
+namespace detail {
+
+   /**
+    * Comparisons of the native endian storage without branches. fixed_string keys are compared
+    * on every step down an ordered index, where the hi/lo branches of fc::uint128 mispredict
+    * on names sharing a prefix.
+    */
+   inline bool storage_less( uint64_t a, uint64_t b ) { return a < b; }
+   inline bool storage_equal( uint64_t a, uint64_t b ) { return a == b; }
+
+   inline bool storage_less( const fc::uint128& a, const fc::uint128& b )
+   {
+      typedef unsigned __int128 native_uint128_t;
+      return ( ( native_uint128_t( a.hi ) << 64 ) | a.lo ) < ( ( native_uint128_t( b.hi ) << 64 ) | b.lo );
+   }
+
+   inline bool storage_equal( const fc::uint128& a, const fc::uint128& b )
+   {
+      return ( ( a.hi ^ b.hi ) | ( a.lo ^ b.lo ) ) == 0;
+   }
+
+   template< typename A, typename B >
+   inline bool storage_less( const fc::erpair< A, B >& a, const fc::erpair< A, B >& b )
+   {
+      return storage_less( a.first, b.first ) | ( storage_equal( a.first, b.first ) & storage_less( a.second, b.second ) );
+   }
+
+   template< typename A, typename B >
+   inline bool storage_equal( const fc::erpair< A, B >& a, const fc::erpair< A, B >& b )
+   {
+      return storage_equal( a.first, b.first ) & storage_equal( a.second, b.second );
+   }
+
+} // detail
+
 /**
  * This class is an in-place memory allocation of a fixed length character string.
  *
@@ -122,12 +157,12 @@ class fixed_string_impl
 
       friend std::string operator + ( const fixed_string_impl& a, const std::string& b ) { return std::string( a ) + b; }
       friend std::string operator + ( const std::string& a, const fixed_string_impl& b ){ return a + std::string( b ); }
-      friend bool operator < ( const fixed_string_impl& a, const fixed_string_impl& b ) { return a.data < b.data; }
-      friend bool operator <= ( const fixed_string_impl& a, const fixed_string_impl& b ) { return a.data <= b.data; }
-      friend bool operator > ( const fixed_string_impl& a, const fixed_string_impl& b ) { return a.data > b.data; }
-      friend bool operator >= ( const fixed_string_impl& a, const fixed_string_impl& b ) { return a.data >= b.data; }
-      friend bool operator == ( const fixed_string_impl& a, const fixed_string_impl& b ) { return a.data == b.data; }
-      friend bool operator != ( const fixed_string_impl& a, const fixed_string_impl& b ) { return a.data != b.data; }
+      friend bool operator < ( const fixed_string_impl& a, const fixed_string_impl& b ) { return detail::storage_less( a.data, b.data ); }
+      friend bool operator <= ( const fixed_string_impl& a, const fixed_string_impl& b ) { return !detail::storage_less( b.data, a.data ); }
+      friend bool operator > ( const fixed_string_impl& a, const fixed_string_impl& b ) { return detail::storage_less( b.data, a.data ); }
+      friend bool operator >= ( const fixed_string_impl& a, const fixed_string_impl& b ) { return !detail::storage_less( a.data, b.data ); }
+      friend bool operator == ( const fixed_string_impl& a, const fixed_string_impl& b ) { return detail::storage_equal( a.data, b.data ); }
+      friend bool operator != ( const fixed_string_impl& a, const fixed_string_impl& b ) { return !detail::storage_equal( a.data, b.data ); }
 
       Storage data;
 };
@@ -1,8 +1,35 @@
 
 #include <steem/utilities/benchmark_dumper.hpp>
 
+#include <steem/utilities/heap_counters.hpp>
+
 namespace steem { namespace utilities {
 
+std::atomic< bool >       heap_counters::available( false );
+std::atomic< bool >       heap_counters::enabled( false );
+std::atomic< uint64_t >   heap_counters::allocations( 0 );
+std::atomic< uint64_t >   heap_counters::bytes( 0 );
+
+bool benchmark_dumper::heap_counters_available()
+{
+   return heap_counters::available.load( std::memory_order_relaxed );
+}
+
+void benchmark_dumper::enable_heap_counters()
+{
+   heap_counters::enabled.store( true, std::memory_order_relaxed );
+}
+
+uint64_t benchmark_dumper::heap_allocations()
+{
+   return heap_counters::allocations.load( std::memory_order_relaxed );
+}
+
+uint64_t benchmark_dumper::heap_allocated_bytes()
+{
+   return heap_counters::bytes.load( std::memory_order_relaxed );
+}
+
 #define PROC_STATUS_LINE_LENGTH 1028
 
 typedef std::function<void(const char* key)> TScanErrorCallback;
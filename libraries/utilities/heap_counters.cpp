@@ -0,0 +1,57 @@
+#include <steem/utilities/heap_counters.hpp>
+
+#include <cstdlib>
+#include <new>
+
+// Linked only into executables that opt in, see STEEM_COUNT_HEAP_ALLOCATIONS.
+
+namespace {
+
+using steem::utilities::heap_counters;
+
+void* counted_malloc( size_t size ) noexcept
+{
+   if( size == 0 )
+      size = 1;
+
+   if( heap_counters::enabled.load( std::memory_order_relaxed ) )
+   {
+      heap_counters::allocations.fetch_add( 1, std::memory_order_relaxed );
+      heap_counters::bytes.fetch_add( size, std::memory_order_relaxed );
+   }
+
+   void* p = nullptr;
+   while( ( p = std::malloc( size ) ) == nullptr )
+   {
+      std::new_handler handler = std::get_new_handler();
+      if( handler == nullptr )
+         return nullptr;
+      handler();
+   }
+   return p;
+}
+
+void* counted_new( size_t size )
+{
+   void* p = counted_malloc( size );
+   if( p == nullptr )
+      throw std::bad_alloc();
+   return p;
+}
+
+struct mark_available
+{
+   mark_available() { heap_counters::available.store( true, std::memory_order_relaxed ); }
+} mark_available_instance;
+
+} // anonymous
+
+void* operator new( size_t size ) { return counted_new( size ); }
+void* operator new[]( size_t size ) { return counted_new( size ); }
+void* operator new( size_t size, const std::nothrow_t& ) noexcept { return counted_malloc( size ); }
+void* operator new[]( size_t size, const std::nothrow_t& ) noexcept { return counted_malloc( size ); }
+
+void operator delete( void* p ) noexcept { std::free( p ); }
+void operator delete[]( void* p ) noexcept { std::free( p ); }
+void operator delete( void* p, const std::nothrow_t& ) noexcept { std::free( p ); }
+void operator delete[]( void* p, const std::nothrow_t& ) noexcept { std::free( p ); }
@@ -59,13 +59,15 @@ public:
    class measurement
    {
    public:
-      void set(uint32_t bn, int64_t rm, int32_t cs, uint64_t cm, uint64_t pm)
+      void set(uint32_t bn, int64_t rm, int32_t cs, uint64_t cm, uint64_t pm, uint64_t ha, uint64_t hb)
       {
          block_number = bn;
          real_ms = rm;
          cpu_ms = cs;
          current_mem = cm;
          peak_mem = pm;
+         heap_allocations = ha;
+         heap_allocated_bytes = hb;
       }
 
    public:
@@ -74,6 +76,11 @@ public:
       int32_t  cpu_ms = 0;
       uint64_t current_mem = 0;
       uint64_t peak_mem = 0;
+      /// Calls to global operator new and the bytes they requested
+      uint64_t heap_allocations = 0;
+      uint64_t heap_allocated_bytes = 0;
+      /// Digest of the chain state at block_number, empty unless state digests are enabled
+      std::string state_digest;
       index_memory_details_cntr_t index_memory_details_cntr;
    };
 
@@ -96,10 +103,14 @@ public:
       _init_sys_time = _last_sys_time = fc::time_point::now();
       _init_cpu_time = _last_cpu_time = clock();
       _pid = getpid();
+      enable_heap_counters();
+      _init_heap_allocations = _last_heap_allocations = heap_allocations();
+      _init_heap_allocated_bytes = _last_heap_allocated_bytes = heap_allocated_bytes();
       get_database_objects_sizeofs(_all_data.database_object_sizeofs);
    }
 
-   const measurement& measure(uint32_t block_number, get_indexes_memory_details_t get_indexes_memory_details)
+   const measurement& measure(uint32_t block_number, get_indexes_memory_details_t get_indexes_memory_details,
+      const std::string& state_digest = std::string())
    {
       uint64_t current_virtual = 0;
       uint64_t peak_virtual = 0;
@@ -107,25 +118,35 @@ public:
    
       fc::time_point current_sys_time = fc::time_point::now();
       clock_t current_cpu_time = clock();
+      uint64_t current_heap_allocations = heap_allocations();
+      uint64_t current_heap_allocated_bytes = heap_allocated_bytes();
    
       measurement data;
       data.set( block_number,
                 (current_sys_time - _last_sys_time).count()/1000, // real_ms
                 int((current_cpu_time - _last_cpu_time) * 1000 / CLOCKS_PER_SEC), // cpu_ms
                 current_virtual,
-                peak_virtual );
+                peak_virtual,
+                current_heap_allocations - _last_heap_allocations,
+                current_heap_allocated_bytes - _last_heap_allocated_bytes );
+      data.state_digest = state_digest;
       get_indexes_memory_details(data.index_memory_details_cntr, true);
       _all_data.measurements.push_back( data );
    
       _last_sys_time = current_sys_time;
       _last_cpu_time = current_cpu_time;
+      _last_heap_allocations = current_heap_allocations;
+      _last_heap_allocated_bytes = current_heap_allocated_bytes;
       _total_blocks = block_number;
 
       _all_data.total_measurement.set(_total_blocks,
          (_last_sys_time - _init_sys_time).count()/1000,
          int((_last_cpu_time - _init_cpu_time) * 1000 / CLOCKS_PER_SEC),
          current_virtual,
-         peak_virtual );
+         peak_virtual,
+         _last_heap_allocations - _init_heap_allocations,
+         _last_heap_allocated_bytes - _init_heap_allocated_bytes );
+      _all_data.total_measurement.state_digest = state_digest;
 
       dump(false, get_indexes_memory_details);
    
@@ -164,6 +185,16 @@ public:
       return _all_data.total_measurement;
    }
 
+   /**
+    * Heap allocations are only counted when the executable links the steem_heap_counters objects,
+    * otherwise the counts stay 0. Counting is off until the first call to enable_heap_counters(),
+    * which initialize() does.
+    */
+   static bool     heap_counters_available();
+   static void     enable_heap_counters();
+   static uint64_t heap_allocations();
+   static uint64_t heap_allocated_bytes();
+
 private:
    bool read_mem(pid_t pid, uint64_t* current_virtual, uint64_t* peak_virtual);
 
@@ -174,6 +205,10 @@ private:
    clock_t        _init_cpu_time = 0;
    clock_t        _last_cpu_time = 0;
    uint64_t       _total_blocks = 0;
+   uint64_t       _init_heap_allocations = 0;
+   uint64_t       _last_heap_allocations = 0;
+   uint64_t       _init_heap_allocated_bytes = 0;
+   uint64_t       _last_heap_allocated_bytes = 0;
    pid_t          _pid = 0;
    TAllData       _all_data;
 };
@@ -189,7 +224,8 @@ FC_REFLECT( steem::utilities::benchmark_dumper::database_object_sizeof_t,
             (object_name)(object_size) )
 
 FC_REFLECT( steem::utilities::benchmark_dumper::measurement,
-            (block_number)(real_ms)(cpu_ms)(current_mem)(peak_mem)(index_memory_details_cntr) )
+            (block_number)(real_ms)(cpu_ms)(current_mem)(peak_mem)(heap_allocations)(heap_allocated_bytes)
+            (state_digest)(index_memory_details_cntr) )
 
 FC_REFLECT( steem::utilities::benchmark_dumper::TAllData,
             (database_object_sizeofs)(measurements)(total_measurement) )
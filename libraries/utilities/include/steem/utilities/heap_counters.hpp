@@ -0,0 +1,23 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace steem { namespace utilities {
+
+/**
+ * Heap allocation counters for the replay benchmark. They only move in executables that link the
+ * steem_heap_counters objects, which replace global operator new. steemd does so when it is built
+ * with STEEM_COUNT_HEAP_ALLOCATIONS, every other binary keeps the default allocator.
+ */
+struct heap_counters
+{
+   /// Set during static initialization when the operator new replacement is linked in
+   static std::atomic< bool >       available;
+   /// Counting is off until enabled, so startup allocations are not included
+   static std::atomic< bool >       enabled;
+   static std::atomic< uint64_t >   allocations;
+   static std::atomic< uint64_t >   bytes;
+};
+
+} } // steem::utilities
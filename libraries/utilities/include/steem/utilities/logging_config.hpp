@@ -17,6 +17,7 @@ struct appender_args
    std::string appender;
    std::string file;
    std::string stream;
+   bool        async = false;
 
    void validate();
 };
@@ -36,5 +37,5 @@ fc::optional<fc::logging_config> load_logging_config( const boost::program_optio
 
 } } // steem::utilities
 
-FC_REFLECT( steem::utilities::appender_args, (appender)(file)(stream) )
+FC_REFLECT( steem::utilities::appender_args, (appender)(file)(stream)(async) )
 FC_REFLECT( steem::utilities::logger_args, (name)(level)(appender) )
@@ -17,6 +17,7 @@ void appender_args::validate()
 {
    FC_ASSERT( appender.length(), "Must specify an appender name" );
    FC_ASSERT( ( file.length() > 0 ) ^ ( stream.length() > 0 ), "Must specify either a file or a stream" );
+   FC_ASSERT( !async || file.length() > 0, "Only file appenders can be async" );
 }
 
 void logger_args::validate()
@@ -40,7 +41,8 @@ void set_logging_program_options( boost::program_options::options_description& o
 
    options.add_options()
       ("log-appender", boost::program_options::value< std::vector< std::string > >()->composing()->default_value( default_appender, str_default_appender ),
-         "Appender definition json: {\"appender\", \"stream\", \"file\"} Can only specify a file OR a stream" )
+         "Appender definition json: {\"appender\", \"stream\", \"file\", \"async\"} Can only specify a file OR a stream. "
+         "File appenders with \"async\":true write from a background thread and drop messages when they fall behind" )
       ("log-console-appender", boost::program_options::value< std::vector< std::string > >()->composing() )
       ("log-file-appender", boost::program_options::value< std::vector< std::string > >()->composing() )
       ("log-logger", boost::program_options::value< std::vector< std::string > >()->composing()->default_value( default_logger, str_default_logger ),
@@ -114,6 +116,7 @@ fc::optional<fc::logging_config> load_logging_config( const boost::program_optio
                file_appender_config.rotate = true;
                file_appender_config.rotation_interval = fc::hours(1);
                file_appender_config.rotation_limit = fc::days(1);
+               file_appender_config.async = appender.async;
                logging_config.appenders.push_back(
                                                   fc::appender_config( appender.appender, "file", fc::variant( file_appender_config ) ) );
                found_logging_config = true;
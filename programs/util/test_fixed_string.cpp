@@ -1,9 +1,21 @@
 
 #include <steem/protocol/fixed_string.hpp>
 
+#include <chainbase/util/byte_hash.hpp>
+
 #include <fc/io/raw.hpp>
+#include <fc/time.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -85,6 +97,128 @@ void check_pack( const std::string& s, const steem::protocol::fixed_string_impl<
    }
 }
 
+typedef steem::protocol::fixed_string< 16 > name_type;
+
+/// The fixed_string< 16 > comparison as implemented on fc::uint128, used as the reference
+struct reference_less
+{
+   bool operator()( const name_type& a, const name_type& b )const { return a.data < b.data; }
+};
+
+template< typename Lambda >
+int64_t time_us( Lambda&& l )
+{
+   fc::time_point start = fc::time_point::now();
+   l();
+   return ( fc::time_point::now() - start ).count();
+}
+
+template< typename Index >
+int64_t time_lookups( const Index& idx, const std::vector< name_type >& queries, size_t& found )
+{
+   return time_us( [&]()
+   {
+      for( const auto& q : queries )
+         found += idx.find( q ) != idx.end();
+   });
+}
+
+/**
+ * Times the operations by_name indices perform on account names: sorting, ordered lookups with
+ * the reference and the branch free comparison, and hashed lookups.
+ */
+int benchmark( uint32_t count, uint32_t lookups )
+{
+   using namespace boost::multi_index;
+
+   std::mt19937_64 gen( 42 );
+   const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789.-";
+   int bench_errors = 0;
+
+   // Account names share prefixes far more often than random strings, mix in numbered names
+   std::vector< name_type > names;
+   names.reserve( count );
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      std::string n;
+      if( i % 4 == 0 )
+      {
+         n = "user" + std::to_string( i );
+      }
+      else
+      {
+         size_t len = 3 + gen() % 14;
+         for( size_t j = 0; j < len; ++j )
+            n += alphabet[ gen() % ( sizeof( alphabet ) - 1 ) ];
+      }
+      names.push_back( name_type( n ) );
+   }
+
+   std::vector< name_type > queries;
+   queries.reserve( lookups );
+   for( uint32_t i = 0; i < lookups; ++i )
+      queries.push_back( i % 8 == 0 ? name_type( "missing" + std::to_string( i ) ) : names[ gen() % names.size() ] );
+
+   // Best of a few rounds, alternating which comparison goes first so neither gets the warmer cache
+   const int rounds = 3;
+   int64_t sort_fast = INT64_MAX, sort_reference = INT64_MAX;
+   for( int r = 0; r < rounds; ++r )
+   {
+      std::vector< name_type > sorted = names;
+      std::vector< name_type > reference_sorted = names;
+      auto fast = [&](){ sort_fast = std::min( sort_fast, time_us( [&](){ std::sort( sorted.begin(), sorted.end() ); } ) ); };
+      auto reference = [&](){ sort_reference = std::min( sort_reference,
+         time_us( [&](){ std::sort( reference_sorted.begin(), reference_sorted.end(), reference_less() ); } ) ); };
+
+      if( r % 2 ) { fast(); reference(); }
+      else { reference(); fast(); }
+
+      if( sorted != reference_sorted )
+      {
+         std::cout << "sort order differs from the reference comparison" << std::endl;
+         ++bench_errors;
+      }
+   }
+
+   std::cout << "sort " << names.size() << " names: reference " << sort_reference << " us, branch free "
+             << sort_fast << " us" << std::endl;
+
+   multi_index_container< name_type, indexed_by< ordered_unique< identity< name_type > > > > ordered;
+   multi_index_container< name_type, indexed_by< ordered_unique< identity< name_type >, reference_less > > > reference_ordered;
+   multi_index_container< name_type, indexed_by< hashed_unique< identity< name_type >, chainbase::byte_hash< name_type > > > > hashed;
+
+   for( const auto& n : names )
+   {
+      ordered.insert( n );
+      reference_ordered.insert( n );
+      hashed.insert( n );
+   }
+
+   int64_t lookup_reference = INT64_MAX, lookup_ordered = INT64_MAX, lookup_hashed = INT64_MAX;
+   for( int r = 0; r < rounds; ++r )
+   {
+      size_t found_reference = 0, found_ordered = 0, found_hashed = 0;
+      auto fast = [&](){ lookup_ordered = std::min( lookup_ordered, time_lookups( ordered, queries, found_ordered ) ); };
+      auto reference = [&](){ lookup_reference = std::min( lookup_reference, time_lookups( reference_ordered, queries, found_reference ) ); };
+
+      if( r % 2 ) { fast(); reference(); }
+      else { reference(); fast(); }
+      lookup_hashed = std::min( lookup_hashed, time_lookups( hashed, queries, found_hashed ) );
+
+      if( found_ordered != found_reference || found_hashed != found_reference )
+      {
+         std::cout << "lookups found " << found_reference << " (reference), " << found_ordered << " (ordered), "
+                   << found_hashed << " (hashed) names" << std::endl;
+         ++bench_errors;
+      }
+   }
+
+   std::cout << queries.size() << " lookups in " << ordered.size() << " names: ordered reference " << lookup_reference
+             << " us, ordered branch free " << lookup_ordered << " us, hashed " << lookup_hashed << " us" << std::endl;
+
+   return bench_errors;
+}
+
 int main( int argc, char** argv, char** envp )
 {
    std::vector< std::string > all_strings;
@@ -314,5 +448,9 @@ int main( int argc, char** argv, char** envp )
 
    result |= (errors == 0) ? 0 : 1;
 
+   uint32_t bench_names = argc > 1 ? std::atoi( argv[1] ) : 1000000;
+   uint32_t bench_lookups = argc > 2 ? std::atoi( argv[2] ) : 2000000;
+   result |= benchmark( bench_names, bench_lookups ) == 0 ? 0 : 1;
+
    return result;
 }
@@ -0,0 +1,118 @@
+
+#include <steem/protocol/block.hpp>
+#include <steem/protocol/steem_operations.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/time.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using steem::protocol::checksum_type;
+using steem::protocol::digest_type;
+using steem::protocol::signed_block;
+using steem::protocol::signed_transaction;
+
+// The merkle root as computed before batched hashing, used as the reference result
+checksum_type reference_merkle_root( const signed_block& b )
+{
+   if( b.transactions.size() == 0 )
+      return checksum_type();
+
+   std::vector< digest_type > ids( b.transactions.size() );
+   for( uint32_t i = 0; i < b.transactions.size(); ++i )
+      ids[i] = b.transactions[i].merkle_digest();
+
+   auto current_number_of_hashes = ids.size();
+   while( current_number_of_hashes > 1 )
+   {
+      uint32_t i_max = current_number_of_hashes - (current_number_of_hashes&1);
+      uint32_t k = 0;
+
+      for( uint32_t i = 0; i < i_max; i += 2 )
+         ids[k++] = digest_type::hash( std::make_pair( ids[i], ids[i+1] ) );
+
+      if( current_number_of_hashes&1 )
+         ids[k++] = ids[i_max];
+      current_number_of_hashes = k;
+   }
+   return checksum_type::hash( ids[0] );
+}
+
+signed_block make_block( uint32_t num_transactions )
+{
+   signed_block b;
+   for( uint32_t i = 0; i < num_transactions; ++i )
+   {
+      signed_transaction tx;
+      tx.ref_block_num = uint16_t( i );
+      tx.ref_block_prefix = i * 2654435761u;
+      tx.expiration = fc::time_point_sec( 1500000000 + i );
+
+      steem::protocol::transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = steem::protocol::asset( i + 1, STEEM_SYMBOL );
+      op.memo = std::string( i % 200, 'm' );
+      tx.operations.push_back( op );
+      b.transactions.push_back( tx );
+   }
+   return b;
+}
+
+template< typename Lambda >
+int64_t time_us( uint32_t iterations, Lambda&& l )
+{
+   fc::time_point start = fc::time_point::now();
+   for( uint32_t i = 0; i < iterations; ++i )
+      l();
+   return ( fc::time_point::now() - start ).count();
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   uint32_t iterations = argc > 1 ? std::atoi( argv[1] ) : 200;
+   int errors = 0;
+
+   std::cout << "sha256 hardware acceleration: " << fc::sha256::has_hardware_acceleration() << std::endl;
+
+   for( uint32_t n : { 1u, 2u, 3u, 17u, 100u, 1000u, 5000u } )
+   {
+      signed_block b = make_block( n );
+
+      if( b.calculate_merkle_root() != reference_merkle_root( b ) )
+      {
+         std::cout << "merkle root mismatch with " << n << " transactions" << std::endl;
+         ++errors;
+      }
+
+      checksum_type sink;
+      int64_t reference = time_us( iterations, [&](){ sink = reference_merkle_root( b ); } );
+      int64_t batched = time_us( iterations, [&](){ sink = b.calculate_merkle_root(); } );
+
+      std::cout << n << " transactions: reference " << reference / iterations << " us, batched "
+                << batched / iterations << " us" << std::endl;
+   }
+
+   std::vector< digest_type > leaves( 1 << 16 );
+   for( size_t i = 0; i < leaves.size(); ++i )
+      leaves[i] = digest_type::hash( (const char*)&i, sizeof(i) );
+
+   std::vector< digest_type > out( leaves.size() / 2 );
+   int64_t single = time_us( iterations, [&]()
+   {
+      for( size_t i = 0; i < out.size(); ++i )
+         out[i] = digest_type::hash( std::make_pair( leaves[ 2 * i ], leaves[ 2 * i + 1 ] ) );
+   });
+   int64_t pairs = time_us( iterations, [&](){ digest_type::hash_pairs( leaves.data(), out.data(), out.size() ); } );
+
+   std::cout << out.size() << " digest pairs: one at a time " << single / iterations << " us, hash_pairs "
+             << pairs / iterations << " us" << std::endl;
+
+   if( errors )
+      std::cout << errors << " errors" << std::endl;
+
+   return errors ? 1 : 0;
+}
@@ -0,0 +1,633 @@
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/exceptions.hpp>
+#include <graphene/net/node.hpp>
+
+#include <steem/protocol/block.hpp>
+#include <steem/protocol/steem_operations.hpp>
+
+#include <fc/asio.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/time.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using graphene::net::block_message;
+using graphene::net::item_hash_t;
+using graphene::net::item_id;
+using graphene::net::trx_message;
+using steem::protocol::block_header;
+using steem::protocol::block_id_type;
+using steem::protocol::signed_block;
+using steem::protocol::signed_transaction;
+using steem::protocol::transaction_id_type;
+
+/**
+ * A linear chain kept in memory, standing in for the chain plugin so the benchmark measures the p2p
+ * layer rather than block application. Blocks must link to the head and carry the producer's signature
+ * and a correct merkle root, anything else is accepted.
+ */
+class benchmark_delegate : public graphene::net::node_delegate
+{
+   public:
+      benchmark_delegate( const fc::ecc::public_key& producer, uint32_t sync_target ) :
+         _producer( producer ), _sync_target( sync_target ) {}
+
+      steem::protocol::chain_id_type get_chain_id() const override { return STEEM_CHAIN_ID; }
+
+      bool has_item( const item_id& id ) override
+      {
+         if( id.item_type == graphene::net::block_message_type )
+            return _block_nums.count( id.item_hash ) || _block_message_ids.count( id.item_hash );
+         return _transactions.count( id.item_hash ) > 0;
+      }
+
+      bool handle_block( const block_message& blk_msg, bool sync_mode, std::vector< fc::uint160_t >& ) override
+      {
+         if( _block_nums.count( blk_msg.block_id ) )
+            return false;
+
+         if( blk_msg.block.previous != get_head_block_id() )
+            FC_THROW_EXCEPTION( graphene::net::unlinkable_block_exception, "block ${n} does not link to our head ${h}",
+               ("n", blk_msg.block.block_num())("h", get_head_block_id()) );
+         FC_ASSERT( blk_msg.block.transaction_merkle_root == blk_msg.block.calculate_merkle_root(), "bad merkle root" );
+         FC_ASSERT( blk_msg.block.signee() == _producer, "block not signed by the producer" );
+
+         append_block( blk_msg.block );
+
+         if( !sync_mode )
+            block_received[ blk_msg.block_id ] = fc::time_point::now();
+         return false;
+      }
+
+      void precheck_sync_blocks( const std::vector< const block_message* >& ) override {}
+
+      std::vector< fc::oexception > handle_sync_blocks( const std::vector< const block_message* >& blk_msgs ) override
+      {
+         std::vector< fc::oexception > results( blk_msgs.size() );
+         std::vector< fc::uint160_t > contained_transaction_message_ids;
+         for( size_t i = 0; i < blk_msgs.size(); ++i )
+         {
+            try
+            {
+               handle_block( *blk_msgs[i], true, contained_transaction_message_ids );
+            }
+            catch( const fc::exception& e )
+            {
+               results[i] = e;
+            }
+         }
+         return results;
+      }
+
+      void handle_transaction( const trx_message& trx_msg ) override
+      {
+         _transactions[ graphene::net::message( trx_msg ).id() ] = trx_msg.trx;
+         transaction_received.emplace( trx_msg.trx.id(), fc::time_point::now() );
+      }
+
+      void handle_message( const graphene::net::message& ) override
+      {
+         FC_THROW( "Invalid Message Type" );
+      }
+
+      std::vector< item_hash_t > get_block_ids( const std::vector< item_hash_t >& blockchain_synopsis,
+                                                uint32_t& remaining_item_count, uint32_t limit ) override
+      {
+         std::vector< item_hash_t > result;
+         remaining_item_count = 0;
+         if( _blocks.empty() )
+            return result;
+
+         uint32_t last_known_num = 0;
+         bool found_a_block_in_synopsis = blockchain_synopsis.empty();
+         for( auto it = blockchain_synopsis.rbegin(); it != blockchain_synopsis.rend(); ++it )
+         {
+            if( *it == item_hash_t() || _block_nums.count( *it ) )
+            {
+               last_known_num = block_header::num_from_id( *it );
+               found_a_block_in_synopsis = true;
+               break;
+            }
+         }
+
+         if( !found_a_block_in_synopsis )
+            FC_THROW_EXCEPTION( graphene::net::peer_is_on_an_unreachable_fork, "Unable to provide a list of blocks starting at any of the blocks in peer's synopsis" );
+
+         for( uint32_t num = std::max< uint32_t >( last_known_num, 1 ); num <= _blocks.size() && result.size() < limit; ++num )
+            result.push_back( _blocks[ num - 1 ].id() );
+
+         if( !result.empty() && block_header::num_from_id( result.back() ) < _blocks.size() )
+            remaining_item_count = _blocks.size() - block_header::num_from_id( result.back() );
+
+         return result;
+      }
+
+      graphene::net::message get_item( const item_id& id ) override
+      {
+         if( id.item_type == graphene::net::block_message_type )
+         {
+            auto itr = _block_nums.find( id.item_hash );
+            FC_ASSERT( itr != _block_nums.end(), "unknown block ${id}", ("id", id.item_hash) );
+            return block_message( _blocks[ itr->second - 1 ] );
+         }
+
+         auto itr = _transactions.find( id.item_hash );
+         FC_ASSERT( itr != _transactions.end(), "unknown transaction ${id}", ("id", id.item_hash) );
+         return trx_message( itr->second );
+      }
+
+      std::vector< item_hash_t > get_blockchain_synopsis( const item_hash_t& reference_point, uint32_t number_of_blocks_after_reference_point ) override
+      {
+         std::vector< item_hash_t > synopsis;
+         uint32_t high_block_num = _blocks.size();
+         if( reference_point != item_hash_t() && _block_nums.count( reference_point ) )
+            high_block_num = block_header::num_from_id( reference_point );
+         if( high_block_num == 0 )
+            return synopsis;
+
+         // the same spacing as the chain plugin, without forks or an undo history to account for
+         uint32_t low_block_num = 1;
+         uint32_t true_high_block_num = high_block_num + number_of_blocks_after_reference_point;
+         do
+         {
+            synopsis.push_back( _blocks[ low_block_num - 1 ].id() );
+            low_block_num += ( true_high_block_num - low_block_num + 2 ) / 2;
+         }
+         while( low_block_num <= high_block_num );
+
+         return synopsis;
+      }
+
+      void sync_status( uint32_t, uint32_t ) override {}
+      void connection_count_changed( uint32_t ) override {}
+
+      uint32_t get_block_number( const item_hash_t& block_id ) override { return block_header::num_from_id( block_id ); }
+
+      fc::time_point_sec get_block_time( const item_hash_t& block_id ) override
+      {
+         if( block_id == item_hash_t() )
+            return _blocks.empty() ? fc::time_point_sec( fc::time_point::now() ) : _blocks.front().timestamp;
+         auto itr = _block_nums.find( block_id );
+         return itr == _block_nums.end() ? fc::time_point_sec::min() : _blocks[ itr->second - 1 ].timestamp;
+      }
+
+      fc::time_point_sec get_blockchain_now() override { return fc::time_point::now(); }
+
+      item_hash_t get_head_block_id() const override { return _blocks.empty() ? item_hash_t() : item_hash_t( _blocks.back().id() ); }
+
+      uint32_t estimate_last_known_fork_from_git_revision_timestamp( uint32_t ) const override { return 0; }
+
+      void error_encountered( const std::string& message, const fc::oexception& error ) override
+      {
+         wlog( "${message}: ${error}", ("message", message)("error", error) );
+      }
+
+      uint32_t head_block_num() const { return _blocks.size(); }
+      const signed_block& head_block() const { return _blocks.back(); }
+
+      /// Adds a block made by this node to the chain, the caller broadcasts it
+      void append_block( const signed_block& block )
+      {
+         _blocks.push_back( block );
+         _block_nums[ block.id() ] = _blocks.size();
+         _block_message_ids.insert( graphene::net::message( block_message( block ) ).id() );
+
+         if( _blocks.size() == _sync_target )
+            synced_at = fc::time_point::now();
+      }
+
+      /// Adds a transaction made by this node, the caller broadcasts it
+      void add_transaction( const signed_transaction& trx )
+      {
+         _transactions[ graphene::net::message( trx_message( trx ) ).id() ] = trx;
+      }
+
+      fc::time_point                                  synced_at;
+      std::map< block_id_type, fc::time_point >       block_received;
+      std::map< transaction_id_type, fc::time_point > transaction_received;
+
+   private:
+      fc::ecc::public_key                             _producer;
+      uint32_t                                        _sync_target;
+      std::vector< signed_block >                     _blocks;
+      std::map< block_id_type, uint32_t >             _block_nums;
+      std::set< fc::uint160_t >                       _block_message_ids;
+      std::map< fc::uint160_t, signed_transaction >   _transactions;
+};
+
+struct benchmark_node
+{
+   std::unique_ptr< fc::thread >                    delegate_thread;
+   std::unique_ptr< benchmark_delegate >            delegate;
+   graphene::net::node_ptr                          node;
+   fc::temp_directory                               config_dir;
+   fc::ip::endpoint                                 endpoint;
+   std::set< int >                                  thread_ids;
+};
+
+// Thread CPU time is read from /proc, the threads a node starts while it is set up are charged to it
+std::set< int > list_thread_ids()
+{
+   std::set< int > result;
+#ifdef __linux__
+   for( boost::filesystem::directory_iterator itr( "/proc/self/task" ), end; itr != end; ++itr )
+      result.insert( std::atoi( itr->path().filename().string().c_str() ) );
+#endif
+   return result;
+}
+
+int64_t thread_cpu_us( int tid )
+{
+   std::ifstream stat( "/proc/self/task/" + std::to_string( tid ) + "/stat" );
+   std::string line;
+   if( !std::getline( stat, line ) )
+      return 0;
+
+   // the thread name may contain spaces, the fields after it can't
+   auto pos = line.rfind( ')' );
+   if( pos == std::string::npos )
+      return 0;
+
+   std::istringstream fields( line.substr( pos + 1 ) );
+   std::string field;
+   uint64_t ticks = 0;
+   for( int i = 3; i <= 15 && fields >> field; ++i )
+      if( i == 14 || i == 15 ) // utime and stime
+         ticks += std::stoull( field );
+
+   return int64_t( ticks * 1000000 / sysconf( _SC_CLK_TCK ) );
+}
+
+int64_t node_cpu_us( const benchmark_node& n )
+{
+   int64_t total = 0;
+   for( int tid : n.thread_ids )
+      total += thread_cpu_us( tid );
+   return total;
+}
+
+int64_t process_cpu_us()
+{
+   rusage usage;
+   getrusage( RUSAGE_SELF, &usage );
+   return int64_t( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+/// Bytes sent over the node's open connections
+uint64_t node_bytes_sent( const benchmark_node& n )
+{
+   uint64_t total = 0;
+   for( const auto& peer : n.node->get_connected_peers() )
+   {
+      auto itr = peer.info.find( "bytessent" );
+      if( itr != peer.info.end() )
+         total += itr->value().as_uint64();
+   }
+   return total;
+}
+
+int64_t percentile( const std::vector< int64_t >& sorted, double p )
+{
+   if( sorted.empty() )
+      return 0;
+   return sorted[ std::min< size_t >( sorted.size() - 1, size_t( p * sorted.size() ) ) ];
+}
+
+void print_latencies( const std::string& what, std::vector< int64_t > latencies, uint64_t expected )
+{
+   std::sort( latencies.begin(), latencies.end() );
+   std::cout << what << " propagation: " << latencies.size() << " of " << expected << " received, p50 "
+             << percentile( latencies, 0.5 ) / 1000.0 << " ms, p90 " << percentile( latencies, 0.9 ) / 1000.0
+             << " ms, p99 " << percentile( latencies, 0.99 ) / 1000.0 << " ms, max "
+             << ( latencies.empty() ? 0 : latencies.back() ) / 1000.0 << " ms" << std::endl;
+}
+
+signed_block make_block( const signed_block* previous, fc::time_point_sec timestamp,
+                         std::vector< signed_transaction > transactions, const fc::ecc::private_key& key )
+{
+   signed_block b;
+   if( previous )
+      b.previous = previous->id();
+   b.timestamp = timestamp;
+   b.witness = STEEM_INIT_MINER_NAME;
+   b.transactions = std::move( transactions );
+   b.transaction_merkle_root = b.calculate_merkle_root();
+   b.sign( key );
+   return b;
+}
+
+signed_transaction make_transaction( uint64_t n, const block_id_type& ref_block, const fc::ecc::private_key& key )
+{
+   signed_transaction tx;
+   tx.set_reference_block( ref_block );
+   tx.set_expiration( fc::time_point_sec( fc::time_point::now() ) + 3600 );
+
+   steem::protocol::transfer_operation op;
+   op.from = STEEM_INIT_MINER_NAME;
+   op.to = "bob";
+   op.amount = steem::protocol::asset( int64_t( n % 1000000 ) + 1, STEEM_SYMBOL );
+   op.memo = "p2p benchmark " + std::to_string( n );
+   tx.operations.push_back( op );
+   tx.sign( key, STEEM_CHAIN_ID );
+   return tx;
+}
+
+template< typename Lambda >
+bool wait_for( fc::microseconds timeout, Lambda&& done )
+{
+   fc::time_point deadline = fc::time_point::now() + timeout;
+   while( !done() )
+   {
+      if( fc::time_point::now() > deadline )
+         return false;
+      fc::usleep( fc::milliseconds( 50 ) );
+   }
+   return true;
+}
+
+/**
+ * Starts a network of graphene::net::nodes in this process, connected over 127.0.0.1. The first node
+ * holds a generated chain the others sync from, then produces live blocks and transactions at a fixed
+ * interval. Reports sync throughput, block and transaction propagation latency, CPU time per node and
+ * bytes sent on the wire for both phases.
+ *
+ * usage: test_p2p_network [nodes] [sync blocks] [live blocks] [transactions per block] [block interval ms]
+ *                         [peers per node] [p2p parameters json]
+ */
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t num_nodes = std::max( argc > 1 ? std::atoi( argv[1] ) : 8, 2 );
+      uint32_t sync_blocks = argc > 2 ? std::atoi( argv[2] ) : 2000;
+      uint32_t live_blocks = argc > 3 ? std::atoi( argv[3] ) : 100;
+      uint32_t trx_per_block = argc > 4 ? std::atoi( argv[4] ) : 50;
+      uint32_t block_interval_ms = argc > 5 ? std::atoi( argv[5] ) : 200;
+      uint32_t peers_per_node = std::max( argc > 6 ? std::atoi( argv[6] ) : 2, 1 );
+      fc::mutable_variant_object parameters;
+      if( argc > 7 )
+         parameters = fc::mutable_variant_object( fc::json::from_string( argv[7] ).get_object() );
+      if( parameters.find( "desired_number_of_connections" ) == parameters.end() )
+         parameters( "desired_number_of_connections", peers_per_node );
+
+      for( const char* name : { "default", "p2p", "sync" } )
+         fc::logger::get( name ).set_log_level( fc::log_level::warn );
+
+      // start the shared asio threads now so they are not charged to the first node
+      fc::asio::default_io_service();
+
+      fc::ecc::private_key producer_key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "p2p benchmark" ) ) );
+      uint64_t transactions_made = 0;
+
+      // the chain everyone syncs, with transactions in every block so they have a realistic size
+      std::vector< signed_block > chain;
+      chain.reserve( sync_blocks );
+      fc::time_point_sec genesis_time = fc::time_point_sec( fc::time_point::now() ) - STEEM_BLOCK_INTERVAL * ( sync_blocks + 1 );
+      for( uint32_t i = 0; i < sync_blocks; ++i )
+      {
+         std::vector< signed_transaction > transactions;
+         for( uint32_t t = 0; t < trx_per_block; ++t )
+            transactions.push_back( make_transaction( transactions_made++, chain.empty() ? block_id_type() : chain.back().id(), producer_key ) );
+         chain.push_back( make_block( chain.empty() ? nullptr : &chain.back(), genesis_time + STEEM_BLOCK_INTERVAL * ( i + 1 ),
+                                      std::move( transactions ), producer_key ) );
+      }
+      std::cout << "generated " << chain.size() << " blocks with " << trx_per_block << " transactions each" << std::endl;
+
+      std::vector< benchmark_node > nodes( num_nodes );
+      for( uint32_t i = 0; i < num_nodes; ++i )
+      {
+         benchmark_node& n = nodes[i];
+         n.delegate.reset( new benchmark_delegate( producer_key.get_public_key(), sync_blocks ) );
+         if( i == 0 )
+            for( const auto& b : chain )
+               n.delegate->append_block( b );
+
+         std::set< int > threads_before = list_thread_ids();
+         n.delegate_thread.reset( new fc::thread( "bench node " + std::to_string( i ) ) );
+         n.delegate_thread->async( [&]()
+         {
+            n.node = std::make_shared< graphene::net::node >( "p2p benchmark" );
+            n.node->load_configuration( n.config_dir.path() );
+            n.node->set_node_delegate( n.delegate.get() );
+            n.node->listen_on_endpoint( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ), false );
+            n.node->set_advanced_node_parameters( parameters );
+            n.node->listen_to_p2p_network();
+            n.node->connect_to_p2p_network();
+            n.node->sync_from( item_id( graphene::net::block_message_type, n.delegate->get_head_block_id() ), std::vector< uint32_t >() );
+            n.endpoint = n.node->get_actual_listening_endpoint();
+         }).wait();
+
+         for( int tid : list_thread_ids() )
+            if( !threads_before.count( tid ) )
+               n.thread_ids.insert( tid );
+      }
+
+      auto sample_cpu = [&]()
+      {
+         std::vector< int64_t > cpu;
+         for( const auto& n : nodes )
+            cpu.push_back( node_cpu_us( n ) );
+         cpu.push_back( process_cpu_us() );
+         return cpu;
+      };
+      auto sample_bytes = [&]()
+      {
+         std::vector< uint64_t > bytes;
+         for( const auto& n : nodes )
+            bytes.push_back( node_bytes_sent( n ) );
+         return bytes;
+      };
+      auto print_usage = [&]( const std::string& phase, const std::vector< int64_t >& cpu_before, const std::vector< uint64_t >& bytes_before, int64_t us )
+      {
+         auto cpu = sample_cpu();
+         auto bytes = sample_bytes();
+         uint64_t total_bytes = 0;
+         for( uint32_t i = 0; i < num_nodes; ++i )
+         {
+            // connections that closed during the phase take their counters with them
+            uint64_t sent = bytes[i] > bytes_before[i] ? bytes[i] - bytes_before[i] : 0;
+            total_bytes += sent;
+            std::cout << "  node " << i << ": cpu " << ( cpu[i] - cpu_before[i] ) / 1000 << " ms, sent "
+                      << sent << " bytes" << std::endl;
+         }
+         std::cout << phase << ": " << us / 1000 << " ms, process cpu " << ( cpu.back() - cpu_before.back() ) / 1000
+                   << " ms, " << total_bytes << " bytes on the wire" << std::endl;
+      };
+
+      // node i connects to random nodes started before it, so every node can reach node 0
+      std::mt19937 gen( 42 );
+      std::vector< int64_t > cpu_before = sample_cpu();
+      std::vector< uint64_t > bytes_before( num_nodes, 0 );
+      fc::time_point sync_start = fc::time_point::now();
+      for( uint32_t i = 1; i < num_nodes; ++i )
+      {
+         std::vector< uint32_t > candidates( i );
+         for( uint32_t c = 0; c < i; ++c )
+            candidates[c] = c;
+         std::shuffle( candidates.begin(), candidates.end(), gen );
+         candidates.resize( std::min( i, peers_per_node ) );
+         for( uint32_t c : candidates )
+         {
+            nodes[i].node->add_node( nodes[c].endpoint );
+            nodes[i].node->connect_to_endpoint( nodes[c].endpoint );
+         }
+      }
+
+      int errors = 0;
+
+      bool synced = wait_for( fc::seconds( 60 ) + fc::milliseconds( 50 * int64_t( sync_blocks ) ), [&]()
+      {
+         for( auto& n : nodes )
+            if( n.delegate_thread->async( [&](){ return n.delegate->head_block_num(); } ).wait() < sync_blocks )
+               return false;
+         return true;
+      });
+      int64_t sync_us = ( fc::time_point::now() - sync_start ).count();
+
+      if( !synced )
+      {
+         std::cout << "sync timed out" << std::endl;
+         ++errors;
+      }
+
+      for( uint32_t i = 1; i < num_nodes; ++i )
+      {
+         fc::time_point synced_at = nodes[i].delegate_thread->async( [&](){ return nodes[i].delegate->synced_at; } ).wait();
+         if( synced_at != fc::time_point() )
+         {
+            int64_t us = std::max< int64_t >( ( synced_at - sync_start ).count(), 1 );
+            std::cout << "  node " << i << " synced " << sync_blocks << " blocks in " << us / 1000 << " ms, "
+                      << double( sync_blocks ) * 1000000 / us << " blocks/s" << std::endl;
+         }
+      }
+      std::cout << "sync: " << double( sync_blocks ) * 1000000 / std::max< int64_t >( sync_us, 1 ) << " blocks/s to the slowest node" << std::endl;
+      print_usage( "sync", cpu_before, bytes_before, sync_us );
+
+      // live phase: node 0 broadcasts a round of transactions, then a block holding them
+      std::map< block_id_type, fc::time_point > block_sent;
+      std::map< transaction_id_type, fc::time_point > transaction_sent;
+      benchmark_node& producer = nodes[0];
+
+      cpu_before = sample_cpu();
+      bytes_before = sample_bytes();
+      fc::time_point live_start = fc::time_point::now();
+
+      for( uint32_t b = 0; b < live_blocks; ++b )
+      {
+         fc::time_point round_start = fc::time_point::now();
+         std::vector< signed_transaction > transactions;
+
+         producer.delegate_thread->async( [&]()
+         {
+            block_id_type head = producer.delegate->get_head_block_id();
+            for( uint32_t t = 0; t < trx_per_block; ++t )
+            {
+               transactions.push_back( make_transaction( transactions_made++, head, producer_key ) );
+               producer.delegate->add_transaction( transactions.back() );
+               transaction_sent[ transactions.back().id() ] = fc::time_point::now();
+               producer.node->broadcast_transaction( transactions.back() );
+            }
+         }).wait();
+
+         fc::microseconds remaining = fc::milliseconds( block_interval_ms ) - ( fc::time_point::now() - round_start );
+         if( remaining.count() > 0 )
+            fc::usleep( remaining );
+
+         producer.delegate_thread->async( [&]()
+         {
+            signed_block block = make_block( &producer.delegate->head_block(), fc::time_point::now(), std::move( transactions ), producer_key );
+            producer.delegate->append_block( block );
+            block_sent[ block.id() ] = fc::time_point::now();
+            producer.node->broadcast( block_message( block ) );
+         }).wait();
+      }
+
+      uint32_t live_head = sync_blocks + live_blocks;
+      bool propagated = wait_for( fc::seconds( 30 ), [&]()
+      {
+         for( auto& n : nodes )
+            if( n.delegate_thread->async( [&](){ return n.delegate->head_block_num(); } ).wait() < live_head )
+               return false;
+         return true;
+      });
+      int64_t live_us = ( fc::time_point::now() - live_start ).count();
+
+      if( !propagated )
+      {
+         std::cout << "live blocks did not reach every node" << std::endl;
+         ++errors;
+      }
+
+      std::vector< int64_t > block_latencies;
+      std::vector< int64_t > transaction_latencies;
+      for( uint32_t i = 1; i < num_nodes; ++i )
+      {
+         nodes[i].delegate_thread->async( [&]()
+         {
+            for( const auto& r : nodes[i].delegate->block_received )
+            {
+               auto itr = block_sent.find( r.first );
+               if( itr != block_sent.end() )
+                  block_latencies.push_back( ( r.second - itr->second ).count() );
+            }
+            for( const auto& r : nodes[i].delegate->transaction_received )
+            {
+               auto itr = transaction_sent.find( r.first );
+               if( itr != transaction_sent.end() )
+                  transaction_latencies.push_back( ( r.second - itr->second ).count() );
+            }
+         }).wait();
+      }
+
+      print_latencies( "block", block_latencies, uint64_t( live_blocks ) * ( num_nodes - 1 ) );
+      print_latencies( "transaction", transaction_latencies, transaction_sent.size() * ( num_nodes - 1 ) );
+      print_usage( "live", cpu_before, bytes_before, live_us );
+#ifndef __linux__
+      std::cout << "cpu per node is only measured on linux" << std::endl;
+#endif
+
+      for( auto& n : nodes )
+      {
+         n.delegate_thread->async( [&]()
+         {
+            n.node->close();
+            n.node.reset();
+         }).wait();
+      }
+      for( auto& n : nodes )
+         n.delegate_thread->quit();
+
+      if( errors )
+         std::cout << errors << " errors" << std::endl;
+
+      return errors ? 1 : 0;
+   }
+   catch( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+   }
+
+   return 1;
+}
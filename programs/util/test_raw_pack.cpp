@@ -0,0 +1,99 @@
+
+#include <steem/chain/block_log.hpp>
+#include <steem/protocol/block.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/time.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using steem::protocol::signed_block;
+
+/**
+ * Times fc::raw unpack, pack_size and pack over the blocks of a block_log and checks that every
+ * block packs back to the exact bytes it was read from.
+ *
+ * usage: test_raw_pack <block_log> [first block] [block count] [passes]
+ */
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      if( argc < 2 )
+      {
+         std::cout << "usage: " << argv[0] << " <block_log> [first block] [block count] [passes]" << std::endl;
+         return 1;
+      }
+
+      uint32_t first = argc > 2 ? std::atoi( argv[2] ) : 1;
+      uint32_t count = argc > 3 ? std::atoi( argv[3] ) : 100000;
+      uint32_t passes = argc > 4 ? std::atoi( argv[4] ) : 3;
+
+      steem::chain::block_log log;
+      log.open( argv[1] );
+
+      std::vector< std::vector< char > > raw_blocks;
+      raw_blocks.reserve( count );
+      uint64_t total_bytes = 0;
+
+      for( uint32_t n = first; n < first + count; ++n )
+      {
+         auto data = log.read_block_data_by_num( n );
+         if( data.empty() )
+            break;
+         total_bytes += data.size();
+         raw_blocks.push_back( std::move( data ) );
+      }
+
+      std::cout << "read " << raw_blocks.size() << " blocks, " << total_bytes << " bytes" << std::endl;
+
+      std::vector< signed_block > blocks( raw_blocks.size() );
+      int errors = 0;
+
+      for( uint32_t pass = 0; pass < passes; ++pass )
+      {
+         fc::time_point start = fc::time_point::now();
+         for( size_t i = 0; i < raw_blocks.size(); ++i )
+         {
+            blocks[i] = signed_block();
+            fc::raw::unpack_from_vector( raw_blocks[i], blocks[i] );
+         }
+         fc::time_point unpacked = fc::time_point::now();
+
+         uint64_t size = 0;
+         for( const auto& b : blocks )
+            size += fc::raw::pack_size( b );
+         fc::time_point sized = fc::time_point::now();
+
+         for( size_t i = 0; i < blocks.size(); ++i )
+         {
+            if( fc::raw::pack_to_vector( blocks[i] ) != raw_blocks[i] )
+            {
+               if( pass == 0 )
+                  std::cout << "block " << first + i << " does not pack back to its original bytes" << std::endl;
+               ++errors;
+            }
+         }
+         fc::time_point packed = fc::time_point::now();
+
+         if( size != total_bytes )
+            std::cout << "pack_size total " << size << " differs from " << total_bytes << std::endl;
+
+         std::cout << "pass " << pass << ": unpack " << ( unpacked - start ).count() << " us, pack_size "
+                   << ( sized - unpacked ).count() << " us, pack " << ( packed - sized ).count() << " us" << std::endl;
+      }
+
+      if( errors )
+         std::cout << errors << " errors" << std::endl;
+
+      return errors ? 1 : 0;
+   }
+   catch( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+   }
+
+   return 1;
+}
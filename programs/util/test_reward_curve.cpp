@@ -0,0 +1,249 @@
+
+#include <steem/chain/util/reward.hpp>
+#include <steem/chain/util/uint256.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/time.hpp>
+#include <fc/uint128.hpp>
+
+#include <boost/multiprecision/integer.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using fc::uint128_t;
+using steem::u256;
+using steem::chain::util::to256;
+using steem::chain::util::comment_reward_context;
+using steem::protocol::asset;
+using steem::protocol::price;
+
+// The reward math as implemented on fc::uint128 and u256 only, used as the reference result
+
+uint8_t reference_find_msb( const uint128_t& u )
+{
+   uint64_t x;
+   uint8_t places;
+   x      = (u.lo ? u.lo : 1);
+   places = (u.hi ?   64 : 0);
+   x      = (u.hi ? u.hi : x);
+   return uint8_t( boost::multiprecision::detail::find_msb(x) + places );
+}
+
+uint64_t reference_approx_sqrt( const uint128_t& x )
+{
+   if( (x.lo == 0) && (x.hi == 0) )
+      return 0;
+
+   uint8_t msb_x = reference_find_msb(x);
+   uint8_t msb_z = msb_x >> 1;
+
+   uint128_t msb_x_bit = uint128_t(1) << msb_x;
+   uint64_t  msb_z_bit = uint64_t (1) << msb_z;
+
+   uint128_t mantissa_mask = msb_x_bit - 1;
+   uint128_t mantissa_x = x & mantissa_mask;
+   uint64_t mantissa_z_hi = (msb_x & 1) ? msb_z_bit : 0;
+   uint64_t mantissa_z_lo = (mantissa_x >> (msb_x - msb_z)).lo;
+   uint64_t mantissa_z = (mantissa_z_hi | mantissa_z_lo) >> 1;
+   uint64_t result = msb_z_bit | mantissa_z;
+
+   return result;
+}
+
+uint128_t reference_evaluate_reward_curve( const uint128_t& rshares, const steem::protocol::curve_id& curve, const uint128_t& content_constant )
+{
+   uint128_t result = 0;
+
+   switch( curve )
+   {
+      case steem::protocol::quadratic:
+         {
+            uint128_t rshares_plus_s = rshares + content_constant;
+            result = rshares_plus_s * rshares_plus_s - content_constant * content_constant;
+         }
+         break;
+      case steem::protocol::quadratic_curation:
+         {
+            uint128_t two_alpha = content_constant * 2;
+            result = uint128_t( rshares.lo, 0 ) / ( two_alpha + rshares );
+         }
+         break;
+      case steem::protocol::linear:
+         result = rshares;
+         break;
+      case steem::protocol::square_root:
+         result = reference_approx_sqrt( rshares );
+         break;
+   }
+
+   return result;
+}
+
+uint64_t reference_get_rshare_reward( const comment_reward_context& ctx )
+{
+   u256 rf(ctx.total_reward_fund_steem.amount.value);
+   u256 total_claims = to256( ctx.total_reward_shares2 );
+
+   u256 claim = to256( reference_evaluate_reward_curve( ctx.rshares.value, ctx.reward_curve, ctx.content_constant ) );
+   claim = ( claim * ctx.reward_weight ) / STEEM_100_PERCENT;
+
+   u256 payout_u256 = ( rf * claim ) / total_claims;
+   FC_ASSERT( payout_u256 <= u256( uint64_t( std::numeric_limits<int64_t>::max() ) ) );
+   uint64_t payout = static_cast< uint64_t >( payout_u256 );
+
+   if( steem::chain::util::is_comment_payout_dust( ctx.current_steem_price, payout ) )
+      payout = 0;
+
+   asset max_steem = steem::chain::util::to_steem( ctx.current_steem_price, ctx.max_sbd );
+
+   payout = std::min( payout, uint64_t( max_steem.amount.value ) );
+
+   return payout;
+}
+
+template< typename Lambda >
+int64_t time_us( Lambda&& l )
+{
+   fc::time_point start = fc::time_point::now();
+   l();
+   return ( fc::time_point::now() - start ).count();
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   uint32_t count = argc > 1 ? std::atoi( argv[1] ) : 1000000;
+   std::mt19937_64 gen( 42 );
+   int errors = 0;
+
+   // Mix of realistic rshares and values spread over the whole 128 bit range
+   std::vector< uint128_t > values;
+   values.reserve( count );
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      uint32_t bits = gen() % 129;
+      uint128_t v( gen(), gen() );
+      if( bits == 0 )
+         v = 0;
+      else if( bits < 128 )
+         v = v >> ( 128 - bits );
+      values.push_back( v );
+   }
+
+   const steem::protocol::curve_id curves[] = { steem::protocol::quadratic, steem::protocol::quadratic_curation,
+      steem::protocol::linear, steem::protocol::square_root };
+   const char* curve_names[] = { "quadratic", "quadratic_curation", "linear", "square_root" };
+   const uint128_t content_constants[] = { STEEM_CONTENT_CONSTANT_HF0, 0 };
+
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      if( steem::chain::util::approx_sqrt( values[i] ) != reference_approx_sqrt( values[i] ) )
+      {
+         std::cout << "approx_sqrt mismatch for " << std::string( values[i] ) << std::endl;
+         ++errors;
+      }
+   }
+
+   for( size_t c = 0; c < 4; ++c )
+   {
+      for( const auto& s : content_constants )
+      {
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            uint128_t expected, actual;
+            bool expected_throw = false, actual_throw = false;
+
+            try { expected = reference_evaluate_reward_curve( values[i], curves[c], s ); }
+            catch( const std::exception& ) { expected_throw = true; }
+            try { actual = steem::chain::util::evaluate_reward_curve( values[i], curves[c], s ); }
+            catch( const std::exception& ) { actual_throw = true; }
+
+            if( expected_throw != actual_throw || ( !expected_throw && expected != actual ) )
+            {
+               std::cout << curve_names[c] << " mismatch for " << std::string( values[i] ) << std::endl;
+               ++errors;
+            }
+         }
+      }
+
+      uint128_t sink = 0;
+      int64_t reference = time_us( [&]()
+      {
+         for( uint32_t i = 0; i < count; ++i )
+            sink += reference_evaluate_reward_curve( values[i] | 1, curves[c], STEEM_CONTENT_CONSTANT_HF0 );
+      });
+      int64_t fast = time_us( [&]()
+      {
+         for( uint32_t i = 0; i < count; ++i )
+            sink += steem::chain::util::evaluate_reward_curve( values[i] | 1, curves[c], STEEM_CONTENT_CONSTANT_HF0 );
+      });
+
+      std::cout << curve_names[c] << ": reference " << reference << " us, native " << fast << " us"
+                << ( sink == 0 ? " " : "" ) << std::endl;
+   }
+
+   // Payouts with rshares, fund and recent claims in the ranges seen on chain
+   std::vector< comment_reward_context > contexts( count );
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      auto& ctx = contexts[i];
+      ctx.rshares = int64_t( gen() % ( uint64_t(1) << ( 20 + gen() % 43 ) ) ) + 1;
+      ctx.reward_weight = STEEM_100_PERCENT - gen() % 1000;
+      ctx.max_sbd = asset( 1000000000, SBD_SYMBOL );
+      ctx.total_reward_fund_steem = asset( int64_t( gen() % 1000000000000ll ), STEEM_SYMBOL );
+      ctx.current_steem_price = price( asset( 1000, SBD_SYMBOL ), asset( 1000 + gen() % 10000, STEEM_SYMBOL ) );
+      ctx.reward_curve = curves[ gen() % 4 ];
+      ctx.total_reward_shares2 = steem::chain::util::evaluate_reward_curve( ctx.rshares.value, ctx.reward_curve, ctx.content_constant )
+         * ( 1 + gen() % 100000 );
+      if( ctx.total_reward_shares2 == 0 )
+         ctx.total_reward_shares2 = 1;
+   }
+
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      uint64_t expected = 0, actual = 0;
+      bool expected_throw = false, actual_throw = false;
+
+      try { expected = reference_get_rshare_reward( contexts[i] ); }
+      catch( const fc::exception& ) { expected_throw = true; }
+      try { actual = steem::chain::util::get_rshare_reward( contexts[i] ); }
+      catch( const fc::exception& ) { actual_throw = true; }
+
+      if( expected_throw != actual_throw || expected != actual )
+      {
+         std::cout << "get_rshare_reward mismatch for " << fc::json::to_string( contexts[i] ) << std::endl;
+         ++errors;
+      }
+   }
+
+   // Drop the contexts whose payout overflows so the timed loops do not measure exceptions
+   contexts.erase( std::remove_if( contexts.begin(), contexts.end(), []( const comment_reward_context& ctx )
+   {
+      try { reference_get_rshare_reward( ctx ); }
+      catch( const fc::exception& ) { return true; }
+      return false;
+   }), contexts.end() );
+
+   uint64_t sink = 0;
+   int64_t reference = time_us( [&]()
+   {
+      for( const auto& ctx : contexts )
+         sink += reference_get_rshare_reward( ctx );
+   });
+   int64_t fast = time_us( [&]()
+   {
+      for( const auto& ctx : contexts )
+         sink += steem::chain::util::get_rshare_reward( ctx );
+   });
+
+   std::cout << "get_rshare_reward: reference " << reference << " us, native " << fast << " us"
+             << ( sink == 0 ? " " : "" ) << std::endl;
+
+   if( errors )
+      std::cout << errors << " errors" << std::endl;
+
+   return errors ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/stcp_socket.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using graphene::net::stcp_socket;
+
+/**
+ * Streams data through a pair of stcp_sockets connected over loopback and reports the throughput
+ * for each socket buffer size.  The sender writes in chunks of the message size and the receiver
+ * reads into a buffer of the same size, the way message_oriented_connection reads message bodies.
+ *
+ * usage: test_stcp_throughput [megabytes] [message size]
+ */
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint64_t megabytes = argc > 1 ? std::atoi( argv[1] ) : 256;
+      size_t message_size = argc > 2 ? std::atoi( argv[2] ) : 64 * 1024;
+      message_size = std::max< size_t >( message_size & ~size_t(15), 16 );
+      const uint64_t total = megabytes * 1024 * 1024 / message_size * message_size;
+      int errors = 0;
+
+      std::vector< char > pattern( message_size );
+      for( size_t i = 0; i < pattern.size(); ++i )
+         pattern[i] = char( i * 31 + 7 );
+
+      for( size_t buffer_size : { size_t( GRAPHENE_NET_DEFAULT_SOCKET_BUFFER_SIZE ), size_t( 16 * 1024 ),
+                                  size_t( 64 * 1024 ), size_t( 256 * 1024 ), size_t( 1024 * 1024 ) } )
+      {
+         fc::tcp_server server;
+         server.listen( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ) );
+         fc::ip::endpoint server_endpoint( fc::ip::address( "127.0.0.1" ), server.get_port() );
+
+         stcp_socket receiver;
+         stcp_socket sender;
+         receiver.set_buffer_size( buffer_size );
+         sender.set_buffer_size( buffer_size );
+
+         fc::future< void > accepted = fc::async( [&]()
+         {
+            server.accept( receiver.get_socket() );
+            receiver.accept();
+         }, "accept" );
+         sender.connect_to( server_endpoint );
+         accepted.wait();
+
+         fc::time_point start = fc::time_point::now();
+
+         fc::future< void > sent = fc::async( [&]()
+         {
+            for( uint64_t n = 0; n < total; n += message_size )
+               sender.write( pattern.data(), message_size );
+            sender.flush();
+         }, "send" );
+
+         std::vector< char > received( message_size );
+         uint64_t mismatches = 0;
+         for( uint64_t n = 0; n < total; n += message_size )
+         {
+            receiver.read( received.data(), message_size );
+            if( memcmp( received.data(), pattern.data(), message_size ) != 0 )
+               ++mismatches;
+         }
+         sent.wait();
+
+         int64_t us = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+
+         if( mismatches )
+         {
+            std::cout << "buffer " << buffer_size << ": " << mismatches << " messages decrypted wrong" << std::endl;
+            ++errors;
+         }
+
+         std::cout << "buffer " << buffer_size << ": " << total / ( 1024 * 1024 ) << " MiB in " << us << " us, "
+                   << double( total ) / us << " MB/s" << std::endl;
+
+         sender.close();
+         receiver.close();
+         server.close();
+      }
+
+      if( errors )
+         std::cout << errors << " errors" << std::endl;
+
+      return errors ? 1 : 0;
+   }
+   catch( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+   }
+
+   return 1;
+}
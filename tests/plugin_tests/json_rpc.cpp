@@ -3,8 +3,11 @@
 
 #include <steem/chain/account_object.hpp>
 #include <steem/chain/comment_object.hpp>
+#include <steem/chain/steem_objects.hpp>
 #include <steem/protocol/steem_operations.hpp>
 #include <steem/plugins/json_rpc/json_rpc_plugin.hpp>
+#include <steem/plugins/database_api/database_api_plugin.hpp>
+#include <steem/plugins/database_api/database_api.hpp>
 
 #include "../db_fixture/database_fixture.hpp"
 
@@ -312,5 +315,94 @@ BOOST_AUTO_TEST_CASE( semantics_validation )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( get_raw_blocks )
+{
+   try
+   {
+      std::string request;
+
+      generate_blocks( 3 );
+
+      request = "{\"jsonrpc\": \"2.0\", \"method\": \"block_api.get_raw_blocks\", \"params\": {\"block_num\":1, \"count\":3}, \"id\": 30}";
+      fc::variant answer = make_request( request, 0, false, false );
+      fc::variants blocks = answer[ "result" ][ "blocks" ].get_array();
+      BOOST_REQUIRE_EQUAL( blocks.size(), 3u );
+      for( uint32_t i = 0; i < blocks.size(); ++i )
+      {
+         BOOST_REQUIRE_EQUAL( blocks[i][ "block_num" ].as< uint32_t >(), i + 1 );
+         auto block = fc::raw::unpack_from_vector< signed_block >( blocks[i][ "data" ].as< std::vector< char > >() );
+         BOOST_REQUIRE( block.id() == db->fetch_block_by_number( i + 1 )->id() );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test a range past the head stops at the head" );
+      request = "{\"jsonrpc\": \"2.0\", \"method\": \"block_api.get_raw_blocks\", \"params\": {\"block_num\":" +
+         std::to_string( db->head_block_num() ) + ", \"count\":10}, \"id\": 31}";
+      answer = make_request( request, 0, false, false );
+      BOOST_REQUIRE_EQUAL( answer[ "result" ][ "blocks" ].get_array().size(), 1u );
+
+      BOOST_TEST_MESSAGE( "--- Test ranges ending past UINT32_MAX do not wrap" );
+      for( uint32_t start : { std::numeric_limits< uint32_t >::max() - 5, std::numeric_limits< uint32_t >::max() } )
+      {
+         request = "{\"jsonrpc\": \"2.0\", \"method\": \"block_api.get_raw_blocks\", \"params\": {\"block_num\":" +
+            std::to_string( start ) + ", \"count\":1000}, \"id\": 32}";
+         answer = make_request( request, 0, false, false );
+         BOOST_REQUIRE( answer[ "result" ][ "blocks" ].get_array().empty() );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( head_state_follows_pop_and_fork )
+{
+   try
+   {
+      auto& api = *appbase::app().get_plugin< steem::plugins::database_api::database_api_plugin >().api;
+
+      auto require_head_state_matches = [&]()
+      {
+         auto props = api.get_dynamic_global_properties( {} );
+         BOOST_REQUIRE( props.head_block_id == db->head_block_id() );
+         BOOST_REQUIRE_EQUAL( props.head_block_number, db->head_block_num() );
+         BOOST_REQUIRE( props.time == db->head_block_time() );
+         BOOST_REQUIRE( props.current_supply == db->get_dynamic_global_properties().current_supply );
+         BOOST_REQUIRE( api.get_feed_history( {} ).current_median_history == db->get_feed_history().current_median_history );
+      };
+
+      generate_blocks( 3 );
+      require_head_state_matches();
+
+      BOOST_TEST_MESSAGE( "--- Test pop_block" );
+      generate_block();
+      generate_block();
+      auto b1 = *db->fetch_block_by_number( db->head_block_num() - 1 );
+      auto b2 = *db->fetch_block_by_number( db->head_block_num() );
+      db->pop_block();
+      require_head_state_matches();
+      db->pop_block();
+      require_head_state_matches();
+
+      BOOST_TEST_MESSAGE( "--- Test switching back to the longer fork" );
+      generate_block( 0, init_account_priv_key, 1 );
+      BOOST_REQUIRE( db->head_block_id() != b1.id() );
+      require_head_state_matches();
+      db->push_block( b1 );
+      db->push_block( b2 );
+      BOOST_REQUIRE( db->head_block_id() == b2.id() );
+      require_head_state_matches();
+
+      BOOST_TEST_MESSAGE( "--- Test debug_update" );
+      db_plugin->debug_update( [=]( database& db )
+      {
+         db.modify( db.get_feed_history(), [&]( feed_history_object& f )
+         {
+            f.current_median_history = price( ASSET( "1.000 TBD" ), ASSET( "3.000 TESTS" ) );
+         });
+      });
+      BOOST_REQUIRE( db->get_feed_history().current_median_history == price( ASSET( "1.000 TBD" ), ASSET( "3.000 TESTS" ) ) );
+      require_head_state_matches();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
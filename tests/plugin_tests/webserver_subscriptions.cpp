@@ -0,0 +1,155 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+
+#include <steem/plugins/json_rpc/json_rpc_plugin.hpp>
+#include <steem/plugins/webserver/webserver_subscriptions.hpp>
+
+#include <fc/io/json.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using steem::plugins::webserver::webserver_subscriptions;
+
+struct webserver_subscriptions_fixture : public clean_database_fixture
+{
+   webserver_subscriptions_fixture() :
+      subscriptions( ios, [this]( steem::plugins::webserver::connection_hdl hdl, const std::string& notice )
+      {
+         received[ hdl.lock().get() ].push_back( fc::json::from_string( notice ) );
+      })
+   {
+      subscriptions.connect( *db, *db_plugin );
+   }
+
+   ~webserver_subscriptions_fixture()
+   {
+      subscriptions.disconnect();
+   }
+
+   fc::variant request( const std::shared_ptr< int >& conn, const std::string& payload )
+   {
+      auto response = subscriptions.handle_request( conn, payload );
+      BOOST_REQUIRE( response.is_initialized() );
+      return fc::json::from_string( *response );
+   }
+
+   /// Sends the notices queued so far and returns the ones conn received
+   fc::variants notices( const std::shared_ptr< int >& conn )
+   {
+      ios.poll();
+      ios.reset();
+
+      fc::variants result = std::move( received[ conn.get() ] );
+      received.erase( conn.get() );
+      return result;
+   }
+
+   boost::asio::io_service                ios;
+   webserver_subscriptions                subscriptions;
+   std::map< void*, fc::variants >        received;
+};
+
+BOOST_FIXTURE_TEST_SUITE( webserver_subscription_tests, webserver_subscriptions_fixture )
+
+BOOST_AUTO_TEST_CASE( subscribe_notice_unsubscribe )
+{
+   try
+   {
+      ACTORS( (alice)(bob) )
+      generate_block();
+
+      auto accounts = std::make_shared< int >( 0 );
+      auto blocks = std::make_shared< int >( 0 );
+
+      BOOST_TEST_MESSAGE( "--- Test other requests are left to json_rpc" );
+      BOOST_REQUIRE( !subscriptions.handle_request( accounts,
+         "{\"jsonrpc\":\"2.0\", \"method\":\"call\", \"params\":[\"database_api\", \"get_config\"], \"id\":1}" ).is_initialized() );
+      BOOST_REQUIRE( !subscriptions.handle_request( accounts, "{\"method\":\"webserver.subscribe\"" ).is_initialized() );
+
+      BOOST_TEST_MESSAGE( "--- Test subscribe" );
+      auto answer = request( accounts, "{\"jsonrpc\":\"2.0\", \"method\":\"webserver.subscribe\", \"params\":{\"accounts\":[\"alice\"]}, \"id\":2}" );
+      BOOST_REQUIRE( answer.get_object().contains( "result" ) );
+      BOOST_REQUIRE_EQUAL( answer[ "id" ].as_int64(), 2 );
+
+      answer = request( blocks, "{\"jsonrpc\":\"2.0\", \"method\":\"webserver.subscribe\", \"params\":{\"irreversible_blocks\":true}, \"id\":3}" );
+      BOOST_REQUIRE( answer.get_object().contains( "result" ) );
+
+      BOOST_TEST_MESSAGE( "--- Test too many accounts are rejected" );
+      std::string many = "[";
+      for( int i = 0; i <= STEEM_WEBSERVER_MAX_SUBSCRIBED_ACCOUNTS; ++i )
+         many += std::string( i ? "," : "" ) + "\"acct" + std::to_string( i ) + "\"";
+      many += "]";
+      auto rejected = std::make_shared< int >( 0 );
+      answer = request( rejected, "{\"jsonrpc\":\"2.0\", \"method\":\"webserver.subscribe\", \"params\":{\"accounts\":" + many + "}, \"id\":4}" );
+      BOOST_REQUIRE_EQUAL( answer[ "error" ][ "code" ].as_int64(), JSON_RPC_INVALID_PARAMS );
+
+      BOOST_TEST_MESSAGE( "--- Test operations on subscribed accounts are pushed once their block is applied" );
+      transfer( STEEM_INIT_MINER_NAME, "bob", ASSET( "1.000 TESTS" ) );
+      BOOST_REQUIRE( notices( accounts ).empty() );
+      generate_block();
+      BOOST_REQUIRE( notices( accounts ).empty() );
+
+      transfer( STEEM_INIT_MINER_NAME, "alice", ASSET( "1.000 TESTS" ) );
+      BOOST_REQUIRE( notices( accounts ).empty() );
+      generate_block();
+
+      auto sent = notices( accounts );
+      BOOST_REQUIRE_EQUAL( sent.size(), 1u );
+      BOOST_REQUIRE_EQUAL( sent[0][ "method" ].as_string(), STEEM_WEBSERVER_NOTICE_METHOD );
+      BOOST_REQUIRE_EQUAL( sent[0][ "params" ][ "type" ].as_string(), "operation" );
+      BOOST_REQUIRE_EQUAL( sent[0][ "params" ][ "data" ][ "block" ].as< uint32_t >(), db->head_block_num() );
+      BOOST_REQUIRE( sent[0][ "params" ][ "data" ][ "block_id" ].as< block_id_type >() == db->head_block_id() );
+
+      BOOST_TEST_MESSAGE( "--- Test popping the block sends block_undone" );
+      auto popped_id = db->head_block_id();
+      auto popped_num = db->head_block_num();
+      notices( blocks );
+      db->pop_block();
+
+      sent = notices( accounts );
+      BOOST_REQUIRE_EQUAL( sent.size(), 1u );
+      BOOST_REQUIRE_EQUAL( sent[0][ "params" ][ "type" ].as_string(), "block_undone" );
+      BOOST_REQUIRE_EQUAL( sent[0][ "params" ][ "data" ][ "block_num" ].as< uint32_t >(), popped_num );
+      BOOST_REQUIRE( sent[0][ "params" ][ "data" ][ "block_id" ].as< block_id_type >() == popped_id );
+      BOOST_REQUIRE( notices( blocks ).empty() );
+
+      BOOST_TEST_MESSAGE( "--- Test irreversible blocks are pushed" );
+      uint32_t block_num = db->head_block_num();
+      for( uint32_t i = 0; i < 100 && db->get_dynamic_global_properties().last_irreversible_block_num < block_num; ++i )
+         generate_block();
+      BOOST_REQUIRE( db->get_dynamic_global_properties().last_irreversible_block_num >= block_num );
+
+      bool found = false;
+      for( const auto& n : notices( blocks ) )
+      {
+         BOOST_REQUIRE_EQUAL( n[ "params" ][ "type" ].as_string(), "irreversible_block" );
+         if( n[ "params" ][ "data" ][ "block_num" ].as< uint32_t >() == block_num )
+         {
+            BOOST_REQUIRE( n[ "params" ][ "data" ][ "block_id" ].as< block_id_type >() == db->get_block_id_for_num( block_num ) );
+            found = true;
+         }
+      }
+      BOOST_REQUIRE( found );
+
+      BOOST_TEST_MESSAGE( "--- Test unsubscribe" );
+      notices( accounts );
+      answer = request( accounts, "{\"jsonrpc\":\"2.0\", \"method\":\"webserver.unsubscribe\", \"id\":5}" );
+      BOOST_REQUIRE( answer.get_object().contains( "result" ) );
+
+      transfer( STEEM_INIT_MINER_NAME, "alice", ASSET( "1.000 TESTS" ) );
+      generate_block();
+      BOOST_REQUIRE( notices( accounts ).empty() );
+
+      subscriptions.remove( blocks );
+      generate_blocks( STEEM_MAX_WITNESSES );
+      BOOST_REQUIRE( notices( blocks ).empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -25,6 +25,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <steem/chain/database.hpp>
+#include <steem/chain/util/monotonic_arena.hpp>
 #include <steem/protocol/protocol.hpp>
 
 #include <steem/protocol/steem_operations.hpp>
@@ -324,4 +325,41 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( monotonic_arena_test )
+{
+   steem::chain::util::monotonic_arena arena( 1024 );
+
+   void* a = arena.allocate( 3, 1 );
+   void* b = arena.allocate( 8, 8 );
+   BOOST_CHECK( a != nullptr );
+   BOOST_CHECK_EQUAL( uintptr_t( b ) % 8, 0u );
+   BOOST_CHECK_EQUAL( arena.allocations(), 2u );
+   BOOST_CHECK_EQUAL( arena.heap_blocks(), 1u );
+
+   // Larger than the initial block, forces a second block
+   {
+      steem::chain::util::arena_vector< uint64_t > v( arena );
+      for( uint64_t i = 0; i < 1000; ++i )
+         v.push_back( i );
+
+      for( uint64_t i = 0; i < 1000; ++i )
+         BOOST_REQUIRE_EQUAL( v[i], i );
+   }
+   BOOST_CHECK( arena.heap_blocks() > 1 );
+
+   arena.reset();
+   BOOST_CHECK_EQUAL( arena.allocated_bytes(), 0u );
+   BOOST_CHECK_EQUAL( arena.allocations(), 0u );
+   BOOST_CHECK_EQUAL( arena.heap_blocks(), 1u );
+
+   // The kept block holds the whole vector now
+   {
+      steem::chain::util::arena_vector< uint64_t > v( arena );
+      v.reserve( 1000 );
+      for( uint64_t i = 0; i < 1000; ++i )
+         v.push_back( i );
+   }
+   BOOST_CHECK_EQUAL( arena.heap_blocks(), 1u );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -27,8 +27,10 @@
 #include <steem/protocol/exceptions.hpp>
 
 #include <steem/chain/database.hpp>
+#include <steem/chain/database_exceptions.hpp>
 #include <steem/chain/steem_objects.hpp>
 #include <steem/chain/history_object.hpp>
+#include <steem/chain/transaction_prevalidator.hpp>
 
 #include <steem/plugins/account_history/account_history_plugin.hpp>
 
@@ -46,16 +48,50 @@ using namespace steem::protocol;
 
 BOOST_AUTO_TEST_SUITE(block_tests)
 
-void open_test_database( database& db, const fc::path& dir )
+void open_test_database( database& db, const fc::path& dir, uint32_t parallel_validation_threads = 0, bool enable_state_digest = false )
 {
    database::open_args args;
    args.data_dir = dir;
    args.shared_mem_dir = dir;
    args.initial_supply = INITIAL_TEST_SUPPLY;
    args.shared_file_size = TEST_SHARED_MEM_SIZE;
+   args.parallel_validation_threads = parallel_validation_threads;
+   args.enable_state_digest = enable_state_digest;
    db.open( args );
 }
 
+/// Fills the operation and account history indices for the operations in a block the way the account history plugin does
+void add_test_history( database& db, const signed_block& b )
+{
+   for( const auto& trx : b.transactions )
+   {
+      for( const auto& op : trx.operations )
+      {
+         const auto& op_obj = db.create< operation_object >( [&]( operation_object& obj )
+         {
+            obj.trx_id    = trx.id();
+            obj.block     = b.block_num();
+            obj.timestamp = b.timestamp;
+            auto size = fc::raw::pack_size( op );
+            obj.serialized_op.resize( size );
+            fc::datastream< char* > ds( obj.serialized_op.data(), size );
+            fc::raw::pack( ds, op );
+         });
+
+         db.create< account_history_object >( [&]( account_history_object& ahist )
+         {
+            ahist.account       = STEEM_INIT_MINER_NAME;
+            ahist.sequence      = db.get_index< account_history_index >().indices().size() + 1;
+            ahist.op            = op_obj.id;
+            ahist.trx_id        = op_obj.trx_id;
+            ahist.block         = op_obj.block;
+            ahist.timestamp     = op_obj.timestamp;
+            ahist.serialized_op = op_obj.serialized_op;
+         });
+      }
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -354,6 +390,295 @@ BOOST_AUTO_TEST_CASE( duplicate_transactions )
    }
 }
 
+BOOST_AUTO_TEST_CASE( state_digest )
+{
+   try {
+      fc::temp_directory dir1( steem::utilities::temp_directory_path() ),
+                         dir2( steem::utilities::temp_directory_path() ),
+                         dir3( steem::utilities::temp_directory_path() );
+      database db1,
+               db2,
+               db3;
+      db1._log_hardforks = false;
+      open_test_database( db1, dir1.path(), 0, true );
+      db2._log_hardforks = false;
+      open_test_database( db2, dir2.path(), 0, true );
+      db3._log_hardforks = false;
+      open_test_database( db3, dir3.path() );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      public_key_type init_account_pub_key  = init_account_priv_key.get_public_key();
+      std::vector< fc::sha256 > digests;
+
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i == 2 )
+         {
+            signed_transaction trx;
+            account_create_operation cop;
+            cop.new_account_name = "alice";
+            cop.creator = STEEM_INIT_MINER_NAME;
+            cop.owner = authority(1, init_account_pub_key, 1);
+            cop.active = cop.owner;
+            trx.operations.push_back(cop);
+            trx.set_expiration( db1.head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+            trx.sign( init_account_priv_key, db1.get_chain_id() );
+            PUSH_TX( db1, trx );
+         }
+
+         auto b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, database::skip_nothing );
+         PUSH_BLOCK( db2, b );
+         PUSH_BLOCK( db3, b );
+         // db2 keeps operation history as if it ran the account history plugin
+         add_test_history( db2, b );
+
+         auto d1 = db1.get_state_digest();
+         auto d2 = db2.get_state_digest();
+         BOOST_REQUIRE( d1.valid );
+         BOOST_REQUIRE( d2.valid );
+         BOOST_REQUIRE_EQUAL( d1.head_block_num, b.block_num() );
+         BOOST_REQUIRE( d1.digest == d2.digest );
+         BOOST_REQUIRE( digests.empty() || d1.digest != digests.back() );
+         digests.push_back( d1.digest );
+      }
+
+      // The history indices differ between db1 and db2 but are left out of the combined digest
+      BOOST_REQUIRE( db1.get_index< account_history_index >().indices().empty() );
+      BOOST_REQUIRE( !db2.get_index< account_history_index >().indices().empty() );
+      for( const auto& d : db2.get_state_digest().indices )
+      {
+         if( d.type_id == operation_object_type || d.type_id == account_history_object_type )
+            BOOST_REQUIRE( d.objects > 0 );
+      }
+
+      // Without digests enabled the indices changed since genesis are reported invalid
+      BOOST_REQUIRE( !db3.get_state_digest().valid );
+
+      // The incremental digests match a digest built from scratch
+      for( chainbase::abstract_index* idx : db1.get_abstract_index_cntr() )
+         idx->rebuild_digest();
+      BOOST_REQUIRE( db1.get_state_digest().digest == digests.back() );
+
+      // Undoing blocks restores the digest of the earlier state
+      db1.pop_block();
+      BOOST_REQUIRE( db1.get_state_digest().digest == digests[ digests.size() - 2 ] );
+      db1.pop_block();
+      db1.pop_block();
+      BOOST_REQUIRE( db1.get_state_digest().digest == digests[ digests.size() - 4 ] );
+      BOOST_REQUIRE( db1.find_account( "alice" ) == nullptr );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( parallel_validation )
+{
+   try {
+      fc::temp_directory dir1( steem::utilities::temp_directory_path() ),
+                         dir2( steem::utilities::temp_directory_path() ),
+                         dir3( steem::utilities::temp_directory_path() );
+      database db1,
+               db2,
+               db3;
+      db1._log_hardforks = false;
+      open_test_database( db1, dir1.path() );
+      db2._log_hardforks = false;
+      open_test_database( db2, dir2.path(), 4, true );
+      db3._log_hardforks = false;
+      open_test_database( db3, dir3.path(), 0, true );
+      BOOST_REQUIRE( db2.get_transaction_prevalidator() != nullptr );
+      BOOST_REQUIRE( db3.get_transaction_prevalidator() == nullptr );
+
+      // db1 produces the blocks, db2 applies them on 4 threads and db3 replays them serially
+      auto push_and_compare = [&]( const signed_block& b )
+      {
+         PUSH_BLOCK( db2, b );
+         PUSH_BLOCK( db3, b );
+         auto parallel = db2.get_state_digest();
+         auto serial = db3.get_state_digest();
+         BOOST_REQUIRE( parallel.valid );
+         BOOST_REQUIRE( serial.valid );
+         BOOST_REQUIRE_EQUAL( parallel.head_block_num, b.block_num() );
+         BOOST_REQUIRE_EQUAL( serial.head_block_num, b.block_num() );
+         BOOST_REQUIRE( parallel.digest == serial.digest );
+      };
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      public_key_type init_account_pub_key  = init_account_priv_key.get_public_key();
+      const std::vector< string > names = { "alice", "bob", "charlie", "dave", "eve", "frank" };
+
+      for( const auto& name : names )
+      {
+         signed_transaction trx;
+         account_create_operation cop;
+         cop.new_account_name = name;
+         cop.creator = STEEM_INIT_MINER_NAME;
+         cop.owner = authority(1, init_account_pub_key, 1);
+         cop.active = cop.owner;
+         trx.operations.push_back(cop);
+         trx.set_expiration( db1.head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+         trx.sign( init_account_priv_key, db1.get_chain_id() );
+         PUSH_TX( db1, trx );
+      }
+
+      auto b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, database::skip_nothing );
+      push_and_compare( b );
+
+      for( uint32_t round = 0; round < 3; ++round )
+      {
+         for( size_t i = 0; i < names.size(); ++i )
+         {
+            signed_transaction trx;
+            transfer_operation t;
+            // Funding all shares the init miner, round 1 chains through all accounts, round 2 pairs them up
+            t.from = round == 0 ? STEEM_INIT_MINER_NAME : names[i];
+            t.to = round == 0 ? names[i] : round == 1 ? names[ ( i + 1 ) % names.size() ] : names[ i ^ 1 ];
+            t.amount = asset( 1000 - round * 100 - i, STEEM_SYMBOL );
+            trx.operations.push_back(t);
+            trx.set_expiration( db1.head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+            trx.sign( init_account_priv_key, db1.get_chain_id() );
+            PUSH_TX( db1, trx );
+         }
+
+         b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, database::skip_nothing );
+
+         if( round == 1 )
+         {
+            // A block with an invalid transaction fails the same way as in serial validation
+            signed_block bad_block = b;
+            bad_block.transactions.emplace_back( signed_transaction() );
+            bad_block.transactions.back().operations.emplace_back( transfer_operation() );
+            bad_block.transaction_merkle_root = bad_block.calculate_merkle_root();
+            bad_block.sign( init_account_priv_key );
+            STEEM_CHECK_THROW( PUSH_BLOCK( db2, bad_block ), fc::exception );
+            STEEM_CHECK_THROW( PUSH_BLOCK( db3, bad_block ), fc::exception );
+            BOOST_REQUIRE_EQUAL( db2.head_block_num(), b.block_num() - 1 );
+            BOOST_REQUIRE( db2.get_state_digest().digest == db3.get_state_digest().digest );
+         }
+
+         push_and_compare( b );
+      }
+
+      const auto& stats = db2.get_transaction_prevalidator()->get_stats();
+      BOOST_CHECK_EQUAL( stats.blocks, 5u );
+      BOOST_CHECK_EQUAL( stats.transactions, 5 * names.size() + 1 );
+      BOOST_CHECK_EQUAL( stats.failed, 1u );
+      BOOST_CHECK_EQUAL( stats.independent_groups, 1u + 1u + 2u + 1u + names.size() / 2 );
+      BOOST_CHECK_EQUAL( stats.largest_group, names.size() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( precheck_block_signees )
+{
+   try {
+      fc::temp_directory dir1( steem::utilities::temp_directory_path() ),
+                         dir2( steem::utilities::temp_directory_path() );
+      database db1,
+               db2;
+      db1._log_hardforks = false;
+      open_test_database( db1, dir1.path() );
+      db2._log_hardforks = false;
+      open_test_database( db2, dir2.path(), 4 );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      auto other_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("other_key")) );
+
+      std::vector< signed_block > blocks;
+      for( uint32_t i = 0; i < 5; ++i )
+         blocks.push_back( db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, database::skip_nothing ) );
+
+      // A block signed with the wrong key is still rejected when its key was recovered ahead of time
+      signed_block bad_block = blocks[0];
+      bad_block.sign( other_priv_key );
+
+      {
+         // The keys are recovered in the background from copies, the blocks may go away right after the call
+         std::vector< signed_block > copies = blocks;
+         std::vector< const signed_block* > to_precheck = { &bad_block };
+         for( const auto& b : copies )
+            to_precheck.push_back( &b );
+         db2.precheck_block_signees( to_precheck );
+      }
+      while( db2.get_transaction_prevalidator()->has_posted_tasks() )
+         std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+      STEEM_CHECK_THROW( PUSH_BLOCK( db2, bad_block ), fc::exception );
+      BOOST_REQUIRE_EQUAL( db2.head_block_num(), 0u );
+
+      for( const auto& b : blocks )
+         PUSH_BLOCK( db2, b );
+      BOOST_REQUIRE( db1.head_block_id() == db2.head_block_id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( push_blocks_bad_block_mid_run )
+{
+   try {
+      fc::temp_directory dir1( steem::utilities::temp_directory_path() ),
+                         dir2( steem::utilities::temp_directory_path() );
+      database db1,
+               db2;
+      db1._log_hardforks = false;
+      open_test_database( db1, dir1.path() );
+      db2._log_hardforks = false;
+      open_test_database( db2, dir2.path() );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      auto other_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("other_key")) );
+
+      std::vector< signed_block > blocks;
+      for( uint32_t i = 0; i < 5; ++i )
+         blocks.push_back( db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, database::skip_nothing ) );
+
+      // The third block of the run is signed by the wrong key, the blocks after it build on the good one
+      blocks[2].sign( other_priv_key );
+
+      std::vector< const signed_block* > run;
+      for( const auto& b : blocks )
+         run.push_back( &b );
+
+      std::vector< fc::optional< fc::exception > > results( run.size() );
+      BOOST_REQUIRE( !db2.push_blocks( run, results ) );
+      BOOST_REQUIRE_EQUAL( results.size(), run.size() );
+
+      BOOST_TEST_MESSAGE( "--- Test the blocks before the bad one are applied" );
+      BOOST_REQUIRE( !results[0] );
+      BOOST_REQUIRE( !results[1] );
+      BOOST_REQUIRE( db2.head_block_id() == blocks[1].id() );
+
+      BOOST_TEST_MESSAGE( "--- Test the bad block carries its own failure" );
+      BOOST_REQUIRE( results[2] );
+      BOOST_REQUIRE( results[2]->code() != unlinkable_block_exception::code_value );
+
+      BOOST_TEST_MESSAGE( "--- Test the blocks after it fail to link instead of being applied" );
+      BOOST_REQUIRE( results[3] );
+      BOOST_REQUIRE_EQUAL( results[3]->code(), unlinkable_block_exception::code_value );
+      BOOST_REQUIRE( results[4] );
+      BOOST_REQUIRE_EQUAL( results[4]->code(), unlinkable_block_exception::code_value );
+      BOOST_REQUIRE_EQUAL( db2.head_block_num(), 2u );
+
+      BOOST_TEST_MESSAGE( "--- Test entries that already failed are not pushed" );
+      blocks[2].sign( init_account_priv_key );
+      results.assign( run.size(), fc::optional< fc::exception >() );
+      results[0] = fc::exception();
+      results[1] = fc::exception();
+      BOOST_REQUIRE( !db2.push_blocks( run, results ) );
+      for( size_t i = 2; i < results.size(); ++i )
+         BOOST_REQUIRE( !results[i] );
+      BOOST_REQUIRE( db1.head_block_id() == db2.head_block_id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( tapos )
 {
    try {
@@ -478,6 +803,55 @@ BOOST_FIXTURE_TEST_CASE( optional_tapos, clean_database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( precheck_transaction, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      generate_block();
+      transfer( STEEM_INIT_MINER_NAME, "alice", asset( 1000000, STEEM_SYMBOL ) );
+      generate_block();
+
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( 1000, STEEM_SYMBOL );
+      signed_transaction tx;
+      tx.operations.push_back( op );
+      tx.set_reference_block( db->head_block_id() );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( alice_private_key, db->get_chain_id() );
+
+      BOOST_TEST_MESSAGE( "A valid transaction passes and is pushed with its recovered keys" );
+      pending_transaction ptrx( tx );
+      db->precheck_transaction( ptrx );
+      BOOST_REQUIRE( ptrx.get_signature_keys( db->get_chain_id() ).count( alice_private_key.get_public_key() ) );
+      db->push_transaction( ptrx );
+      BOOST_REQUIRE( db->get_account( "bob" ).balance == asset( 1000, STEEM_SYMBOL ) );
+
+      BOOST_TEST_MESSAGE( "Duplicate" );
+      STEEM_REQUIRE_THROW( db->precheck_transaction( pending_transaction( tx ) ), fc::exception );
+
+      BOOST_TEST_MESSAGE( "Bad TaPoS" );
+      tx.ref_block_prefix ^= 1;
+      tx.signatures.clear();
+      tx.sign( alice_private_key, db->get_chain_id() );
+      STEEM_REQUIRE_THROW( db->precheck_transaction( pending_transaction( tx ) ), transaction_tapos_exception );
+
+      BOOST_TEST_MESSAGE( "Expired and too far in the future" );
+      tx.set_reference_block( db->head_block_id() );
+      tx.set_expiration( db->head_block_time() - 1 );
+      tx.signatures.clear();
+      tx.sign( alice_private_key, db->get_chain_id() );
+      STEEM_REQUIRE_THROW( db->precheck_transaction( pending_transaction( tx ) ), transaction_expiration_exception );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION + 1 );
+      tx.signatures.clear();
+      tx.sign( alice_private_key, db->get_chain_id() );
+      STEEM_REQUIRE_THROW( db->precheck_transaction( pending_transaction( tx ) ), transaction_expiration_exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_FIXTURE_TEST_CASE( double_sign_check, clean_database_fixture )
 { try {
    generate_block();
@@ -790,6 +1164,8 @@ BOOST_FIXTURE_TEST_CASE( hardfork_test, database_fixture )
       BOOST_REQUIRE( db->has_hardfork( STEEM_HARDFORK_0_1 ) );
       BOOST_REQUIRE( get_last_operations( 1 )[0].get< custom_operation >().data == vector< char >( op_msg.begin(), op_msg.end() ) );
       BOOST_REQUIRE( db->get(itr->op).timestamp == db->head_block_time() );
+      BOOST_REQUIRE( itr->timestamp == db->head_block_time() );
+      BOOST_REQUIRE( itr->serialized_op == db->get(itr->op).serialized_op );
 
       BOOST_TEST_MESSAGE( "Testing hardfork is only applied once" );
       generate_block();
@@ -860,5 +1236,177 @@ BOOST_FIXTURE_TEST_CASE( generate_block_size, clean_database_fixture )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_FIXTURE_TEST_CASE( pending_transaction_cache, clean_database_fixture )
+{
+   try
+   {
+      signed_transaction tx;
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+
+      transfer_operation op;
+      op.from = STEEM_INIT_MINER_NAME;
+      op.to = STEEM_TEMP_ACCOUNT;
+      op.amount = asset( 1000, STEEM_SYMBOL );
+      tx.operations.push_back( op );
+      sign( tx, init_account_priv_key );
+      db->push_transaction( tx, 0 );
+
+      signed_transaction tx2 = tx;
+      tx2.clear();
+      op.memo = "second";
+      tx2.operations.push_back( op );
+      sign( tx2, init_account_priv_key );
+      db->push_transaction( tx2, 0 );
+
+      BOOST_TEST_MESSAGE( "--- Test pending transactions cache id and size in push order" );
+      BOOST_REQUIRE( db->_pending_tx.size() == 2 );
+      BOOST_REQUIRE( db->_pending_tx.begin()->id == tx.id() );
+      BOOST_REQUIRE( db->_pending_tx.begin()->packed_size == fc::raw::pack_size( tx ) );
+      BOOST_REQUIRE( db->_pending_tx.rbegin()->id == tx2.id() );
+      BOOST_REQUIRE( db->_pending_tx.get< by_trx_id >().count( tx2.id() ) == 1 );
+      BOOST_REQUIRE( db->_pending_tx.begin()->get_signature_keys( db->get_chain_id() ) == tx.get_signature_keys( db->get_chain_id() ) );
+
+      generate_block();
+      BOOST_REQUIRE( db->_pending_tx.size() == 0 );
+      BOOST_REQUIRE( db->fetch_block_by_number( db->head_block_num() )->transactions.size() == 2 );
+
+      BOOST_TEST_MESSAGE( "--- Test popped transactions are restored to the pending state" );
+      db->pop_block();
+      generate_block();
+      BOOST_REQUIRE( db->_pending_tx.size() == 2 );
+      BOOST_REQUIRE( db->_pending_tx.begin()->id == tx.id() );
+      BOOST_REQUIRE( db->_pending_tx.rbegin()->id == tx2.id() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( generate_block_from_pending_state, clean_database_fixture )
+{
+   try
+   {
+      transfer_operation op;
+      op.from = STEEM_INIT_MINER_NAME;
+      op.to = STEEM_TEMP_ACCOUNT;
+      op.amount = asset( 1000, STEEM_SYMBOL );
+
+      auto make_tx = [&]( const std::string& memo, uint32_t expires_in, bool signed_tx )
+      {
+         signed_transaction tx;
+         tx.set_expiration( db->head_block_time() + expires_in );
+         op.memo = memo;
+         tx.operations.push_back( op );
+         if( signed_tx )
+            sign( tx, init_account_priv_key );
+         return tx;
+      };
+
+      BOOST_TEST_MESSAGE( "--- Test the pending state becomes the block when every transaction fits" );
+      auto tx1 = make_tx( "1", STEEM_MAX_TIME_UNTIL_EXPIRATION, true );
+      auto tx2 = make_tx( "2", STEEM_MAX_TIME_UNTIL_EXPIRATION, true );
+      db->push_transaction( tx1, 0 );
+      db->push_transaction( tx2, 0 );
+      BOOST_REQUIRE_EQUAL( db->_pending_tx_size, fc::raw::pack_size( tx1 ) + fc::raw::pack_size( tx2 ) );
+      BOOST_REQUIRE_EQUAL( db->_pending_tx_skip, 0u );
+
+      generate_block();
+      auto block = db->fetch_block_by_number( db->head_block_num() );
+      BOOST_REQUIRE_EQUAL( block->transactions.size(), 2u );
+      BOOST_REQUIRE( block->transactions[0].id() == tx1.id() );
+      BOOST_REQUIRE( block->transactions[1].id() == tx2.id() );
+      BOOST_REQUIRE( db->_pending_tx.empty() );
+      BOOST_REQUIRE_EQUAL( db->_pending_tx_size, 0u );
+
+      BOOST_TEST_MESSAGE( "--- Test transactions pushed with weaker checks are replayed with the slot's checks" );
+      auto tx3 = make_tx( "3", STEEM_MAX_TIME_UNTIL_EXPIRATION, true );
+      auto tx4 = make_tx( "4", STEEM_MAX_TIME_UNTIL_EXPIRATION, false );
+      db->push_transaction( tx3, 0 );
+      db->push_transaction( tx4, database::skip_transaction_signatures );
+      BOOST_REQUIRE( db->_pending_tx_skip & database::skip_transaction_signatures );
+
+      generate_block();
+      block = db->fetch_block_by_number( db->head_block_num() );
+      BOOST_REQUIRE_EQUAL( block->transactions.size(), 1u );
+      BOOST_REQUIRE( block->transactions[0].id() == tx3.id() );
+      BOOST_REQUIRE( db->_pending_tx.empty() );
+      BOOST_REQUIRE_EQUAL( db->_pending_tx_skip, 0u );
+
+      BOOST_TEST_MESSAGE( "--- Test transactions expiring before the slot are left out" );
+      auto tx5 = make_tx( "5", STEEM_BLOCK_INTERVAL, true );
+      auto tx6 = make_tx( "6", STEEM_MAX_TIME_UNTIL_EXPIRATION, true );
+      db->push_transaction( tx5, 0 );
+      db->push_transaction( tx6, 0 );
+
+      generate_block( 0, init_account_priv_key, 1 );
+      block = db->fetch_block_by_number( db->head_block_num() );
+      BOOST_REQUIRE_EQUAL( block->transactions.size(), 1u );
+      BOOST_REQUIRE( block->transactions[0].id() == tx6.id() );
+      BOOST_REQUIRE( db->_pending_tx.empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( fetch_transaction_by_location, clean_database_fixture )
+{
+   try
+   {
+      signed_transaction tx;
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+
+      transfer_operation op;
+      op.from = STEEM_INIT_MINER_NAME;
+      op.to = STEEM_TEMP_ACCOUNT;
+      op.amount = asset( 1000, STEEM_SYMBOL );
+      tx.operations.push_back( op );
+      sign( tx, init_account_priv_key );
+      db->push_transaction( tx, 0 );
+
+      tx.clear();
+      op.memo = "second";
+      tx.operations.push_back( op );
+      sign( tx, init_account_priv_key );
+      db->push_transaction( tx, 0 );
+
+      generate_block();
+
+      uint32_t block_num = db->head_block_num();
+      auto block = db->fetch_block_by_number( block_num );
+      BOOST_REQUIRE( block.valid() );
+      BOOST_REQUIRE( block->transactions.size() == 2 );
+
+      uint32_t offset = fc::raw::pack_size( static_cast< const signed_block_header& >( *block ) )
+         + fc::raw::pack_size( fc::unsigned_int( block->transactions.size() ) )
+         + fc::raw::pack_size( block->transactions[0] );
+      uint32_t size = fc::raw::pack_size( block->transactions[1] );
+
+      BOOST_TEST_MESSAGE( "--- Test reversible block is read from the fork database" );
+      auto trx = db->fetch_transaction_by_location( block_num, 1, offset, size );
+      BOOST_REQUIRE( trx.valid() );
+      BOOST_REQUIRE( trx->id() == block->transactions[1].id() );
+
+      for( uint32_t i = 0; i < 100 && db->get_dynamic_global_properties().last_irreversible_block_num < block_num; ++i )
+         generate_block();
+
+      BOOST_REQUIRE( db->get_dynamic_global_properties().last_irreversible_block_num >= block_num );
+      generate_blocks( STEEM_MAX_WITNESSES );
+
+      BOOST_TEST_MESSAGE( "--- Test irreversible block is sliced from the block log" );
+      trx = db->fetch_transaction_by_location( block_num, 1, offset, size );
+      BOOST_REQUIRE( trx.valid() );
+      BOOST_REQUIRE( trx->id() == block->transactions[1].id() );
+
+      BOOST_TEST_MESSAGE( "--- Test raw block data round trips" );
+      auto data = db->fetch_block_data_by_number( block_num );
+      BOOST_REQUIRE( data.size() == fc::raw::pack_size( *block ) );
+      BOOST_REQUIRE( fc::raw::unpack_from_vector< signed_block >( data ).id() == block->id() );
+      BOOST_REQUIRE( db->fetch_block_data_by_number( db->head_block_num() + 1 ).empty() );
+
+      BOOST_TEST_MESSAGE( "--- Test unknown location falls back to unpacking the block" );
+      trx = db->fetch_transaction_by_location( block_num, 0 );
+      BOOST_REQUIRE( trx.valid() );
+      BOOST_REQUIRE( trx->id() == block->transactions[0].id() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
@@ -0,0 +1,834 @@
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/inventory_filter.hpp>
+#include <graphene/net/message.hpp>
+#include <graphene/net/peer_connection.hpp>
+#include <graphene/net/peer_database.hpp>
+#include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/token_bucket.hpp>
+
+#include <steem/protocol/block.hpp>
+#include <steem/protocol/steem_operations.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include <fc/crypto/aes.hpp>
+#include <fc/crypto/city.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <fstream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace graphene::net;
+using namespace steem::protocol;
+
+namespace {
+
+/** A client stcp_socket connected over loopback to one accepted by a local server */
+struct stcp_socket_pair
+{
+   stcp_socket_pair()
+   {
+      server.listen( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ) );
+      fc::future< void > accepted = fc::async( [this]()
+      {
+         server.accept( receiver.get_socket() );
+         receiver.accept();
+      }, "stcp_socket_pair accept" );
+      sender.connect_to( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), server.get_port() ) );
+      accepted.wait();
+   }
+
+   ~stcp_socket_pair()
+   {
+      sender.close();
+      receiver.close();
+   }
+
+   /** Reads the next len bytes exactly as they were sent, bypassing the receiver's decryption */
+   std::vector< char > read_ciphertext( size_t len )
+   {
+      std::vector< char > result( len );
+      receiver.get_socket().read( result.data(), len );
+      return result;
+   }
+
+   /** An encoder in the state the sender's send stream starts in after the key exchange */
+   void init_sender_encoder( fc::aes_encoder& encoder )
+   {
+      fc::sha512 secret = sender.get_shared_secret();
+      encoder.init( fc::sha256::hash( (char*)&secret, sizeof( secret ) ),
+                    fc::city_hash_crc_128( (char*)&secret, sizeof( secret ) ) );
+   }
+
+   fc::tcp_server server;
+   stcp_socket    sender;
+   stcp_socket    receiver;
+};
+
+std::vector< char > random_bytes( size_t len, uint32_t seed )
+{
+   std::mt19937 gen( seed );
+   std::vector< char > result( len );
+   for( auto& c : result )
+      c = char( gen() );
+   return result;
+}
+
+item_id make_item( uint32_t type, uint32_t n )
+{
+   return item_id( type, fc::ripemd160::hash( std::to_string( n ) ) );
+}
+
+/** A signed block holding count distinct transfers */
+signed_block make_block( uint32_t count, uint32_t seed = 0 )
+{
+   fc::ecc::private_key key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "p2p_tests" ) ) );
+
+   signed_block block;
+   block.timestamp = fc::time_point_sec( 1500000000 + seed * 3 );
+   block.witness = "initminer";
+
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( 1000 + seed * count + i, STEEM_SYMBOL );
+
+      signed_transaction trx;
+      trx.operations.push_back( op );
+      trx.set_expiration( block.timestamp + 60 );
+      trx.sign( key, chain_id_type() );
+      block.transactions.push_back( trx );
+   }
+
+   block.transaction_merkle_root = block.calculate_merkle_root();
+   block.sign( key );
+   return block;
+}
+
+/** A peer record that differs from the others in every field the tests look at */
+potential_peer_record make_peer_record( uint32_t n )
+{
+   potential_peer_record record( fc::ip::endpoint( fc::ip::address( 0x0a000000 + n ), 2001 ), fc::time_point_sec( 1500000000 + n ) );
+   record.number_of_successful_connection_attempts = n;
+   return record;
+}
+
+/** Looks transactions up by short id the way the node does in its message cache */
+struct short_id_lookup
+{
+   void add( const signed_transaction& trx )
+   {
+      transactions.emplace( get_short_transaction_id( trx.id() ), trx );
+   }
+
+   peer_connection::partially_received_block::transaction_lookup_type function() const
+   {
+      return [this]( short_transaction_id_type short_id ) -> fc::optional< signed_transaction >
+      {
+         auto itr = transactions.find( short_id );
+         if( itr == transactions.end() )
+            return fc::optional< signed_transaction >();
+         return itr->second;
+      };
+   }
+
+   std::map< short_transaction_id_type, signed_transaction > transactions;
+};
+
+/** Sends m the way message_oriented_connection::send_message() pads and writes it */
+void send_message( stcp_socket& sock, const message& m )
+{
+   size_t size_with_padding = 16 * ( ( sizeof( message_header ) + m.size + 15 ) / 16 );
+   std::vector< char > padded( size_with_padding );
+   memcpy( padded.data(), (const char*)&static_cast< const message_header& >( m ), sizeof( message_header ) );
+   memcpy( padded.data() + sizeof( message_header ), m.data.data(), m.size );
+   sock.write( padded.data(), padded.size() );
+}
+
+/**
+ * Receives a message the way message_oriented_connection's read loop does, decrypting the body
+ * either as it is read or afterwards from read_encrypted(), as the decode thread does.
+ */
+received_message receive_message( stcp_socket& sock, bool decrypt_later )
+{
+   const size_t LEFTOVER = 16 - sizeof( message_header );
+
+   char buffer[16];
+   sock.read( buffer, sizeof( buffer ) );
+
+   received_message m;
+   memcpy( (char*)&static_cast< message_header& >( m ), buffer, sizeof( message_header ) );
+   size_t remaining_bytes_with_padding = 16 * ( ( m.size - LEFTOVER + 15 ) / 16 );
+   m.data.resize( LEFTOVER + remaining_bytes_with_padding );
+   std::copy( buffer + sizeof( message_header ), buffer + sizeof( buffer ), m.data.begin() );
+
+   if( decrypt_later )
+      sock.read_encrypted( remaining_bytes_with_padding ).decrypt( &m.data[ LEFTOVER ] );
+   else
+      sock.read( &m.data[ LEFTOVER ], remaining_bytes_with_padding );
+
+   m.data.resize( m.size );
+   m.decode();
+   return m;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( p2p_tests )
+
+BOOST_AUTO_TEST_CASE( stcp_write_gather_matches_writesome )
+{
+   try
+   {
+      // Segment sizes are chosen so cipher blocks straddle two, three and many segments
+      const std::vector< std::vector< size_t > > layouts = {
+         { 16 },
+         { 5, 11 },
+         { 1, 30, 1 },
+         { 7, 9, 33, 15 },
+         { 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+         { 100, 3, 13, 200, 4 },
+         { 17, 1000, 23 },
+         { 0, 48, 0, 0, 16 }
+      };
+
+      for( size_t buffer_size : { size_t( 32 ), size_t( 48 ), size_t( GRAPHENE_NET_DEFAULT_SOCKET_BUFFER_SIZE ) } )
+      {
+         BOOST_TEST_MESSAGE( "--- Testing buffer size " << buffer_size );
+
+         stcp_socket_pair pair;
+         pair.sender.set_buffer_size( buffer_size );
+
+         // Each layout is sent with write_gather and then again with sequential writesome calls.
+         // Both continue the same cipher block chain, so each is checked against a reference
+         // encoder that follows that chain over the contiguous plaintext.
+         fc::aes_encoder reference;
+         pair.init_sender_encoder( reference );
+
+         uint32_t seed = 0;
+         for( const auto& layout : layouts )
+         {
+            size_t total = 0;
+            for( size_t s : layout )
+               total += s;
+            BOOST_REQUIRE( total % 16 == 0 );
+
+            std::vector< char > plaintext = random_bytes( total, ++seed );
+            std::vector< stcp_socket::write_segment > segments;
+            size_t offset = 0;
+            for( size_t s : layout )
+            {
+               segments.push_back( stcp_socket::write_segment{ plaintext.data() + offset, s } );
+               offset += s;
+            }
+
+            pair.sender.write_gather( segments.data(), segments.size() );
+            for( size_t written = 0; written < total; )
+               written += pair.sender.writesome( plaintext.data() + written, total - written );
+
+            std::vector< char > gathered = pair.read_ciphertext( total );
+            std::vector< char > sequential = pair.read_ciphertext( total );
+
+            std::vector< char > expected( total );
+            reference.encode( plaintext.data(), total, expected.data() );
+            BOOST_REQUIRE( gathered == expected );
+
+            reference.encode( plaintext.data(), total, expected.data() );
+            BOOST_REQUIRE( sequential == expected );
+         }
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( stcp_read_encrypted_continues_chain )
+{
+   try
+   {
+      stcp_socket_pair pair;
+      pair.receiver.set_buffer_size( 64 );
+
+      // Encrypted reads of several sizes, each followed by ordinary reads that must pick up the
+      // cipher block chain where the encrypted span left it
+      const std::vector< std::pair< size_t, size_t > > spans = {
+         { 16, 16 }, { 16, 48 }, { 32, 4096 }, { 48, 16 }, { 64, 80 }, { 16, 1040 }
+      };
+
+      size_t total = 0;
+      for( const auto& s : spans )
+         total += s.first + s.second;
+
+      std::vector< char > plaintext = random_bytes( total, 7 );
+      pair.sender.write( plaintext.data(), plaintext.size() );
+
+      std::vector< char > received( total );
+      std::vector< std::pair< size_t, stcp_socket::encrypted_data > > encrypted;
+      size_t offset = 0;
+      for( const auto& s : spans )
+      {
+         pair.receiver.read( &received[ offset ], s.first );
+         offset += s.first;
+         encrypted.emplace_back( offset, pair.receiver.read_encrypted( s.second ) );
+         offset += s.second;
+      }
+
+      // A trailing ordinary read after the last encrypted span
+      std::vector< char > tail = random_bytes( 32, 8 );
+      pair.sender.write( tail.data(), tail.size() );
+      std::vector< char > received_tail( tail.size() );
+      pair.receiver.read( received_tail.data(), received_tail.size() );
+      BOOST_REQUIRE( received_tail == tail );
+
+      // The spans are decrypted after every later read, in reverse, as decode threads may finish
+      for( auto itr = encrypted.rbegin(); itr != encrypted.rend(); ++itr )
+         itr->second.decrypt( &received[ itr->first ] );
+
+      BOOST_REQUIRE( received == plaintext );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( received_message_decode_matches_unpack )
+{
+   try
+   {
+      signed_block block = make_block( 20 );
+      signed_transaction trx = block.transactions[3];
+
+      message block_msg = block_message( block );
+      message trx_msg = trx_message( trx );
+      message other_msg = item_ids_inventory_message( block_message_type, { block.id() } );
+      BOOST_REQUIRE( block_msg.size >= GRAPHENE_NET_MIN_DECODE_THREAD_MESSAGE_SIZE );
+
+      auto check = [&]( const received_message& r, const message& m )
+      {
+         BOOST_REQUIRE( r.msg_type == m.msg_type );
+         BOOST_REQUIRE( r.data == m.data );
+         BOOST_REQUIRE( r.hash == m.id() );
+
+         if( m.msg_type == block_message_type )
+         {
+            BOOST_REQUIRE( r.block );
+            BOOST_REQUIRE( !r.trx );
+            BOOST_REQUIRE( r.block->block_id == block.id() );
+            BOOST_REQUIRE( fc::raw::pack_to_vector( *r.block ) == fc::raw::pack_to_vector( m.as< block_message >() ) );
+         }
+         else if( m.msg_type == trx_message_type )
+         {
+            BOOST_REQUIRE( r.trx );
+            BOOST_REQUIRE( !r.block );
+            BOOST_REQUIRE( r.trx->trx.id() == trx.id() );
+            BOOST_REQUIRE( fc::raw::pack_to_vector( *r.trx ) == fc::raw::pack_to_vector( m.as< trx_message >() ) );
+         }
+         else
+         {
+            BOOST_REQUIRE( !r.block );
+            BOOST_REQUIRE( !r.trx );
+         }
+      };
+
+      BOOST_TEST_MESSAGE( "--- Test decoding over the wire, decrypted as read and decrypted later" );
+      stcp_socket_pair pair;
+      for( const message* m : { &block_msg, &trx_msg, &other_msg } )
+      {
+         send_message( pair.sender, *m );
+         send_message( pair.sender, *m );
+         received_message read_path = receive_message( pair.receiver, false );
+         received_message decode_path = receive_message( pair.receiver, true );
+         check( read_path, *m );
+         check( decode_path, *m );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test a reused message drops what it decoded before" );
+      received_message reused;
+      auto load = [&]( const message& m )
+      {
+         static_cast< message_header& >( reused ) = m;
+         reused.data = m.data;
+      };
+      load( block_msg );
+      reused.decode();
+      check( reused, block_msg );
+      load( trx_msg );
+      reused.decode();
+      check( reused, trx_msg );
+      load( other_msg );
+      reused.decode();
+      check( reused, other_msg );
+
+      BOOST_TEST_MESSAGE( "--- Test a block that fails to unpack is left to the node" );
+      message truncated = block_msg;
+      truncated.data.resize( truncated.data.size() / 2 );
+      truncated.size = truncated.data.size();
+      BOOST_REQUIRE_THROW( truncated.as< block_message >(), fc::exception );
+      load( truncated );
+      reused.decode();
+      BOOST_REQUIRE( !reused.block );
+      BOOST_REQUIRE( reused.hash == truncated.id() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( rolling_inventory_filter_rotation )
+{
+   try
+   {
+      const uint32_t per_generation = 1000;
+      rolling_inventory_filter filter( per_generation, 0.001, fc::hours( 1 ) );
+
+      auto count_contained = [&]( uint32_t begin, uint32_t end )
+      {
+         uint32_t found = 0;
+         for( uint32_t i = begin; i < end; ++i )
+            found += filter.contains( make_item( trx_message_type, i ) );
+         return found;
+      };
+
+      BOOST_TEST_MESSAGE( "--- Test a full generation is remembered" );
+      for( uint32_t i = 0; i < per_generation; ++i )
+         filter.insert( make_item( trx_message_type, i ) );
+      BOOST_REQUIRE_EQUAL( filter.size(), per_generation );
+      BOOST_REQUIRE_EQUAL( count_contained( 0, per_generation ), per_generation );
+
+      BOOST_TEST_MESSAGE( "--- Test the previous generation is kept while the next one fills" );
+      for( uint32_t i = per_generation; i < 2 * per_generation; ++i )
+         filter.insert( make_item( trx_message_type, i ) );
+      BOOST_REQUIRE_EQUAL( filter.size(), 2 * per_generation );
+      BOOST_REQUIRE_EQUAL( count_contained( 0, 2 * per_generation ), 2 * per_generation );
+
+      BOOST_TEST_MESSAGE( "--- Test the oldest generation is dropped once the current one is full" );
+      filter.insert( make_item( trx_message_type, 2 * per_generation ) );
+      BOOST_REQUIRE_EQUAL( filter.size(), per_generation + 1 );
+      BOOST_REQUIRE_EQUAL( count_contained( per_generation, 2 * per_generation + 1 ), per_generation + 1 );
+      BOOST_REQUIRE_LE( count_contained( 0, per_generation ), 10u );
+
+      BOOST_TEST_MESSAGE( "--- Test a young generation is not expired" );
+      filter.expire_old_generation();
+      BOOST_REQUIRE_EQUAL( filter.size(), per_generation + 1 );
+      BOOST_REQUIRE_EQUAL( count_contained( per_generation, 2 * per_generation + 1 ), per_generation + 1 );
+
+      BOOST_TEST_MESSAGE( "--- Test expired generations are dropped one at a time" );
+      rolling_inventory_filter expiring( per_generation, 0.001, fc::microseconds( 0 ) );
+      item_id item = make_item( block_message_type, 1 );
+      expiring.insert( item );
+      expiring.expire_old_generation();
+      BOOST_REQUIRE( expiring.contains( item ) );
+      expiring.expire_old_generation();
+      BOOST_REQUIRE( !expiring.contains( item ) );
+      BOOST_REQUIRE_EQUAL( expiring.size(), 0u );
+
+      BOOST_TEST_MESSAGE( "--- Test the item type is part of the key" );
+      expiring.insert( item );
+      BOOST_REQUIRE( !expiring.contains( item_id( trx_message_type, item.item_hash ) ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( rolling_inventory_filter_false_positive_rate )
+{
+   try
+   {
+      const uint32_t per_generation = 10000;
+      const double false_positive_rate = 0.001;
+      rolling_inventory_filter filter( per_generation, false_positive_rate, fc::hours( 1 ) );
+
+      // Fill both generations, the worst case for contains()
+      for( uint32_t i = 0; i < 2 * per_generation; ++i )
+         filter.insert( make_item( trx_message_type, i ) );
+      BOOST_REQUIRE_EQUAL( filter.size(), 2 * per_generation );
+
+      const uint32_t queries = 100000;
+      uint32_t false_positives = 0;
+      for( uint32_t i = 0; i < queries; ++i )
+         false_positives += filter.contains( make_item( trx_message_type, 1000000 + i ) );
+
+      // Either generation may answer, so the bound is twice the rate of one filter, with room for variance
+      BOOST_TEST_MESSAGE( "false positives: " << false_positives << " of " << queries );
+      BOOST_REQUIRE_LE( false_positives, uint32_t( 2 * 2 * false_positive_rate * queries ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( token_bucket_rate )
+{
+   try
+   {
+      fc::time_point start = fc::time_point::now();
+      token_bucket bucket( 10, 3, start );
+
+      BOOST_TEST_MESSAGE( "--- Test the bucket starts with a full burst" );
+      BOOST_REQUIRE_EQUAL( bucket.available_tokens( start ), 30u );
+
+      BOOST_TEST_MESSAGE( "--- Test exhaustion" );
+      for( uint32_t i = 0; i < 30; ++i )
+         BOOST_REQUIRE( bucket.try_consume( start ) );
+      BOOST_REQUIRE( !bucket.try_consume( start ) );
+      BOOST_REQUIRE_EQUAL( bucket.available_tokens( start ), 0u );
+
+      BOOST_TEST_MESSAGE( "--- Test refill at the configured rate" );
+      BOOST_REQUIRE( !bucket.try_consume( start + fc::milliseconds( 99 ) ) );
+      BOOST_REQUIRE( bucket.try_consume( start + fc::milliseconds( 100 ) ) );
+      BOOST_REQUIRE( !bucket.try_consume( start + fc::milliseconds( 100 ) ) );
+      // partial tokens carry over, 0.45 s after the last full token holds 4.5 tokens
+      BOOST_REQUIRE_EQUAL( bucket.available_tokens( start + fc::milliseconds( 550 ) ), 4u );
+      BOOST_REQUIRE_EQUAL( bucket.available_tokens( start + fc::milliseconds( 600 ) ), 5u );
+
+      BOOST_TEST_MESSAGE( "--- Test time going backwards adds nothing" );
+      BOOST_REQUIRE_EQUAL( bucket.available_tokens( start ), 5u );
+      BOOST_REQUIRE_EQUAL( bucket.available_tokens( start + fc::milliseconds( 600 ) ), 5u );
+
+      BOOST_TEST_MESSAGE( "--- Test the burst cap after a long idle period" );
+      fc::time_point later = start + fc::days( 365 );
+      BOOST_REQUIRE_EQUAL( bucket.available_tokens( later ), 30u );
+      for( uint32_t i = 0; i < 30; ++i )
+         BOOST_REQUIRE( bucket.try_consume( later ) );
+      BOOST_REQUIRE( !bucket.try_consume( later ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( per_peer_transaction_limits )
+{
+   try
+   {
+      peer_connection_ptr flooding = peer_connection::make_shared( nullptr );
+      peer_connection_ptr quiet = peer_connection::make_shared( nullptr );
+      fc::time_point now = fc::time_point::now();
+
+      const uint32_t burst = GRAPHENE_NET_MAX_TRX_PER_SECOND_PER_PEER * GRAPHENE_NET_TRX_BURST_SECONDS;
+      const uint32_t rejected_burst = GRAPHENE_NET_MAX_REJECTED_TRX_PER_SECOND_PER_PEER * GRAPHENE_NET_REJECTED_TRX_BURST_SECONDS;
+
+      BOOST_TEST_MESSAGE( "--- Test a peer may send one burst of transactions" );
+      for( uint32_t i = 0; i < burst; ++i )
+         BOOST_REQUIRE( flooding->transaction_tokens.try_consume( now ) );
+      BOOST_REQUIRE( !flooding->transaction_tokens.try_consume( now ) );
+
+      BOOST_TEST_MESSAGE( "--- Test the limit is kept for each peer" );
+      BOOST_REQUIRE_EQUAL( quiet->transaction_tokens.available_tokens( now ), burst );
+      BOOST_REQUIRE( quiet->transaction_tokens.try_consume( now ) );
+
+      BOOST_TEST_MESSAGE( "--- Test the peer regains its per second share" );
+      BOOST_REQUIRE_EQUAL( flooding->transaction_tokens.available_tokens( now + fc::seconds( 1 ) ),
+                           uint32_t( GRAPHENE_NET_MAX_TRX_PER_SECOND_PER_PEER ) );
+
+      BOOST_TEST_MESSAGE( "--- Test rejected transactions are counted separately" );
+      BOOST_REQUIRE_EQUAL( flooding->rejected_transaction_tokens.available_tokens( now ), rejected_burst );
+      for( uint32_t i = 0; i < rejected_burst; ++i )
+         BOOST_REQUIRE( flooding->rejected_transaction_tokens.try_consume( now ) );
+      BOOST_REQUIRE( !flooding->rejected_transaction_tokens.try_consume( now ) );
+      BOOST_REQUIRE_EQUAL( quiet->rejected_transaction_tokens.available_tokens( now ), rejected_burst );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( compact_block_reconstruction )
+{
+   try
+   {
+      signed_block block = make_block( 10 );
+      compact_block_message compact( block, block.id() );
+      BOOST_REQUIRE_EQUAL( compact.short_transaction_ids.size(), block.transactions.size() );
+
+      BOOST_TEST_MESSAGE( "--- Test a block whose transactions are all known is rebuilt exactly" );
+      short_id_lookup known;
+      for( const auto& trx : block.transactions )
+         known.add( trx );
+
+      peer_connection::partially_received_block partial( compact, known.function() );
+      BOOST_REQUIRE( partial.missing_transaction_indexes.empty() );
+      BOOST_REQUIRE( !partial.has_short_id_collision() );
+      BOOST_REQUIRE( partial.block_id == block.id() );
+      BOOST_REQUIRE( partial.block.id() == block.id() );
+      BOOST_REQUIRE( fc::raw::pack_to_vector( block_message( partial.block ) ) == fc::raw::pack_to_vector( block_message( block ) ) );
+
+      BOOST_TEST_MESSAGE( "--- Test a block without transactions needs nothing" );
+      signed_block empty = make_block( 0, 1 );
+      peer_connection::partially_received_block empty_partial( compact_block_message( empty, empty.id() ), short_id_lookup().function() );
+      BOOST_REQUIRE( empty_partial.missing_transaction_indexes.empty() );
+      BOOST_REQUIRE( !empty_partial.has_short_id_collision() );
+      BOOST_REQUIRE( empty_partial.block.id() == empty.id() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( compact_block_missing_transactions )
+{
+   try
+   {
+      signed_block block = make_block( 10 );
+      compact_block_message compact( block, block.id() );
+
+      short_id_lookup known;
+      for( size_t i = 0; i < block.transactions.size(); ++i )
+         if( i % 3 != 0 )
+            known.add( block.transactions[i] );
+
+      peer_connection::partially_received_block partial( compact, known.function() );
+      BOOST_REQUIRE( partial.missing_transaction_indexes == std::vector< uint32_t >( { 0, 3, 6, 9 } ) );
+
+      BOOST_TEST_MESSAGE( "--- Test the sender answers with the transactions at the asked indexes" );
+      get_block_transactions_message request;
+      request.block_id = partial.block_id;
+      request.transaction_indexes = partial.missing_transaction_indexes;
+      message request_message( request );
+      get_block_transactions_message received_request = request_message.as< get_block_transactions_message >();
+
+      block_transactions_message reply;
+      reply.block_id = received_request.block_id;
+      for( uint32_t index : received_request.transaction_indexes )
+         reply.transactions.push_back( block.transactions[ index ] );
+      message reply_message( reply );
+      block_transactions_message received_reply = reply_message.as< block_transactions_message >();
+      BOOST_REQUIRE( received_reply.block_id == block.id() );
+
+      BOOST_TEST_MESSAGE( "--- Test a reply of the wrong size is refused" );
+      peer_connection::partially_received_block short_reply = partial;
+      std::vector< signed_transaction > too_few( received_reply.transactions.begin(), received_reply.transactions.end() - 1 );
+      BOOST_REQUIRE( !short_reply.add_missing_transactions( too_few ) );
+      BOOST_REQUIRE_EQUAL( short_reply.missing_transaction_indexes.size(), 4u );
+
+      BOOST_TEST_MESSAGE( "--- Test the reply completes the block" );
+      BOOST_REQUIRE( partial.add_missing_transactions( received_reply.transactions ) );
+      BOOST_REQUIRE( partial.missing_transaction_indexes.empty() );
+      BOOST_REQUIRE( !partial.has_short_id_collision() );
+      BOOST_REQUIRE( partial.block.id() == block.id() );
+      BOOST_REQUIRE( message( block_message( partial.block ) ).id() == message( block_message( block ) ).id() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( compact_block_short_id_collision )
+{
+   try
+   {
+      signed_block block = make_block( 5 );
+      signed_block other = make_block( 5, 1 );
+      compact_block_message compact( block, block.id() );
+
+      // the cached transaction under the short id of block.transactions[2] is a different one
+      short_id_lookup known;
+      for( const auto& trx : block.transactions )
+         known.add( trx );
+      known.transactions[ get_short_transaction_id( block.transactions[2].id() ) ] = other.transactions[2];
+
+      peer_connection::partially_received_block partial( compact, known.function() );
+      BOOST_REQUIRE( partial.missing_transaction_indexes.empty() );
+      BOOST_REQUIRE( partial.has_short_id_collision() );
+
+      BOOST_TEST_MESSAGE( "--- Test every transaction is asked for again" );
+      partial.mark_all_transactions_missing();
+      BOOST_REQUIRE( partial.missing_transaction_indexes == std::vector< uint32_t >( { 0, 1, 2, 3, 4 } ) );
+      BOOST_REQUIRE( partial.add_missing_transactions( block.transactions ) );
+      BOOST_REQUIRE( !partial.has_short_id_collision() );
+      BOOST_REQUIRE( partial.block.id() == block.id() );
+      BOOST_REQUIRE( partial.block.calculate_merkle_root() == block.transaction_merkle_root );
+
+      BOOST_TEST_MESSAGE( "--- Test a bad block sent in full is not retried" );
+      partial.mark_all_transactions_missing();
+      std::vector< signed_transaction > wrong = block.transactions;
+      wrong[2] = other.transactions[2];
+      BOOST_REQUIRE( partial.add_missing_transactions( wrong ) );
+      BOOST_REQUIRE( !partial.has_short_id_collision() );
+      BOOST_REQUIRE( partial.block.calculate_merkle_root() != block.transaction_merkle_root );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_journal_replay )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+      fc::path filename = dir.path() / "peers.dat";
+      {
+         peer_database db;
+         db.open( filename );
+         uint64_t empty_size = fc::file_size( filename );
+
+         for( uint32_t i = 0; i < 10; ++i )
+            db.update_entry( make_peer_record( i ) );
+         potential_peer_record changed = make_peer_record( 3 );
+         changed.number_of_failed_connection_attempts = 7;
+         db.update_entry( changed );
+         db.erase( make_peer_record( 5 ).endpoint );
+
+         BOOST_TEST_MESSAGE( "--- Test changes wait for a flush" );
+         BOOST_REQUIRE_EQUAL( fc::file_size( filename ), empty_size );
+         db.flush();
+         BOOST_REQUIRE_GT( fc::file_size( filename ), empty_size );
+
+         // dropped without close(), like a node that did not shut down cleanly
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test the journal replays every flushed change" );
+      peer_database db;
+      db.open( filename );
+      BOOST_REQUIRE_EQUAL( db.size(), 9u );
+      BOOST_REQUIRE( !db.lookup_entry_for_endpoint( make_peer_record( 5 ).endpoint ) );
+      fc::optional< potential_peer_record > record = db.lookup_entry_for_endpoint( make_peer_record( 3 ).endpoint );
+      BOOST_REQUIRE( record );
+      BOOST_REQUIRE_EQUAL( record->number_of_failed_connection_attempts, 7u );
+      record = db.lookup_entry_for_endpoint( make_peer_record( 9 ).endpoint );
+      BOOST_REQUIRE( record );
+      BOOST_REQUIRE_EQUAL( record->number_of_successful_connection_attempts, 9u );
+      db.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_damaged_journal )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+      fc::path filename = dir.path() / "peers.dat";
+      {
+         peer_database db;
+         db.open( filename );
+         for( uint32_t i = 0; i < 5; ++i )
+            db.update_entry( make_peer_record( i ) );
+         db.flush();
+         db.update_entry( make_peer_record( 5 ) );
+         db.flush();
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test a truncated last entry is dropped" );
+      fc::resize_file( filename, fc::file_size( filename ) - 1 );
+      {
+         peer_database db;
+         db.open( filename );
+         BOOST_REQUIRE_EQUAL( db.size(), 5u );
+         BOOST_REQUIRE( db.lookup_entry_for_endpoint( make_peer_record( 4 ).endpoint ) );
+         BOOST_REQUIRE( !db.lookup_entry_for_endpoint( make_peer_record( 5 ).endpoint ) );
+         db.close();
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test a corrupt tail is dropped" );
+      {
+         // an update entry claiming far more bytes than the file holds
+         const char garbage[] = { 0x00, char( 0xff ), char( 0xff ), char( 0xff ), char( 0xff ), 0x0f, 0x01, 0x02 };
+         std::ofstream journal( filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app );
+         journal.write( garbage, sizeof( garbage ) );
+      }
+      {
+         peer_database db;
+         db.open( filename );
+         BOOST_REQUIRE_EQUAL( db.size(), 5u );
+         db.close();
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test a file that is not a peer database starts clean" );
+      {
+         std::ofstream journal( filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+         journal << "not a peer database";
+      }
+      {
+         peer_database db;
+         db.open( filename );
+         BOOST_REQUIRE_EQUAL( db.size(), 0u );
+         db.update_entry( make_peer_record( 1 ) );
+         db.close();
+      }
+      peer_database db;
+      db.open( filename );
+      BOOST_REQUIRE_EQUAL( db.size(), 1u );
+      db.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_compaction )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+      fc::path filename = dir.path() / "peers.dat";
+      const uint32_t compaction_entries = GRAPHENE_NET_PEERDB_JOURNAL_COMPACTION_FACTOR * GRAPHENE_NET_MAX_PEERDB_SIZE;
+      {
+         peer_database db;
+         db.open( filename );
+
+         potential_peer_record record = make_peer_record( 1 );
+         uint64_t largest_size = 0;
+         bool compacted = false;
+         for( uint32_t i = 0; i < compaction_entries + 10; ++i )
+         {
+            record.number_of_successful_connection_attempts = i;
+            db.update_entry( record );
+            db.flush();
+
+            uint64_t size = fc::file_size( filename );
+            compacted = compacted || size < largest_size;
+            largest_size = std::max( largest_size, size );
+         }
+
+         BOOST_TEST_MESSAGE( "--- Test the journal is rewritten once it outgrows the database" );
+         BOOST_REQUIRE( compacted );
+         BOOST_REQUIRE_LT( fc::file_size( filename ), largest_size / 100 );
+      }
+
+      peer_database db;
+      db.open( filename );
+      BOOST_REQUIRE_EQUAL( db.size(), 1u );
+      BOOST_REQUIRE_EQUAL( db.begin()->number_of_successful_connection_attempts, compaction_entries + 9 );
+      db.close();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_json_import )
+{
+   try
+   {
+      fc::temp_directory dir( steem::utilities::temp_directory_path() );
+      fc::path filename = dir.path() / "peers.dat";
+      fc::path json_filename = dir.path() / "peers.json";
+
+      std::vector< potential_peer_record > records;
+      for( uint32_t i = 0; i < 3; ++i )
+         records.push_back( make_peer_record( i ) );
+      fc::json::save_to_file( records, json_filename );
+
+      {
+         peer_database db;
+         db.open( filename );
+         BOOST_REQUIRE_EQUAL( db.size(), 0u );
+         db.import_json( json_filename );
+         BOOST_REQUIRE_EQUAL( db.size(), 3u );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test imported peers are saved right away, so the node imports only once" );
+      {
+         peer_database db;
+         db.open( filename );
+         BOOST_REQUIRE_EQUAL( db.size(), 3u );
+         fc::optional< potential_peer_record > record = db.lookup_entry_for_endpoint( records[2].endpoint );
+         BOOST_REQUIRE( record );
+         BOOST_REQUIRE( record->last_seen_time == records[2].last_seen_time );
+
+         BOOST_TEST_MESSAGE( "--- Test a broken json file changes nothing" );
+         {
+            std::ofstream json( json_filename.generic_string().c_str(), std::ios::out | std::ios::trunc );
+            json << "[{\"endpoint\":";
+         }
+         db.import_json( json_filename );
+         BOOST_REQUIRE_EQUAL( db.size(), 3u );
+         db.close();
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
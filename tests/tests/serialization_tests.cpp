@@ -89,6 +89,80 @@ BOOST_AUTO_TEST_CASE( serialization_raw_test )
       throw;
    }
 }
+BOOST_AUTO_TEST_CASE( raw_fast_path_test )
+{
+   try {
+      BOOST_TEST_MESSAGE( "Testing varint encoding" );
+      auto check_varint = []( uint32_t value, const std::vector< char >& expected )
+      {
+         auto packed = fc::raw::pack_to_vector( fc::unsigned_int( value ) );
+         BOOST_REQUIRE( packed == expected );
+         BOOST_REQUIRE( fc::raw::pack_size( fc::unsigned_int( value ) ) == expected.size() );
+         BOOST_REQUIRE( fc::raw::unpack_from_vector< fc::unsigned_int >( packed ).value == value );
+      };
+
+      check_varint( 0, { 0x00 } );
+      check_varint( 127, { 0x7f } );
+      check_varint( 128, { char(0x80), 0x01 } );
+      check_varint( 16383, { char(0xff), 0x7f } );
+      check_varint( 16384, { char(0x80), char(0x80), 0x01 } );
+      check_varint( std::numeric_limits< uint32_t >::max(), { char(0xff), char(0xff), char(0xff), char(0xff), 0x0f } );
+
+      for( int32_t v : { 0, 1, -1, 63, -64, 64, -65, 1000000, -1000000 } )
+         BOOST_REQUIRE( fc::raw::unpack_from_vector< fc::signed_int >( fc::raw::pack_to_vector( fc::signed_int( v ) ) ).value == v );
+
+      BOOST_TEST_MESSAGE( "Testing truncated varint" );
+      std::vector< char > truncated = { char(0x80), char(0x80) };
+      STEEM_REQUIRE_THROW( fc::raw::unpack_from_vector< fc::unsigned_int >( truncated ), fc::exception );
+
+      BOOST_TEST_MESSAGE( "Testing bulk packing of trivially packable vectors" );
+      std::vector< block_id_type > ids;
+      std::vector< signature_type > sigs;
+      std::vector< uint32_t > nums;
+      for( uint32_t i = 0; i < 300; ++i )
+      {
+         ids.push_back( block_id_type::hash( fc::to_string( i ) ) );
+         signature_type sig;
+         for( size_t j = 0; j < sig.size(); ++j )
+            sig.data[j] = uint8_t( i + j );
+         sigs.push_back( sig );
+         nums.push_back( i * 2654435761u );
+      }
+
+      auto check_vector = []( const auto& v )
+      {
+         typedef typename std::decay< decltype( v ) >::type vector_type;
+
+         // Reference encoding, element by element
+         std::vector< char > expected = fc::raw::pack_to_vector( fc::unsigned_int( v.size() ) );
+         for( const auto& e : v )
+         {
+            auto packed_element = fc::raw::pack_to_vector( e );
+            expected.insert( expected.end(), packed_element.begin(), packed_element.end() );
+         }
+
+         BOOST_REQUIRE( fc::raw::pack_to_vector( v ) == expected );
+         BOOST_REQUIRE( fc::raw::pack_size( v ) == expected.size() );
+         BOOST_REQUIRE( fc::raw::unpack_from_vector< vector_type >( expected ) == v );
+
+         expected.pop_back();
+         STEEM_REQUIRE_THROW( fc::raw::unpack_from_vector< vector_type >( expected ), fc::exception );
+      };
+
+      check_vector( ids );
+      check_vector( sigs );
+      check_vector( nums );
+      check_vector( std::vector< uint32_t >() );
+
+      BOOST_TEST_MESSAGE( "Testing string unpacking" );
+      for( const std::string& str : { std::string(), std::string( "a" ), std::string( 300, 'x' ) } )
+         BOOST_REQUIRE( fc::raw::unpack_from_vector< std::string >( fc::raw::pack_to_vector( str ) ) == str );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( serialization_json_test )
 {
    try {